@@ -0,0 +1,71 @@
+#include "corpus.h"
+
+#include "corpus/corpusgenerator.h"
+
+#include <algorithm>
+
+namespace Bench
+{
+    namespace
+    {
+        using Block = Tools::CorpusGenerator::Block;
+
+        Corpus makeCorpus(const std::string& name, const Tools::CorpusGenerator::Settings& settings, const std::vector<Block>& blocks)
+        {
+            Corpus corpus;
+            corpus.name = name;
+            corpus.source = Tools::CorpusGenerator::generate(settings, blocks);
+            corpus.lines = countLines(corpus.source);
+            return corpus;
+        }
+
+        Tools::CorpusGenerator::Settings makeSettings(size_t size, unsigned int seed)
+        {
+            Tools::CorpusGenerator::Settings settings;
+            settings.size = size;
+            settings.seed = seed;
+            return settings;
+        }
+    }
+
+    std::vector<Corpus> makeCorpora(size_t size, unsigned int seed)
+    {
+        Tools::CorpusGenerator::Settings settings = makeSettings(size, seed);
+
+        // Links are measured on paragraphs with most of the words linked
+        Tools::CorpusGenerator::Settings links = settings;
+        links.markerDensity = 0.5;
+        links.referenceCount = 20;
+
+        std::vector<Corpus> result;
+        result.push_back(makeCorpus("prose", settings, { Block::Heading, Block::Paragraph }));
+        result.push_back(makeCorpus("lists", settings, { Block::List }));
+        result.push_back(makeCorpus("tables", settings, { Block::Table }));
+        result.push_back(makeCorpus("code", settings, { Block::Code }));
+        result.push_back(makeCorpus("links", links, { Block::Paragraph }));
+        return result;
+    }
+
+    std::vector<Corpus> makeElementCorpora(size_t size, unsigned int seed)
+    {
+        Tools::CorpusGenerator::Settings settings = makeSettings(size, seed);
+
+        std::vector<Corpus> result;
+        result.push_back(makeCorpus("paragraph", settings, { Block::Paragraph }));
+        result.push_back(makeCorpus("heading", settings, { Block::Heading }));
+        result.push_back(makeCorpus("blockquote", settings, { Block::Blockquote }));
+        result.push_back(makeCorpus("list", settings, { Block::List }));
+        result.push_back(makeCorpus("code", settings, { Block::Code }));
+        result.push_back(makeCorpus("line", settings, { Block::Line }));
+        result.push_back(makeCorpus("reference", settings, { Block::Reference }));
+        result.push_back(makeCorpus("table", settings, { Block::Table }));
+        return result;
+    }
+
+    size_t countLines(const std::string& source)
+    {
+        if (source.empty())
+            return 0;
+        return std::count(source.begin(), source.end(), '\n') + 1;
+    }
+}
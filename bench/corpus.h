@@ -0,0 +1,26 @@
+#ifndef _h_cppmarkdownbenchcorpus
+#define _h_cppmarkdownbenchcorpus
+
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+    struct Corpus
+    {
+        std::string name;
+        std::string source;
+        size_t lines = 0;
+    };
+
+    // Documents of a given shape - prose, lists, tables, code and links - of roughly size bytes each
+    // Generated from the seed, so the same arguments always give the same corpora
+    std::vector<Corpus> makeCorpora(size_t size, unsigned int seed);
+
+    // Documents built of a single element type, measuring the parse path of that element
+    std::vector<Corpus> makeElementCorpora(size_t size, unsigned int seed);
+
+    size_t countLines(const std::string& source);
+}
+
+#endif
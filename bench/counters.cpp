@@ -0,0 +1,201 @@
+#include "counters.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Bench
+{
+    namespace
+    {
+#ifdef __linux__
+        struct EventConfig
+        {
+            uint32_t type;
+            uint64_t config;
+        };
+
+        EventConfig getConfig(Counters::Event event)
+        {
+            auto readMisses = [](uint64_t cache) -> uint64_t {
+                return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            };
+
+            switch (event)
+            {
+            case Counters::Cycles: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES };
+            case Counters::Instructions: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS };
+            case Counters::L1Misses: return { PERF_TYPE_HW_CACHE, readMisses(PERF_COUNT_HW_CACHE_L1D) };
+            case Counters::LlcMisses: return { PERF_TYPE_HW_CACHE, readMisses(PERF_COUNT_HW_CACHE_LL) };
+            default: return { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES };
+            }
+        }
+
+        // Events of a group are scheduled together, the leader starts disabled until the group is complete
+        int openEvent(const EventConfig& config, int leader)
+        {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = config.type;
+            attr.config = config.config;
+            attr.disabled = leader == -1 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0));
+        }
+#endif
+    }
+
+    // Values
+
+    Counters::Values& Counters::Values::operator+=(const Values& b)
+    {
+        this->seconds += b.seconds;
+        for (size_t i = 0; i < EventCount; i++)
+            this->events[i] += b.events[i];
+        return *this;
+    }
+
+    Counters::Values Counters::Values::operator-(const Values& b) const
+    {
+        Values result = *this;
+        result.seconds -= b.seconds;
+        for (size_t i = 0; i < EventCount; i++)
+            result.events[i] -= b.events[i];
+        return result;
+    }
+
+    Counters::Values Counters::Values::operator/(double divisor) const
+    {
+        Values result = *this;
+        result.seconds /= divisor;
+        for (size_t i = 0; i < EventCount; i++)
+            result.events[i] /= divisor;
+        return result;
+    }
+
+    // Counters
+
+    Counters::Counters()
+        : start(std::chrono::steady_clock::now())
+    {
+        this->descriptors.fill(-1);
+        this->positions.fill(0);
+
+#ifdef __linux__
+        for (size_t i = 0; i < EventCount; i++)
+        {
+            int descriptor = openEvent(getConfig(static_cast<Event>(i)), this->leader);
+            if (descriptor == -1)
+            {
+                if (this->error.empty())
+                    this->error = std::string("perf_event_open failed for ") + getName(static_cast<Event>(i)) + ": " + std::strerror(errno);
+                continue;
+            }
+
+            if (this->leader == -1)
+                this->leader = descriptor;
+
+            this->descriptors[i] = descriptor;
+            this->positions[i] = this->opened++;
+        }
+
+        if (this->leader != -1)
+        {
+            ioctl(this->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(this->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#else
+        this->error = "perf_event_open is only available on Linux";
+#endif
+    }
+
+    Counters::~Counters()
+    {
+#ifdef __linux__
+        for (int descriptor : this->descriptors)
+        {
+            if (descriptor != -1)
+                close(descriptor);
+        }
+#endif
+    }
+
+    bool Counters::available(Event event) const
+    {
+        return this->descriptors.at(event) != -1;
+    }
+
+    bool Counters::anyAvailable() const
+    {
+        return this->opened > 0;
+    }
+
+    const std::string& Counters::getError() const
+    {
+        return this->error;
+    }
+
+    Counters::Values Counters::read() const
+    {
+        Values values;
+        values.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - this->start).count();
+
+#ifdef __linux__
+        if (this->leader != -1)
+        {
+            // Count of the events, time enabled and running, then the value of every event
+            std::array<uint64_t, 3 + EventCount> buffer{};
+            if (::read(this->leader, buffer.data(), sizeof(buffer)) > 0)
+            {
+                // Group multiplexed with other events counted only part of the time, scale it to the whole time
+                double enabled = static_cast<double>(buffer[1]);
+                double running = static_cast<double>(buffer[2]);
+                double scale = running > 0.0 ? enabled / running : 0.0;
+
+                for (size_t i = 0; i < EventCount; i++)
+                {
+                    if (this->descriptors[i] != -1)
+                        values.events[i] = buffer[3 + this->positions[i]] * scale;
+                }
+            }
+        }
+#endif
+
+        return values;
+    }
+
+    const char* Counters::getName(Event event)
+    {
+        switch (event)
+        {
+        case Cycles: return "cycles";
+        case Instructions: return "instructions";
+        case L1Misses: return "l1Misses";
+        case LlcMisses: return "llcMisses";
+        case BranchMisses: return "branchMisses";
+        default: return "";
+        }
+    }
+
+    // Phase profiler
+
+    PhaseProfiler::PhaseProfiler(const Counters& counters)
+        : counters(counters)
+    {
+    }
+
+    Counters::Values PhaseProfiler::read() const
+    {
+        return this->counters.read();
+    }
+}
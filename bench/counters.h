@@ -0,0 +1,78 @@
+#ifndef _h_cppmarkdownbenchcounters
+#define _h_cppmarkdownbenchcounters
+
+#include "cppmarkdown/phaseobserver.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Bench
+{
+    // Hardware counters of the calling thread in user space, read with perf_event_open
+    // Events the system doesn't provide are skipped - in containers and virtual machines often all of them,
+    // leaving the time only
+    class Counters
+    {
+    public:
+        enum Event
+        {
+            Cycles,
+            Instructions,
+            L1Misses, // L1 data cache read misses
+            LlcMisses, // Last level cache read misses
+            BranchMisses,
+            EventCount
+        };
+
+        struct Values
+        {
+            double seconds = 0.0;
+            std::array<double, EventCount> events{};
+
+            Values& operator+=(const Values& b);
+            Values operator-(const Values& b) const;
+            Values operator/(double divisor) const;
+        };
+
+        Counters();
+        ~Counters();
+
+        Counters(const Counters&) = delete;
+        Counters& operator=(const Counters&) = delete;
+
+        bool available(Event event) const;
+        bool anyAvailable() const;
+        // Why the first unavailable event couldn't be opened
+        const std::string& getError() const;
+
+        // Time and counts since the counters were opened, counts of unavailable events are zero
+        Values read() const;
+
+        static const char* getName(Event event);
+
+    private:
+        std::chrono::steady_clock::time_point start;
+        int leader = -1;
+        std::array<int, EventCount> descriptors;
+        std::array<size_t, EventCount> positions; // Position of the event in the values of the group
+        size_t opened = 0;
+        std::string error;
+    };
+
+    // Attributes time and counters to the phase being run, a nested phase is excluded from its parent
+    class PhaseProfiler : public Markdown::PhaseAccumulator<Counters::Values>
+    {
+    public:
+        PhaseProfiler(const Counters& counters);
+
+    protected:
+        virtual Counters::Values read() const override;
+
+    private:
+        const Counters& counters;
+    };
+}
+
+#endif
@@ -0,0 +1,350 @@
+#include "corpus.h"
+#include "counters.h"
+#include "corpus/corpusgenerator.h"
+
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/textentry.h"
+#include "cppmarkdown/extensions.h"
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        size_t size = 1024 * 1024; // Bytes of every corpus
+        unsigned int seed = 1;
+        double minTime = 0.5; // Seconds every benchmark is repeated for
+        std::string filter;
+        std::string output;
+        std::vector<std::string> sweeps; // Knob of the corpus generator and its values, e.g. listDepth=1,2,4
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::string corpus;
+        size_t bytes = 0;
+        size_t lines = 0;
+        size_t iterations = 0;
+        double seconds = 0.0; // Per iteration
+        Bench::Counters::Values values; // Per iteration
+        std::vector<std::pair<Markdown::Phase, Bench::Counters::Values>> phases; // Per iteration, if profiled
+    };
+
+    // Prevents the measured calls from being optimized out
+    volatile size_t sink = 0;
+
+    class Runner
+    {
+    public:
+        Runner(const Options& options)
+            : options(options)
+            , profiler(counters)
+        {
+            if (!this->counters.anyAvailable())
+                std::cerr << "Hardware counters unavailable (" << this->counters.getError() << "), measuring time only\n";
+        }
+
+        // Run the benchmark repeatedly, setup runs before every iteration and isn't measured
+        // Profiled benchmark reports the time and counters of every phase, see PhaseObserver
+        void run(const std::string& name, const Bench::Corpus& corpus, const std::function<size_t()>& benchmark, const std::function<void()>& setup = nullptr, bool profile = false)
+        {
+            std::string fullName = name + "/" + corpus.name;
+            if (!this->options.filter.empty() && fullName.find(this->options.filter) == std::string::npos)
+                return;
+
+            Bench::Counters::Values total;
+
+            Result result;
+            result.name = name;
+            result.corpus = corpus.name;
+            result.bytes = corpus.source.size();
+            result.lines = corpus.lines;
+
+            this->profiler.reset();
+
+            do
+            {
+                if (setup)
+                    setup();
+
+                Bench::Counters::Values begin = this->counters.read();
+                if (profile)
+                {
+                    Markdown::Tracer::ContextGuard guard(this->profiler);
+                    sink = sink + benchmark();
+                }
+                else
+                    sink = sink + benchmark();
+                total += this->counters.read() - begin;
+
+                result.iterations++;
+            } while (total.seconds < this->options.minTime);
+
+            result.values = total / static_cast<double>(result.iterations);
+            result.seconds = result.values.seconds;
+
+            std::cerr << fullName << ": " << megabytesPerSecond(result) << " MB/s, " << nanosecondsPerLine(result) << " ns/line";
+            if (this->counters.available(Bench::Counters::Cycles) && this->counters.available(Bench::Counters::Instructions))
+                std::cerr << ", " << instructionsPerCycle(result.values) << " IPC";
+            std::cerr << "\n";
+
+            if (profile)
+            {
+                for (size_t i = 0; i < Bench::PhaseProfiler::PhaseCount; i++)
+                {
+                    auto phase = static_cast<Markdown::Phase>(i);
+                    Bench::Counters::Values values = this->profiler.getTotal(phase) / static_cast<double>(result.iterations);
+                    result.phases.emplace_back(phase, values);
+
+                    std::cerr << "  " << Markdown::getPhaseName(phase) << ": " << values.seconds * 1e3 << " ms";
+                    if (this->counters.available(Bench::Counters::Cycles) && this->counters.available(Bench::Counters::Instructions))
+                        std::cerr << ", " << instructionsPerCycle(values) << " IPC";
+                    std::cerr << "\n";
+                }
+            }
+
+            this->results.push_back(result);
+        }
+
+        void write(std::ostream& out) const
+        {
+            out << "{\n";
+            out << "  \"size\": " << this->options.size << ",\n";
+            out << "  \"seed\": " << this->options.seed << ",\n";
+            out << "  \"benchmarks\": [";
+            for (size_t i = 0; i < this->results.size(); i++)
+            {
+                const Result& result = this->results[i];
+                out << (i > 0 ? "," : "") << "\n    {"
+                    << "\"name\": \"" << result.name << "\", "
+                    << "\"corpus\": \"" << result.corpus << "\", "
+                    << "\"bytes\": " << result.bytes << ", "
+                    << "\"lines\": " << result.lines << ", "
+                    << "\"iterations\": " << result.iterations << ", "
+                    << "\"seconds\": " << result.seconds << ", "
+                    << "\"mbPerSecond\": " << megabytesPerSecond(result) << ", "
+                    << "\"nsPerLine\": " << nanosecondsPerLine(result);
+                this->writeCounters(out, result.values);
+
+                if (!result.phases.empty())
+                {
+                    out << ", \"phases\": [";
+                    for (size_t j = 0; j < result.phases.size(); j++)
+                    {
+                        const auto& phase = result.phases[j];
+                        out << (j > 0 ? ", " : "") << "{\"phase\": \"" << Markdown::getPhaseName(phase.first) << "\", "
+                            << "\"seconds\": " << phase.second.seconds;
+                        this->writeCounters(out, phase.second);
+                        out << "}";
+                    }
+                    out << "]";
+                }
+                out << "}";
+            }
+            out << "\n  ]\n}\n";
+        }
+
+    private:
+        const Options& options;
+        Bench::Counters counters;
+        Bench::PhaseProfiler profiler;
+        std::vector<Result> results;
+
+        // Counts of the available events, nothing if the counters are unavailable
+        void writeCounters(std::ostream& out, const Bench::Counters::Values& values) const
+        {
+            for (size_t i = 0; i < Bench::Counters::EventCount; i++)
+            {
+                auto event = static_cast<Bench::Counters::Event>(i);
+                if (this->counters.available(event))
+                    out << ", \"" << Bench::Counters::getName(event) << "\": " << values.events[i];
+            }
+        }
+
+        static double instructionsPerCycle(const Bench::Counters::Values& values)
+        {
+            double cycles = values.events[Bench::Counters::Cycles];
+            return cycles > 0.0 ? values.events[Bench::Counters::Instructions] / cycles : 0.0;
+        }
+
+        static double megabytesPerSecond(const Result& result)
+        {
+            return result.bytes / result.seconds / 1e6;
+        }
+
+        static double nanosecondsPerLine(const Result& result)
+        {
+            return result.lines ? result.seconds * 1e9 / result.lines : 0.0;
+        }
+    };
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string argument = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (argument == "--size" && hasValue)
+                options.size = std::stoul(argv[++i]) * 1024;
+            else if (argument == "--seed" && hasValue)
+                options.seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            else if (argument == "--min-time" && hasValue)
+                options.minTime = std::stod(argv[++i]);
+            else if (argument == "--filter" && hasValue)
+                options.filter = argv[++i];
+            else if (argument == "--output" && hasValue)
+                options.output = argv[++i];
+            else if (argument == "--sweep" && hasValue)
+                options.sweeps.push_back(argv[++i]);
+            else
+            {
+                std::cerr << "Usage: " << argv[0] << " [--size KiB] [--seed n] [--min-time seconds] [--filter name] [--output file.json] [--sweep knob=value,...]\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Corpora generated with every value of the knob, the remaining knobs keep their defaults
+    bool makeSweep(const std::string& sweep, const Options& options, std::vector<Bench::Corpus>& corpora)
+    {
+        size_t separator = sweep.find('=');
+        if (separator == std::string::npos)
+            return false;
+
+        std::string knob = sweep.substr(0, separator);
+        std::istringstream values(sweep.substr(separator + 1));
+        std::string value;
+        while (std::getline(values, value, ','))
+        {
+            Tools::CorpusGenerator::Settings settings;
+            settings.seed = options.seed;
+            settings.size = options.size;
+            if (!settings.set(knob, value))
+                return false;
+
+            Bench::Corpus corpus;
+            corpus.name = knob + "=" + value;
+            corpus.source = Tools::CorpusGenerator::generate(settings);
+            corpus.lines = Bench::countLines(corpus.source);
+            corpora.push_back(std::move(corpus));
+        }
+        return true;
+    }
+
+    std::vector<std::string> splitLines(const std::string& source)
+    {
+        std::vector<std::string> result;
+        std::istringstream stream(source);
+        std::string line;
+        while (std::getline(stream, line))
+            result.push_back(line);
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    Markdown::registerStandardExtensions();
+
+    Runner runner(options);
+
+    for (const Bench::Corpus& corpus : Bench::makeCorpora(options.size, options.seed))
+    {
+        runner.run("parse", corpus, [&corpus]() {
+            Markdown::Document document;
+            document.parse(corpus.source);
+            return document.elementsCount();
+        });
+
+        // Parsing and rendering split into the phases
+        runner.run("phases", corpus, [&corpus]() {
+            Markdown::Document document;
+            document.parse(corpus.source);
+            return document.getHtml().size();
+        }, nullptr, true);
+
+        Markdown::Document document;
+        document.parse(corpus.source);
+
+        // Rendered output is cached, every iteration renders the document from scratch
+        runner.run("getHtml", corpus, [&document]() {
+            return document.getHtml().size();
+        }, Markdown::RenderCache::invalidateAll);
+
+        runner.run("getText", corpus, [&document]() {
+            return document.getText().size();
+        }, Markdown::RenderCache::invalidateAll);
+
+        runner.run("getMarkdown", corpus, [&document]() {
+            size_t size = 0;
+            for (const auto& element : document)
+                size += element->getMarkdown().size();
+            return size;
+        });
+
+        // Inline parsing of every line on its own
+        std::vector<std::string> lines = splitLines(corpus.source);
+        runner.run("inline", corpus, [&lines]() {
+            size_t spans = 0;
+            for (const std::string& line : lines)
+                spans += Markdown::TextEntry(line).spans.size();
+            return spans;
+        });
+    }
+
+    for (const Bench::Corpus& corpus : Bench::makeElementCorpora(options.size, options.seed))
+    {
+        runner.run("parseElement", corpus, [&corpus]() {
+            Markdown::Document document;
+            document.parse(corpus.source);
+            return document.elementsCount();
+        });
+    }
+
+    for (const std::string& sweep : options.sweeps)
+    {
+        std::vector<Bench::Corpus> corpora;
+        if (!makeSweep(sweep, options, corpora))
+        {
+            std::cerr << "Invalid sweep " << sweep << ", expected knob=value,...\n";
+            return 1;
+        }
+
+        for (const Bench::Corpus& corpus : corpora)
+        {
+            runner.run("sweep", corpus, [&corpus]() {
+                Markdown::Document document;
+                document.parse(corpus.source);
+                return document.getHtml().size();
+            });
+        }
+    }
+
+    if (options.output.empty())
+        runner.write(std::cout);
+    else
+    {
+        std::ofstream file(options.output);
+        if (!file)
+        {
+            std::cerr << "Cannot open " << options.output << "\n";
+            return 1;
+        }
+        runner.write(file);
+    }
+
+    return 0;
+}
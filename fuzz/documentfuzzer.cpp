@@ -0,0 +1,23 @@
+#include "harness.h"
+
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/extensions.h"
+
+extern "C" int LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/)
+{
+    Markdown::registerStandardExtensions();
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    Fuzz::run(data, size, [](const std::string& source) {
+        Markdown::Document document;
+        document.parse(source);
+        document.getHtml();
+        document.getText();
+        for (const auto& element : document)
+            element->getMarkdown();
+    });
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Standalone driver used when the compiler doesn't provide libFuzzer, it doesn't fuzz - inputs are only replayed
+// Files given on the command line are run once, e.g. by afl-fuzz with @@, directories run every file they contain
+// Flags of libFuzzer are accepted and ignored, so the same command lines work with both builds
+namespace
+{
+    std::string readFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        return stream.str();
+    }
+
+    void replay(const std::filesystem::path& path)
+    {
+        std::string content = readFile(path);
+
+        // Printed before the run, so a crash is attributed to the input
+        std::fprintf(stderr, "%s: %zu bytes", path.string().c_str(), content.size());
+        std::fflush(stderr);
+
+        double cost = Fuzz::measure(content, [](const std::string& content) {
+            LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+        });
+        std::fprintf(stderr, ", %.0f ns/byte\n", cost);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::filesystem::path> inputs;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] != '-')
+            inputs.push_back(argv[i]);
+    }
+
+    if (inputs.empty())
+    {
+        std::fprintf(stderr, "Usage: %s [directory|file]...\nBuilt without libFuzzer, inputs are only replayed\n", argv[0]);
+        return 1;
+    }
+
+    LLVMFuzzerInitialize(&argc, &argv);
+
+    for (const std::filesystem::path& input : inputs)
+    {
+        if (!std::filesystem::is_directory(input))
+        {
+            replay(input);
+            continue;
+        }
+
+        // Sorted, so runs are reproducible
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(input))
+        {
+            if (entry.is_regular_file())
+                files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+
+        for (const std::filesystem::path& file : files)
+            replay(file);
+    }
+
+    return 0;
+}
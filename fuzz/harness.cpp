@@ -0,0 +1,86 @@
+#include "harness.h"
+
+#include "cppmarkdown/blockcache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+namespace Fuzz
+{
+    namespace
+    {
+        const size_t minimumBytes = 1024;
+
+        struct Settings
+        {
+            double maxCost = 50000.0;
+            std::string slowDirectory = ".";
+            bool abortOnSlow = false;
+
+            Settings()
+            {
+                if (const char* value = std::getenv("CPPMARKDOWN_FUZZ_MAX_COST"))
+                    this->maxCost = std::atof(value);
+                if (const char* value = std::getenv("CPPMARKDOWN_FUZZ_SLOW_DIR"))
+                    this->slowDirectory = value;
+                if (const char* value = std::getenv("CPPMARKDOWN_FUZZ_ABORT_ON_SLOW"))
+                    this->abortOnSlow = std::string(value) == "1";
+            }
+        };
+
+        const Settings& getSettings()
+        {
+            static Settings settings;
+            return settings;
+        }
+
+        std::string save(const std::string& input)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "slow-%016llx", static_cast<unsigned long long>(Markdown::BlockCache::hash(input)));
+
+            std::string path = getSettings().slowDirectory + "/" + name;
+            std::ofstream file(path, std::ios::binary);
+            file.write(input.data(), input.size());
+            return file ? path : "";
+        }
+    }
+
+    double measure(const std::string& input, const Target& target)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto begin = Clock::now();
+        target(input);
+        std::chrono::duration<double, std::nano> elapsed = Clock::now() - begin;
+
+        return elapsed.count() / std::max(input.size(), minimumBytes);
+    }
+
+    void run(const uint8_t* data, size_t size, const Target& target)
+    {
+        const Settings& settings = getSettings();
+        std::string input(reinterpret_cast<const char*>(data), size);
+
+        if (measure(input, target) <= settings.maxCost)
+            return;
+
+        // Confirm with a second run, the first one may have been disturbed by the rest of the system
+        double cost = measure(input, target);
+        if (cost <= settings.maxCost)
+            return;
+
+        // The fuzzer saves aborted inputs itself
+        if (settings.abortOnSlow)
+        {
+            std::fprintf(stderr, "Slow input: %zu bytes, %.0f ns/byte\n", size, cost);
+            std::abort();
+        }
+
+        std::string path = save(input);
+        std::fprintf(stderr, "Slow input: %zu bytes, %.0f ns/byte, saved to %s\n", size, cost, path.empty() ? "(failed)" : path.c_str());
+    }
+}
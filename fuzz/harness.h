@@ -0,0 +1,25 @@
+#ifndef _h_cppmarkdownfuzzharness
+#define _h_cppmarkdownfuzzharness
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Fuzz
+{
+    // Code under test, given the fuzzed input
+    using Target = std::function<void(const std::string&)>;
+
+    // Nanoseconds per byte of running the target on the input
+    // Inputs shorter than 1 KiB are counted as 1 KiB, their cost is mostly the fixed cost of the call
+    double measure(const std::string& input, const Target& target);
+
+    // Run the target on the input, called from LLVMFuzzerTestOneInput
+    // An input costing more than CPPMARKDOWN_FUZZ_MAX_COST nanoseconds per byte (50000 by default) on two runs
+    // is saved as slow-<hash> to CPPMARKDOWN_FUZZ_SLOW_DIR, the current directory by default
+    // With CPPMARKDOWN_FUZZ_ABORT_ON_SLOW=1 a slow input aborts instead, so that the fuzzer saves and minimizes it as a crash
+    void run(const uint8_t* data, size_t size, const Target& target);
+}
+
+#endif
@@ -0,0 +1,19 @@
+#include "harness.h"
+
+#include "cppmarkdown/ext/tableelement.h"
+
+extern "C" int LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/)
+{
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    Fuzz::run(data, size, [](const std::string& source) {
+        Markdown::TableElement table(source);
+        table.getHtml();
+        table.getText();
+        table.getMarkdown();
+    });
+    return 0;
+}
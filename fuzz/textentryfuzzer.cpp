@@ -0,0 +1,19 @@
+#include "harness.h"
+
+#include "cppmarkdown/textentry.h"
+
+extern "C" int LLVMFuzzerInitialize(int* /*argc*/, char*** /*argv*/)
+{
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    Fuzz::run(data, size, [](const std::string& text) {
+        Markdown::TextEntry entry(text);
+        entry.getHtml();
+        entry.getText();
+        entry.getMarkdown();
+    });
+    return 0;
+}
@@ -13,7 +13,7 @@ namespace Markdown
     class BlankElement : public Element
     {
     public:
-        BlankElement(const std::string& text = "");
+        BlankElement(const std::string& text = "", SpanSearchFlags searchFlags = SpanSearchFlags::AddEmpty);
 
         virtual Type getType() const override;
         virtual ParseResult parse(const std::string& line, std::shared_ptr<Element> previous) override;
@@ -21,6 +21,10 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override { return ""; }
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
 
     protected:
         TextEntry text;
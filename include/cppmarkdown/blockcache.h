@@ -0,0 +1,100 @@
+#ifndef _h_cppmarkdownblockcache
+#define _h_cppmarkdownblockcache
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace Markdown
+{
+    // Rendered HTML of top-level blocks, shared by documents with the same blocks
+    // Blocks are addressed by their source and the context they're rendered in, see Document::blockCache
+    // The cache is split into shards, each with its own lock and least recently used eviction,
+    // so it may be used from several threads at once
+    class BlockCache
+    {
+    public:
+        struct Statistics
+        {
+            size_t hits = 0;
+            size_t misses = 0;
+            size_t evictions = 0;
+            size_t entries = 0;
+            size_t size = 0; // Bytes of the cached source and HTML
+        };
+
+    public:
+        BlockCache(size_t capacity = 32 * 1024 * 1024, size_t shardCount = 16);
+        BlockCache(const BlockCache&) = delete;
+        BlockCache& operator=(const BlockCache&) = delete;
+
+        // Process-wide cache
+        static BlockCache& get();
+
+        // Get the HTML of the block rendered in the context, counted as a hit or a miss
+        std::optional<std::string> find(std::string_view source, uint64_t context);
+        // Store the HTML of the block, evicting least recently used blocks of the shard if it's full
+        void insert(std::string_view source, uint64_t context, const std::string& html);
+
+        // Remove the block rendered in the context
+        void invalidate(std::string_view source, uint64_t context);
+        // Remove all of the blocks
+        void clear();
+
+        // Capacity in bytes, divided evenly between the shards - a block larger than the shard is not cached
+        size_t getCapacity() const;
+        void setCapacity(size_t capacity);
+
+        Statistics getStatistics() const;
+        void resetStatistics();
+
+        // 64-bit FNV-1a hash of the data, may be chained through the seed
+        static uint64_t hash(std::string_view data, uint64_t seed = 14695981039346656037ull);
+        static uint64_t hash(uint64_t value, uint64_t seed = 14695981039346656037ull);
+
+    private:
+        struct Entry
+        {
+            uint64_t key;
+            uint64_t context;
+            std::string source; // Compared on lookup, hashes of different blocks may collide
+            std::string html;
+
+            size_t size() const
+            {
+                return this->source.size() + this->html.size();
+            }
+        };
+
+        struct Shard
+        {
+            mutable std::mutex mutex;
+            std::list<Entry> entries; // Most recently used first
+            std::unordered_multimap<uint64_t, std::list<Entry>::iterator> index;
+            size_t capacity = 0;
+            size_t size = 0;
+            Statistics statistics;
+
+            std::list<Entry>::iterator find(uint64_t key, std::string_view source, uint64_t context);
+            void erase(std::list<Entry>::iterator it);
+            void evict(size_t required);
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards;
+        std::atomic<size_t> capacity;
+
+        static uint64_t makeKey(std::string_view source, uint64_t context);
+        Shard& getShard(uint64_t key);
+    };
+}
+
+#endif
@@ -5,6 +5,7 @@
 #include "cppmarkdown/document.h"
 
 #include <vector>
+#include <climits>
 
 namespace Markdown
 {
@@ -23,15 +24,25 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
         virtual std::string dump(int indent) const override;
 
         static int getBlockquoteLevel(const std::string& line);
+        // Get position of the quoted text, skipping all of the quote markers
+        // Level is set to the total number of markers, or -1 if the line is not quoted
+        // Markers past maxLevel are left in the text
+        static size_t getBlockquoteTextPosition(const std::string& line, int& level, int maxLevel = INT_MAX);
         static std::string getBlockquoteText(const std::string& line);
         static std::string getEligibleText(const std::string& text);
 
     private:
-        int level = 0;
-        std::string buffer;
+        ElementContainer::ParseState state;
+
+        // Parse text of a line quoted with given level, nested blockquotes are opened as needed
+        void supplyText(int level, const std::string& text);
     };
 }
 
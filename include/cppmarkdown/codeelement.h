@@ -10,6 +10,7 @@ namespace Markdown
     {
     public:
         std::string text;
+        std::string language; // Info string of fenced code block
 
         CodeElement(const std::string& text = "");
 
@@ -20,10 +21,28 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
+
+        // Check whether the code block was opened with ``` or ~~~ fence
+        bool isFenced() const;
 
         static std::string getCodeText(const std::string& line);
+        static size_t getCodeTextPosition(const std::string& line);
         static unsigned int getCodeLevel(const std::string& line);
+
+        // Get length of code fence at the beginning of the line, 0 if line is not a fence
+        static size_t getFenceLength(const std::string& line, char& fenceChar, size_t& pos);
+
+    private:
+        char fenceChar = 0;
+        size_t fenceLength = 0;
+        size_t lineCount = 0;
+
+        void appendLine(const std::string& line, size_t pos);
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,18 @@
 #include "cppmarkdown/document.h"
 #include "cppmarkdown/textentry.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/elementstream.h"
+#include "cppmarkdown/transcoder.h"
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/blockcache.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/shareddocumentcache.h"
+#include "cppmarkdown/tracer.h"
+#include "cppmarkdown/phaseobserver.h"
+#include "cppmarkdown/parsestats.h"
+#include "cppmarkdown/memoryusage.h"
+#include "cppmarkdown/parselimits.h"
 
 #include "cppmarkdown/blankelement.h"
 #include "cppmarkdown/blockquoteelement.h"
@@ -9,6 +9,10 @@
 #include <functional>
 #include <unordered_map>
 #include <optional>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <atomic>
 
 namespace Markdown
 {
@@ -16,7 +20,10 @@ namespace Markdown
     static const char dumpIndentChar = ' ';
 
     class ElementContainer;
+    class ElementHandler;
+    class FrozenWriter;
     class TextEntry;
+    struct MemoryUsage;
 
     class FileException : public std::runtime_error
     {
@@ -69,7 +76,8 @@ namespace Markdown
     {
         None = 0x00,
         ErasePrevious = 0x01, // Erase previous element
-        ForceAdd = 0x02 // Add element at RequestMore code
+        ForceAdd = 0x02, // Add element at RequestMore code
+        Replace = 0x04 // Add element of the result in place of the parsed one, e.g. plain text past a limit
     };
     DEFINE_BITFIELD(ParseFlags);
 
@@ -96,13 +104,102 @@ namespace Markdown
         Code,
         Line,
         Reference,
-        Extension
+        Extension,
+        TableRow,
+        TableCell
     };
     DEFINE_BITFIELD(Type);
 
     std::string typeToString(Type type);
 
+    // Count of the element types, e.g. to index arrays by the type
+    constexpr size_t TypeCount = static_cast<size_t>(Type::TableCell) + 1;
+
     class Element;
+    class ReferenceManager;
+
+    // Byte range of the source an element or span was parsed from, see SourceMap
+    struct SourceRange
+    {
+        static constexpr uint32_t npos = UINT32_MAX;
+
+        uint32_t begin = npos;
+        uint32_t end = npos; // One past the last byte
+
+        bool valid() const { return this->begin != npos; }
+        size_t length() const { return this->valid() ? this->end - this->begin : 0; }
+    };
+
+    // Rendered HTML and plain text of a top-level element, kept until cleared
+    // Every cache is discarded at once by invalidateAll, e.g. when the HTML provider changes, and the output
+    // of links resolving references is discarded when the references of their manager change
+    class RenderCache
+    {
+    public:
+        // Get the cached output, render and store it if it's missing
+        template<typename Render>
+        const std::string& getHtml(Render render) const
+        {
+            return this->get(this->html, render);
+        }
+
+        template<typename Render>
+        const std::string& getText(Render render) const
+        {
+            return this->get(this->text, render);
+        }
+
+        void clear()
+        {
+            this->html.reset();
+            this->text.reset();
+        }
+
+        // Add the cached output to the strings of given type
+        void measure(MemoryUsage& usage, Type type) const;
+        void shrinkToFit();
+
+        // Discard the output of all caches
+        static void invalidateAll()
+        {
+            RenderCache::currentGeneration++;
+        }
+
+        // Report that the output being rendered resolved references of the manager
+        static void dependOn(const ReferenceManager& manager);
+
+    private:
+        mutable std::optional<std::string> html;
+        mutable std::optional<std::string> text;
+        mutable unsigned int generation = 0;
+        // Manager whose references the output resolved, kept alive by the links of the element
+        mutable const ReferenceManager* references = nullptr;
+        mutable unsigned int referencesGeneration = 0;
+        static std::atomic<unsigned int> currentGeneration; // Documents may be parsed from several threads
+        static thread_local const RenderCache* rendering; // Cache whose output is being rendered
+
+        // Discard the output rendered before the provider or the references changed
+        void validate() const;
+
+        template<typename Render>
+        const std::string& get(std::optional<std::string>& value, Render render) const
+        {
+            this->validate();
+
+            if (!value)
+            {
+                struct Rendering
+                {
+                    const RenderCache* previous = RenderCache::rendering;
+                    ~Rendering() { RenderCache::rendering = this->previous; }
+                } scope;
+
+                RenderCache::rendering = this;
+                value = render();
+            }
+            return *value;
+        }
+    };
 
     struct ParseResult
     {
@@ -126,6 +223,7 @@ namespace Markdown
     {
     public:
         Element* parent = nullptr;
+        SourceRange sourceRange; // Only recorded while parsing with an active SourceMap
 
         virtual ~Element() = default;
 
@@ -144,6 +242,10 @@ namespace Markdown
         // Finalize element after the whole document has been parsed
         virtual FinalizeAction documentFinalize(std::shared_ptr<Element> previous) { return FinalizeAction::None; };
 
+        // Complete the document finalization once the following element didn't erase this one
+        // Lets elements joined by documentFinalize do the work only once, for the last element of the run
+        virtual void finishDocumentFinalize() {};
+
         // Get element's level in the tree structure
         unsigned int getLevel() const
         {
@@ -162,6 +264,33 @@ namespace Markdown
         virtual std::string getInnerHtml() const { return this->getHtml(); }
         virtual std::string getMarkdown() const { return ""; }
         virtual std::string dump(int indent = 0) const;
+
+        // Output of getHtml and getText, rendered once and reused until the element is invalidated
+        // Used for top-level elements - containers render their elements directly, so nested output isn't kept twice
+        const std::string& getCachedHtml() const;
+        const std::string& getCachedText() const;
+
+        // Discard cached output of the element and all of its ancestors
+        // Containers invalidate their elements when modified, any other change has to be followed by a call to this function
+        void invalidate();
+
+        // Report element's structure and text to the handler
+        virtual void walk(ElementHandler& handler) const;
+        // Write the element to the frozen document, see Document::freeze
+        // Elements unknown to the format are written already rendered, with the current HTML provider
+        virtual void freeze(FrozenWriter& writer) const;
+        // Add the memory held by the element, its text and nested elements, see Document::memoryUsage
+        // Elements which don't override it are counted as the base Element only
+        virtual void measure(MemoryUsage& usage) const;
+        // Release the unused capacity of element's strings and vectors, see Document::shrinkToFit
+        virtual void shrinkToFit();
+
+    protected:
+        // Add the element object of given size and its cached output, for measure
+        void measureElement(MemoryUsage& usage, size_t size) const;
+
+    private:
+        RenderCache renderCache;
     };
 
     struct Style
@@ -176,6 +305,47 @@ namespace Markdown
         { }
     };
 
+    // Object active on the calling thread for the lifetime of a ContextGuard, e.g. the references of the parsed document
+    // Guards nest, the object active before is restored when the guard goes out of scope
+    template<typename T>
+    class ThreadContext
+    {
+    public:
+        class ContextGuard
+        {
+        public:
+            ContextGuard(T& active)
+                : ContextGuard(&active)
+            { }
+
+            ~ContextGuard()
+            {
+                ThreadContext::current = this->previous;
+            }
+
+            ContextGuard(const ContextGuard&) = delete;
+            ContextGuard& operator=(const ContextGuard&) = delete;
+
+        protected:
+            // Null leaves no object active within the guard
+            ContextGuard(T* active)
+                : previous(ThreadContext::current)
+            {
+                ThreadContext::current = active;
+            }
+
+            T* previous;
+        };
+
+        static T* get()
+        {
+            return ThreadContext::current;
+        }
+
+    protected:
+        inline static thread_local T* current = nullptr;
+    };
+
     struct Reference
     {
         Reference(const std::string& id = "", const std::string& value = "", const std::string& title = "")
@@ -190,25 +360,22 @@ namespace Markdown
         std::string title;
     };
 
-    class ReferenceManager
+    // References of a single document, links and images of the document share it to resolve them when rendered
+    class ReferenceManager : public std::enable_shared_from_this<ReferenceManager>, public ThreadContext<ReferenceManager>
     {
     public:
-        struct ContextGuard
-        {
-            ContextGuard(ReferenceManager &manager);
-            ~ContextGuard();
-        };
-        friend struct ContextGuard;
-
-    public:
-        static ReferenceManager* get();
+        // Ownership shared with the shared_ptr owning the manager, if any - otherwise its owner keeps it alive
+        std::shared_ptr<const ReferenceManager> share() const;
 
         void registerReference(const Reference& reference);
         std::optional<Reference> getReference(const std::string &name) const;
+        const std::unordered_map<std::string, Reference>& getReferences() const;
+        // Changed by every registered reference
+        unsigned int getGeneration() const;
 
     private:
         std::unordered_map<std::string, Reference> references;
-        static ReferenceManager* current;
+        unsigned int generation = 0;
     };
 
     using ParserPredicate = std::function<ParseResult(const std::string&, std::shared_ptr<Element>, std::shared_ptr<Element>, Type mask)>;
@@ -269,6 +436,30 @@ namespace Markdown
     std::string replace(std::string source, const std::string& target, const std::string& replacement);
     std::vector<std::string> split(const std::string& source, char delimiter);
 
+    // Call pred for every complete line of the chunk, the incomplete remainder is kept in buffer
+    // Buffer has to be passed again with the next chunk, and the last line flushed when there are no more chunks
+    template<typename Pred>
+    void splitLines(std::string_view chunk, std::string& buffer, Pred pred)
+    {
+        const char* data = chunk.data();
+        const char* end = data + chunk.size();
+        while (data < end)
+        {
+            const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', end - data));
+            if (!lineEnd)
+            {
+                buffer.append(data, end);
+                break;
+            }
+
+            buffer.append(data, lineEnd);
+            pred(buffer);
+            buffer.clear();
+
+            data = lineEnd + 1;
+        }
+    }
+
     // Check if character at given position is escaped with backslash
     bool isEscaped(const std::string& str, size_t position);
 }
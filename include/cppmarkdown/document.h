@@ -2,9 +2,15 @@
 #define _h_cppmarkdowndocument
 
 #include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/parsestats.h"
+#include "cppmarkdown/memoryusage.h"
+#include "cppmarkdown/parselimits.h"
 
 #include <vector>
 #include <functional>
+#include <string_view>
+#include <cstddef>
 
 namespace Markdown
 {
@@ -13,13 +19,33 @@ namespace Markdown
     public:
         using Container = std::vector<std::shared_ptr<Element>>;
 
+        // State of line by line parsing carried between consecutive lines
+        struct ParseState
+        {
+            std::shared_ptr<Element> activeElement = nullptr; // Element which requested more lines
+            std::shared_ptr<Element> previousElement = nullptr; // Last parsed element
+        };
+
     public:
+        // Elements of the container belong to the owner, which is invalidated whenever the container changes
+        ElementContainer(Element* owner = nullptr);
+
         virtual ParseResult parseLine(const std::string& line, std::shared_ptr<Element> previous, std::shared_ptr<Element> active = nullptr, Type mask = Type::None);
         virtual void parse(const std::string& content, Type mask = Type::None);
         virtual void finalize() {};
 
+        // Parse next line of the content, continuing from given state
+        void parseNextLine(const std::string& line, ParseState& state, Type mask = Type::None);
+        // Finish line by line parsing - add the element which requested more lines, if any
+        void finishParsing(ParseState& state);
+
         std::string dump(int indent = 0) const;
 
+        // Add the memory of the elements, the vector holding them belongs to the owner's type
+        void measureElements(MemoryUsage& usage, Type owner) const;
+        // Release the unused capacity of the vector and of the elements
+        void shrinkElements();
+
         virtual void addElement(std::shared_ptr<Element> element);
         virtual void addElement(std::shared_ptr<Element> element, Container::const_iterator it);
         virtual void iterate(std::function<void(ElementContainer& container, Container::iterator, const Element*, const Element*)> pred);
@@ -48,11 +74,14 @@ namespace Markdown
         {
             ParseResult result;
             result.element = active ? active : std::make_shared<T>(args...);
+            std::shared_ptr<Element> replacement;
 
             if ((1 << result.element->getType()) & mask)
                 result.code = ParseCode::Invalid;
             else
             {
+                SourceMap::Tracker tracker(*result.element);
+
                 ParseResult parseResult;
                 if (active)
                     parseResult = result.element->supply(line, previous);
@@ -60,31 +89,153 @@ namespace Markdown
                     parseResult = result.element->parse(line, previous);
                 result.code = parseResult.code;
                 result.flags = parseResult.flags;
+
+                if (!parseResult || parseResult.code == ParseCode::ElementCompleteParseNext)
+                    tracker.reject();
+
+                // Element parsed in place of this one takes the line, this one is rejected
+                if (parseResult.flags & ParseFlags::Replace)
+                {
+                    replacement = parseResult.element;
+                    replacement->sourceRange = result.element->sourceRange;
+                    tracker.reject();
+                }
+            }
+
+            if (!active)
+            {
+                if (ParseStats* stats = ParseStats::get())
+                {
+                    size_t index = ParseStats::index(result.element->getType());
+                    stats->attempts[index]++;
+                    if (result.code == ParseCode::Invalid || replacement)
+                        stats->rejections[index]++;
+                }
             }
 
+            if (replacement)
+                result.element = replacement;
+
             return result;
         }
 
     protected:
         Container elements;
+        Element* owner;
 
         void finalizeElement(std::shared_ptr<Element>& activeElement);
+        // Invalidate cached output of the owner after the elements changed
+        void invalidate();
+        void adopt(Element& element);
+        void release(Element& element);
     };
 
+    class ElementRange;
+    class BlockCache;
+
     class Document : public ElementContainer
     {
+    public:
+        // Incremental parser building the document from chunks of content
+        // Only the last incomplete line is buffered between chunks
+        class Builder
+        {
+        public:
+            Builder(Document& document, Type mask = Type::None);
+
+            // Parse all complete lines of the chunk, lines may be split between chunks
+            void feed(std::string_view chunk);
+            // Parse the remaining line and finalize the document
+            void finish();
+
+        private:
+            Document& document;
+            Type mask;
+            ParseState state;
+            std::string line;
+            size_t fed = 0; // Bytes of the content fed so far, counted against ParseLimits::maxInputBytes
+            bool finished = false;
+        };
+
     public:
         bool addCharset = false;
+        bool keepSource = false; // Retain the source in parse, required by applyEdit
+        ParseLimits limits; // Bounds of the work done parsing untrusted content, see parselimits.h
+        // Shared cache of rendered blocks used by getHtml, e.g. &BlockCache::get(), requires keepSource
+        // Blocks are looked up by their source - elements must not be modified after parsing
+        BlockCache* blockCache = nullptr;
 
         static Document load(const std::string& path);
+        // Lazily parse top-level elements of the source, see ElementRange in elementstream.h
+        static ElementRange lazyElements(std::string_view source, Type mask = Type::None, const ParseLimits& limits = ParseLimits());
+        // Parse the content, replacing the elements and references of an earlier parse
         virtual void parse(const std::string& content, Type mask = Type::None) override;
+        // Parse the content, filling the statistics of parsing it
+        void parse(const std::string& content, ParseStats& stats, Type mask = Type::None);
         virtual void finalize() override;
 
+        // Limits reached by the last parse or edit, their content was parsed as plain text
+        Limit getExceededLimits() const;
+
         std::string getText() const;
         std::string getHtml() const;
+        // Serialize the elements and references into a single buffer, rendered by FrozenDocument
+        // without parsing the source again - see frozendocument.h
+        std::string freeze() const;
+
+        // Bytes held by the document per element type, including the retained source and the references
+        MemoryUsage memoryUsage() const;
+        // Release the unused capacity of the strings and vectors of the document, e.g. before caching it
+        void shrinkToFit();
+
+        // Replace removedLength bytes of the retained source at offset with insertedText and re-parse
+        // only the blocks affected by the edit, keeping the remaining elements intact
+        // Elements must not be modified in between, throws std::logic_error if the document was not parsed with keepSource enabled
+        // The cost depends on the size of the edited blocks and the distance from the previous edit,
+        // an edit changing the count of top-level elements also moves the following ones in the vector
+        // With an active SourceMap the whole source is parsed again
+        void applyEdit(size_t offset, size_t removedLength, const std::string& insertedText);
+        // Sources of the blocks are stored separately, they're joined on first use after a change
+        const std::string& getSource() const;
 
     private:
-        ReferenceManager referenceManager;
+        // Part of the retained source which can be parsed independently of the preceding content
+        // Every block except the first one starts with a blank line which ended all of the open elements
+        struct SourceBlock
+        {
+            std::string source;
+            size_t elements; // Count of the top-level elements parsed from the source
+            size_t begin; // Offset of the source in the document, see deltaBlock
+            size_t firstElement; // Index of the first element, see deltaBlock
+        };
+
+        class SourceParser;
+
+        // Shared with the links and images of the elements, which may outlive the document
+        std::shared_ptr<ReferenceManager> referenceManager = std::make_shared<ReferenceManager>();
+        ParseLimiter limiter;
+        std::vector<SourceBlock> sourceBlocks;
+        // An edit doesn't update the offsets of all the following blocks - blocks from deltaBlock on are
+        // off by the deltas, which are moved along to the block of the next edit
+        size_t deltaBlock = 0;
+        ptrdiff_t offsetDelta = 0;
+        ptrdiff_t elementDelta = 0;
+        mutable std::string source; // Sources of the blocks joined by getSource
+        mutable bool sourceJoined = true;
+        Type sourceMask = Type::None;
+
+        // Parse the whole source, replacing the elements
+        void parseSource(std::string_view source);
+        size_t getBlockBegin(size_t block) const;
+        size_t getBlockElement(size_t block) const;
+        size_t getSourceSize() const;
+        // Update the blocks between deltaBlock and given block, so the deltas apply from given block on
+        void moveDeltas(size_t block);
+        // Append HTML of the source blocks using the block cache, false if the blocks are not known
+        bool renderBlocks(std::string& html) const;
+
+        // Finalize the elements as a single run, see Document::finalize
+        static Container finalizeElements(Container elements);
     };
 
     class SubelementContainer
@@ -0,0 +1,33 @@
+#ifndef _h_cppmarkdownelementhandler
+#define _h_cppmarkdownelementhandler
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+namespace Markdown
+{
+    struct MarkdownStyle;
+
+    // Additional information about block or span, e.g. heading level or link url
+    using Attributes = std::vector<std::pair<std::string, std::string>>;
+
+    // Receives structure and text of the elements, see Element::walk
+    // Every enterBlock is matched with exitBlock, and every enterSpan with exitSpan
+    class ElementHandler
+    {
+    public:
+        virtual ~ElementHandler() = default;
+
+        virtual void enterBlock(Type /*type*/, const Attributes& /*attributes*/) {}
+        virtual void exitBlock(Type /*type*/) {}
+        virtual void text(std::string_view /*text*/) {}
+        virtual void enterSpan(const MarkdownStyle& /*style*/, const Attributes& /*attributes*/) {}
+        virtual void exitSpan(const MarkdownStyle& /*style*/) {}
+    };
+}
+
+#endif
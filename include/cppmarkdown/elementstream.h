@@ -0,0 +1,130 @@
+#ifndef _h_cppmarkdownelementstream
+#define _h_cppmarkdownelementstream
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/parselimits.h"
+
+#include <string>
+#include <string_view>
+#include <istream>
+#include <functional>
+#include <deque>
+#include <iterator>
+
+namespace Markdown
+{
+    // Parses content pushed in chunks and passes every completed top-level element to the callback,
+    // finalized the same way as Document::finalize would. Elements are not retained afterwards -
+    // only the element being parsed, the last parsed one and the one awaiting finalization are kept
+    // The limits bound the whole content fed to the stream, the deadline is measured from its construction
+    class ElementStream
+    {
+    public:
+        using Callback = std::function<void(std::shared_ptr<Element>)>;
+
+        ElementStream(Callback callback, Type mask = Type::None, const ParseLimits& limits = ParseLimits());
+
+        // Parse all complete lines of the chunk, lines may be split between chunks
+        void feed(std::string_view chunk);
+        // Parse the remaining line and pass all of the remaining elements to the callback
+        void finish();
+
+        bool finished() const;
+
+        // References defined so far in the content
+        ReferenceManager& getReferenceManager();
+
+        // Limits exceeded by the content parsed so far
+        Limit getExceededLimits() const;
+
+    private:
+        Callback callback;
+        Type mask;
+        ParseLimiter limiter;
+        size_t fed = 0; // Bytes of the content fed so far, counted against ParseLimits::maxInputBytes
+        ElementContainer container;
+        ElementContainer::ParseState state;
+        std::shared_ptr<Element> pending;
+        std::string line;
+        // Shared with the links and images of the passed elements, which may outlive the stream
+        std::shared_ptr<ReferenceManager> referenceManager = std::make_shared<ReferenceManager>();
+        bool isFinished = false;
+
+        void parseLine(const std::string& line);
+        void complete(std::shared_ptr<Element> element);
+    };
+
+    // Range of top-level elements parsed lazily from the source, as the range is iterated
+    // Iteration may be stopped at any point, the rest of the source is not parsed then
+    // The source is not copied - it has to outlive the range, the elements may outlive both
+    class ElementRange
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = std::shared_ptr<Element>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            iterator(ElementRange* range = nullptr);
+
+            reference operator*() const;
+            pointer operator->() const;
+            iterator& operator++();
+            bool operator==(const iterator& b) const;
+            bool operator!=(const iterator& b) const;
+
+        private:
+            ElementRange* range;
+            std::shared_ptr<Element> current;
+        };
+
+        ElementRange(std::string_view source, Type mask = Type::None, const ParseLimits& limits = ParseLimits());
+        ElementRange(const ElementRange&) = delete;
+        ElementRange& operator=(const ElementRange&) = delete;
+
+        iterator begin();
+        iterator end();
+
+        // Number of source bytes parsed so far
+        size_t position() const;
+
+        // References defined in the parsed part of the source
+        ReferenceManager& getReferenceManager();
+
+        Limit getExceededLimits() const;
+
+    private:
+        std::string_view source;
+        size_t offset = 0;
+        ElementStream stream;
+        std::deque<std::shared_ptr<Element>> ready;
+
+        // Parse until next element is complete, nullptr at the end of the source
+        std::shared_ptr<Element> next();
+    };
+
+    // Event-driven parser - reports every block and span to the handler without building the document
+    class EventParser
+    {
+    public:
+        EventParser(ElementHandler& handler, Type mask = Type::None, const ParseLimits& limits = ParseLimits());
+
+        void feed(std::string_view chunk);
+        void finish();
+
+        Limit getExceededLimits() const;
+
+        static void parse(const std::string& content, ElementHandler& handler, Type mask = Type::None);
+        static void parse(std::istream& stream, ElementHandler& handler, Type mask = Type::None);
+
+    private:
+        ElementStream stream;
+    };
+}
+
+#endif
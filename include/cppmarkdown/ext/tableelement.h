@@ -44,6 +44,10 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
 
         static bool tableLineValid(const std::string &line, size_t requiredPipes);
         static Row parseRow(const std::string& line);
@@ -27,6 +27,19 @@ namespace Markdown
         static ExtensionsManager& getInstance();
 
         void registerExtension(std::unique_ptr<Extension>&& extension);
+        // Extensions are never removed, so the count identifies the registered set
+        size_t getExtensionCount() const;
+
+        template<typename T>
+        bool hasExtension() const
+        {
+            for (const auto& extension : this->extensions)
+            {
+                if (dynamic_cast<const T*>(extension.get()))
+                    return true;
+            }
+            return false;
+        }
 
         void extend(ParserCollection& parsers);
 
@@ -36,6 +49,7 @@ namespace Markdown
         std::vector<std::unique_ptr<Extension>> extensions;
     };
 
+    // Registers the standard extension unless it's already registered
     void registerStandardExtensions();
 }
 
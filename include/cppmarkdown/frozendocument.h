@@ -0,0 +1,105 @@
+#ifndef _h_cppmarkdownfrozendocument
+#define _h_cppmarkdownfrozendocument
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+namespace Markdown
+{
+    class FrozenFormatException : public std::runtime_error
+    {
+    public:
+        FrozenFormatException(const std::string& what)
+            : std::runtime_error(what)
+        { }
+    };
+
+    enum class FrozenNode : uint32_t
+    {
+        Document, // Flags and references, children are the top-level elements
+        Element, // Type of the element followed by its fields
+        RenderedElement, // Type, HTML and text of an element unknown to the format, rendered when frozen
+        Span, // Tags and text, children are the nested spans
+        LinkSpan, // URL and reference flag followed by the span fields
+        ImageSpan
+    };
+
+    // Writes the frozen buffer, see Document::freeze
+    // Every node is a header (kind, size in bytes, count of children) followed by its fields and its children
+    // Integers are stored as 32-bit little-endian, strings with their length before the bytes
+    class FrozenWriter
+    {
+    public:
+        FrozenWriter();
+
+        // Fields of the node are written right after beginning it, followed by the children
+        void beginNode(FrozenNode node);
+        void beginElement(Type type);
+        void endNode();
+
+        void writeInteger(uint32_t value);
+        void writeString(std::string_view value);
+        // Count of the references, offsets of the references sorted by id, and the references
+        void writeReferences(const ReferenceManager& references);
+
+        // Fill the header and return the buffer, the writer is left empty
+        std::string finish();
+
+    private:
+        std::string buffer;
+        std::vector<size_t> openNodes;
+
+        void setInteger(size_t offset, uint32_t value);
+    };
+
+    struct FrozenOptions
+    {
+        // Compare the checksum of the whole buffer on construction, e.g. for buffers read from storage
+        // Without it only the header is checked and corrupted nodes throw once they're rendered
+        bool verifyChecksum = false;
+        // Nesting of the nodes, deeper buffers throw when rendered instead of exhausting the stack
+        size_t maxDepth = 1024;
+    };
+
+    // Read-only view of a buffer created by Document::freeze, rendered without rebuilding the document
+    // Offsets are relative to the start of the buffer, so it may be stored and memory-mapped
+    // The buffer is not copied - it has to outlive the view
+    class FrozenDocument
+    {
+    public:
+        static constexpr uint32_t version = 1;
+        static constexpr size_t headerSize = 16; // Magic, version, size and checksum
+
+        // Throws FrozenFormatException if the buffer is not a frozen document of this version or is corrupted
+        FrozenDocument(std::string_view buffer, const FrozenOptions& options = FrozenOptions());
+        // The view would outlive a temporary buffer
+        FrozenDocument(std::string&& buffer, const FrozenOptions& options = FrozenOptions()) = delete;
+
+        size_t elementsCount() const;
+
+        // Same output as Document::getText and Document::getHtml of the frozen document
+        std::string getText() const;
+        std::string getHtml() const;
+
+        // Checksum of the data following the header
+        static uint32_t checksum(std::string_view data);
+
+    private:
+        class Renderer;
+
+        std::string_view buffer;
+        size_t maxDepth;
+        bool addCharset = false;
+        uint32_t referenceCount = 0;
+        size_t referenceTable = 0; // Offsets of the references, sorted by id
+        uint32_t elementCount = 0;
+        size_t elements = 0; // Offset of the first top-level element
+    };
+}
+
+#endif
@@ -32,6 +32,10 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
 
         static std::shared_ptr<MarkdownStyle> getDefaultStyle(Heading heading);
         static std::string getHeadingText(const std::string& line);
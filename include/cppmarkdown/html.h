@@ -9,6 +9,17 @@
 
 namespace Markdown
 {
+	enum class EscapeMode
+	{
+		Text, // Escape &, < and >
+		Attribute // Escape &, <, >, " and '
+	};
+
+	// Append source to target, replacing characters with special meaning in HTML with entities
+	void appendEscapedHtml(std::string& target, const char* data, size_t size, EscapeMode mode = EscapeMode::Text);
+	void appendEscapedHtml(std::string& target, const std::string& source, EscapeMode mode = EscapeMode::Text);
+	std::string escapeHtml(const std::string& source, EscapeMode mode = EscapeMode::Text);
+
 	// Very simple HTML tag builder
 	struct Tag
 	{
@@ -47,8 +58,18 @@ namespace Markdown
 		virtual std::pair<std::string, std::string> getStrong() const = 0;
 		virtual std::pair<std::string, std::string> getInlineCode() const = 0;
 
+		// Check if URL may be used by link or image, relative URLs are always allowed
+		virtual bool isUrlAllowed(const std::string& url) const;
+
+		// Identifies the output of the provider, providers producing different HTML must have different fingerprints
+		// By default made of the tags and the URL schemes allowed, providers configured in other ways should extend it
+		virtual std::string getFingerprint() const;
+
 		static HtmlProvider& get();
 
+		// Get lowercase scheme of the URL, empty if URL is relative
+		static std::string getUrlScheme(const std::string& url);
+
 	private:
 		static std::unique_ptr<HtmlProvider> currentProvider;
 	};
@@ -95,11 +116,13 @@ namespace Markdown
 		{
 			this->previousProvider = std::move(HtmlProvider::currentProvider);
 			HtmlProvider::currentProvider = std::make_unique<T>(Params...);
+			RenderCache::invalidateAll();
 		}
 
 		~SubstituteHtmlProvider()
 		{
 			HtmlProvider::currentProvider = std::move(this->previousProvider);
+			RenderCache::invalidateAll();
 		}
 
 	private:
@@ -30,10 +30,13 @@ namespace Markdown
         virtual Type getType() const override;
         virtual ParseResult parse(const std::string& line, std::shared_ptr<Element> previous) override;
         virtual ParseResult supply(const std::string& line, std::shared_ptr<Element> previous) override;
-        virtual void finalize() override;
 
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
         virtual std::string dump(int indent = 0) const override;
 
     protected:
@@ -42,9 +45,12 @@ namespace Markdown
 
     private:
         std::string label;
-        std::string buffer;
         ListElement* parent = nullptr;
         int level = 0;
+
+        // Parse single line of item's content, already stripped of marker and indentation
+        void parseContent(const std::string& text);
+        void appendElement(std::shared_ptr<Element> element);
     };
 
     //class ListElement : public Element, public SubelementParser
@@ -85,7 +91,6 @@ namespace Markdown
         using ElementContainer::size;
 
         ListType listType = ListType::Invalid;
-        std::string buffer;
 
         ListElement(const std::string& text = "");
 
@@ -103,6 +108,10 @@ namespace Markdown
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
         virtual std::string dump(int indent = 0) const override;
 
         static size_t countLeadingSpaces(const std::string &text);
@@ -119,6 +128,16 @@ namespace Markdown
         static std::string getListTextWithMarker(const std::string& line);
         static std::string getListItemLineText(const std::string& line);
         static std::string getListItemText(const std::string& line);
+
+    private:
+        friend class ListItem;
+
+        int level = 0;
+        size_t nesting = 0; // Count of the lists containing this one, within the top-level list
+        // Lists still accepting items, from this list down to the most nested one
+        std::vector<ListElement*> openLists;
+
+        std::shared_ptr<ListItem> appendItem(const std::string& line, ListType type);
     };
 }
 
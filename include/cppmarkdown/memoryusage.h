@@ -0,0 +1,75 @@
+#ifndef _h_cppmarkdownmemoryusage
+#define _h_cppmarkdownmemoryusage
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace Markdown
+{
+    struct MarkdownStyle;
+
+    // Bytes held by a parsed document, see Document::memoryUsage
+    // Sizes of the objects and of the memory they allocated, without the overhead of the allocator and shared pointers
+    struct MemoryUsage
+    {
+        // Memory held by the elements of a single type - the elements themselves, their text and nested containers
+        struct Breakdown
+        {
+            size_t elements = 0; // Element objects
+            size_t spans = 0; // Span objects of the text
+            size_t strings = 0; // Allocated capacity of strings, short strings stored inside of their objects take none
+            size_t stringsUsed = 0; // Part of the capacity holding the characters, the rest is released by shrinkToFit
+            size_t vectors = 0; // Allocated capacity of vectors
+            size_t vectorsUsed = 0; // Part of the capacity holding the items
+            size_t styles = 0; // Styles of the spans, every style counted once however many spans share it
+            size_t references = 0; // Reference manager
+
+            size_t total() const
+            {
+                return this->elements + this->spans + this->strings + this->vectors + this->styles + this->references;
+            }
+
+            Breakdown& operator+=(const Breakdown& b);
+        };
+
+        // Indexed by the type of the element owning the memory, None holds the document itself
+        std::array<Breakdown, TypeCount> types{};
+
+        Breakdown& operator[](Type type)
+        {
+            return this->types[static_cast<size_t>(type)];
+        }
+
+        const Breakdown& get(Type type) const
+        {
+            return this->types[static_cast<size_t>(type)];
+        }
+
+        // Sum of all types
+        Breakdown getTotal() const;
+        size_t total() const;
+
+        // Helpers of Element::measure, adding the memory to the given type
+        void addObject(Type type, size_t size);
+        void addString(Type type, const std::string& str);
+        void addStyle(Type type, const std::shared_ptr<MarkdownStyle>& style);
+
+        template<typename T>
+        void addVector(Type type, const std::vector<T>& vector)
+        {
+            Breakdown& breakdown = (*this)[type];
+            breakdown.vectors += vector.capacity() * sizeof(T);
+            breakdown.vectorsUsed += vector.size() * sizeof(T);
+        }
+
+    private:
+        std::unordered_set<const MarkdownStyle*> styles; // Styles already counted
+    };
+}
+
+#endif
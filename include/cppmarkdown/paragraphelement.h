@@ -3,6 +3,7 @@
 
 #include "cppmarkdown/cppmarkdowncommon.h"
 #include "cppmarkdown/textentry.h"
+#include "cppmarkdown/sourcemap.h"
 
 namespace Markdown
 {
@@ -17,12 +18,30 @@ namespace Markdown
 
         virtual Type getType() const override;
         virtual ParseResult parse(const std::string& line, std::shared_ptr<Element> previous) override;
+        // Parse the line as plain text without styles, e.g. an element refused past a parse limit
+        ParseResult parseLiteral(const std::string& line);
         virtual FinalizeAction documentFinalize(std::shared_ptr<Element> previous) override;
+        virtual void finishDocumentFinalize() override;
 
         virtual std::string getText() const override;
         virtual std::string getHtml() const override;
         virtual std::string getInnerHtml() const override;
         virtual std::string getMarkdown() const override;
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
+
+    private:
+        std::string markdown; // Source of the text joined with the following lines of the paragraph, cleared once finalized
+        ContentOrigin origin; // Where the markdown was taken from, only recorded with an active SourceMap
+        bool joined = false; // Text is parsed again from the joined source when the finalization finishes
+        bool literal = false; // Joined only with other literal paragraphs
+
+        ParseResult parseText(const std::string& line);
+        SpanSearchFlags getSearchFlags() const;
+
+        friend class HeadingElement;
     };
 }
 
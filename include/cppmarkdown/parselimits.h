@@ -0,0 +1,143 @@
+#ifndef _h_cppmarkdownparselimits
+#define _h_cppmarkdownparselimits
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <chrono>
+#include <cstdint>
+
+namespace Markdown
+{
+    enum class Limit
+    {
+        None = 0x00,
+        InputBytes = 0x01,
+        BlockDepth = 0x02,
+        InlineDepth = 0x04,
+        TableColumns = 0x08,
+        SpansPerEntry = 0x10,
+        Deadline = 0x20
+    };
+    DEFINE_BITFIELD(Limit);
+
+    // Bounds of the work done parsing untrusted content, everything is unlimited by default
+    // Content past a limit is parsed as plain text instead of failing, see Document::getExceededLimits
+    // Applied by Document and by ElementStream with the parsers built on it, see elementstream.h
+    struct ParseLimits
+    {
+        size_t maxInputBytes = SIZE_MAX; // Lines ending past the limit are dropped
+        size_t maxBlockDepth = SIZE_MAX; // Nesting of block elements as ParseStats::peakDepth counts it, at least 1
+        size_t maxInlineDepth = SIZE_MAX; // Nesting of inline styles, 1 keeps **strong** but not *emphasis* inside it
+        size_t maxTableColumns = SIZE_MAX; // Wider rows are kept as written, joined into a paragraph
+        size_t maxSpansPerEntry = SIZE_MAX; // Styled spans of a single paragraph, heading, list item or table cell
+        // Time since the parse started, after which the rest is parsed without nesting and inline styles
+        std::chrono::steady_clock::duration timeout = std::chrono::steady_clock::duration::max();
+
+        bool unlimited() const;
+    };
+
+    // Enforces the limits of a single parse, checked by the parsers
+    // Unlimited limits leave no limiter active, so the parsers skip the checks
+    class ParseLimiter : public ThreadContext<ParseLimiter>
+    {
+    public:
+        // Activates the limiter if it limits anything
+        struct ContextGuard : public ThreadContext<ParseLimiter>::ContextGuard
+        {
+            ContextGuard(ParseLimiter& limiter);
+        };
+
+        // Levels of block elements the parsed lines are nested in for the lifetime of the scope
+        class BlockScope
+        {
+        public:
+            BlockScope(size_t levels)
+                : limiter(ParseLimiter::current)
+                , levels(levels)
+            {
+                if (this->limiter)
+                    this->limiter->blockDepth += levels;
+            }
+
+            ~BlockScope()
+            {
+                if (this->limiter)
+                    this->limiter->blockDepth -= this->levels;
+            }
+
+            BlockScope(const BlockScope&) = delete;
+            BlockScope& operator=(const BlockScope&) = delete;
+
+        private:
+            ParseLimiter* limiter;
+            size_t levels;
+        };
+
+        // Level of inline styles parsed for the lifetime of the scope
+        class InlineScope
+        {
+        public:
+            InlineScope()
+                : limiter(ParseLimiter::current)
+            {
+                if (this->limiter)
+                    this->limiter->inlineDepth++;
+            }
+
+            ~InlineScope()
+            {
+                if (this->limiter)
+                    this->limiter->inlineDepth--;
+            }
+
+            InlineScope(const InlineScope&) = delete;
+            InlineScope& operator=(const InlineScope&) = delete;
+
+            // Whether styles may be searched in the text, false past the depth limit or the deadline
+            bool allowed(const std::string& text) const
+            {
+                return !this->limiter || this->limiter->allowsStyles(text);
+            }
+
+        private:
+            ParseLimiter* limiter;
+        };
+
+    public:
+        ParseLimiter(const ParseLimits& limits = ParseLimits());
+
+        // Start a new parse - the deadline is measured from now
+        void reset(const ParseLimits& limits);
+
+        const ParseLimits& getLimits() const;
+        Limit getExceeded() const;
+        void exceed(Limit limit);
+
+        // Levels of block elements which may still nest in the element parsed at the current depth,
+        // leaving one for its content - zero once the deadline passed
+        size_t getBlockLevels() const;
+
+        // Check the deadline, the clock is read only every few calls
+        void checkDeadline();
+        bool expired() const;
+
+        // Styled spans of the parsed TextEntry
+        void beginEntry();
+        void countSpan();
+        // Whether no more styled spans may be added to the parsed TextEntry
+        bool spansExhausted();
+
+    private:
+        ParseLimits limits;
+        Limit exceeded = Limit::None;
+        size_t blockDepth = 0;
+        size_t inlineDepth = 0;
+        size_t entrySpans = 0;
+        std::chrono::steady_clock::time_point deadline;
+        unsigned int countdown = 0;
+
+        bool allowsStyles(const std::string& text);
+    };
+}
+
+#endif
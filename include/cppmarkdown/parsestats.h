@@ -0,0 +1,66 @@
+#ifndef _h_cppmarkdownparsestats
+#define _h_cppmarkdownparsestats
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/phaseobserver.h"
+
+#include <array>
+#include <chrono>
+
+namespace Markdown
+{
+    class ElementContainer;
+
+    // Metrics of parsing a single document, filled by Document::parse
+    struct ParseStats : public ThreadContext<ParseStats>
+    {
+        using TypeCounts = std::array<size_t, TypeCount>;
+
+        size_t bytes = 0; // Size of the source
+        size_t lines = 0;
+        TypeCounts elements{}; // Elements of the parsed document, nested ones included
+        size_t spans = 0; // Spans parsed, including the ones of elements discarded before the document was complete, not their clones
+        TypeCounts attempts{}; // New elements the block parsers offered a line to
+        TypeCounts rejections{}; // Attempts which the element rejected as invalid
+        size_t retries = 0; // Lines parsed again after the element they were offered to completed without them
+        size_t peakDepth = 0; // Nesting of the deepest element, 1 for top-level elements
+
+        // Time of the phases, excluding the phases nested in them - splitting the source counts as block parsing
+        double blockParseSeconds = 0.0;
+        double inlineParseSeconds = 0.0;
+        double finalizeSeconds = 0.0;
+
+        static size_t index(Type type)
+        {
+            return static_cast<size_t>(type);
+        }
+
+        size_t getElements(Type type) const { return this->elements[index(type)]; }
+        size_t getAttempts(Type type) const { return this->attempts[index(type)]; }
+        size_t getRejections(Type type) const { return this->rejections[index(type)]; }
+    };
+
+    // Activates the statistics and times the phases of parsing run during its lifetime
+    // The tracers active before keep receiving the events
+    class ParseStatsCollector : public PhaseAccumulator<std::chrono::steady_clock::duration>
+    {
+    public:
+        ParseStatsCollector(ParseStats& stats);
+
+        ParseStatsCollector(const ParseStatsCollector&) = delete;
+        ParseStatsCollector& operator=(const ParseStatsCollector&) = delete;
+
+        // Count the lines of the source and the elements parsed from it, and store the time of the phases
+        void finish(const std::string& source, const ElementContainer& elements);
+
+    protected:
+        virtual std::chrono::steady_clock::duration read() const override;
+
+    private:
+        ParseStats& stats;
+        ParseStats::ContextGuard statsGuard;
+        Tracer::ContextGuard guard;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef _h_cppmarkdownphaseobserver
+#define _h_cppmarkdownphaseobserver
+
+#include "cppmarkdown/tracer.h"
+
+#include <array>
+#include <vector>
+
+namespace Markdown
+{
+    // Notified whenever parsing enters or leaves a phase, e.g. to attribute performance counters to the phases
+    // Every traced operation enters its phase, so phases nest - lines are parsed while the source is split,
+    // and their text while the lines are parsed
+    // Activated with Tracer::ContextGuard like any other tracer
+    class PhaseObserver : public Tracer
+    {
+    public:
+        virtual void enter(Phase phase) = 0;
+        virtual void exit(Phase phase) = 0;
+
+        virtual void begin(const TraceEvent& event) override
+        {
+            this->enter(event.phase);
+        }
+
+        virtual void end(const TraceEvent& event) override
+        {
+            this->exit(event.phase);
+        }
+    };
+
+    // Attributes a measured value to the phase being run, a nested phase is excluded from its parent
+    // The value is read by the derived observer, e.g. the time or hardware counters, and has to support += and -
+    template<typename Value>
+    class PhaseAccumulator : public PhaseObserver
+    {
+    public:
+        static constexpr size_t PhaseCount = static_cast<size_t>(Phase::Render) + 1;
+
+        virtual void enter(Phase phase) override
+        {
+            this->charge();
+            this->stack.push_back(phase);
+        }
+
+        virtual void exit(Phase phase) override
+        {
+            this->charge();
+
+            // Scopes of the tracer leave the phases in reverse order
+            if (!this->stack.empty() && this->stack.back() == phase)
+                this->stack.pop_back();
+        }
+
+        const Value& getTotal(Phase phase) const
+        {
+            return this->totals.at(static_cast<size_t>(phase));
+        }
+
+        void reset()
+        {
+            this->totals.fill(Value());
+            this->stack.clear();
+        }
+
+    protected:
+        // Value at this moment, e.g. the time since a fixed point
+        virtual Value read() const = 0;
+
+    private:
+        std::array<Value, PhaseCount> totals{};
+        std::vector<Phase> stack;
+        Value last{};
+
+        // Add the value since the last change of the phase to the current phase
+        void charge()
+        {
+            Value now = this->read();
+            if (!this->stack.empty())
+                this->totals.at(static_cast<size_t>(this->stack.back())) += now - this->last;
+            this->last = now;
+        }
+    };
+}
+
+#endif
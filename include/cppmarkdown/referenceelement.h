@@ -26,6 +26,10 @@ namespace Markdown
         virtual std::string getText() const override { return ""; }
         virtual std::string getHtml() const override { return ""; }
         virtual std::string getMarkdown() const override { return ""; }
+        virtual void walk(ElementHandler& handler) const override;
+        virtual void freeze(FrozenWriter& writer) const override;
+        virtual void measure(MemoryUsage& usage) const override;
+        virtual void shrinkToFit() override;
 
     protected:
         Reference reference;
@@ -0,0 +1,96 @@
+#ifndef _h_cppmarkdownshareddocumentcache
+#define _h_cppmarkdownshareddocumentcache
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/frozendocument.h"
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPPMARKDOWN_SHARED_CACHE
+#endif
+
+#ifdef CPPMARKDOWN_SHARED_CACHE
+
+namespace Markdown
+{
+    // Frozen documents, see Document::freeze, stored in a memory segment shared between processes
+    // Each document is parsed once, by the first process asking for it, and published for the others,
+    // which render it straight from the segment. Lookups don't lock, entries are never removed or replaced
+    // Available on POSIX systems only, errors of the system calls are thrown as std::system_error
+    class SharedDocumentCache
+    {
+    public:
+        struct Statistics
+        {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint64_t parses = 0; // Documents parsed by get, across all of the processes
+            uint64_t entries = 0;
+            uint64_t size = 0; // Bytes used by the entries
+            uint64_t capacity = 0;
+        };
+
+    public:
+        // Anonymous segment, shared with the processes forked after it's created
+        SharedDocumentCache(size_t capacity, size_t slotCount = 16 * 1024);
+        // Named segment, created with shm_open - fails if it already exists, see remove
+        SharedDocumentCache(const std::string& name, size_t capacity, size_t slotCount = 16 * 1024);
+        // Attach to the named segment created by another process
+        static SharedDocumentCache open(const std::string& name);
+        static void remove(const std::string& name);
+
+        SharedDocumentCache(SharedDocumentCache&& other) noexcept;
+        SharedDocumentCache(const SharedDocumentCache&) = delete;
+        SharedDocumentCache& operator=(const SharedDocumentCache&) = delete;
+        ~SharedDocumentCache();
+
+        // Frozen document of the source, viewing the segment - it has to outlive the document
+        std::optional<FrozenDocument> find(std::string_view source, Type mask = Type::None);
+        // Find the document, parsing and publishing it on a miss
+        // If another process is parsing the same source, wait for it to publish the document
+        // A document that can't be stored is frozen into the fallback buffer instead
+        FrozenDocument get(std::string_view source, std::string& fallback, Type mask = Type::None);
+
+        Statistics getStatistics() const;
+
+        // How long get waits for another process before parsing the source itself
+        // A source claimed by a process which died is then parsed and published again. The claimer is recognized
+        // by its process id and, where /proc is available, its start time, so a reused id doesn't keep the claim.
+        // Without /proc, a claimer that can't be signalled (EPERM - another user, or another PID namespace
+        // sharing a named segment) is considered alive, and the waiting processes parse the source on their own
+        std::chrono::milliseconds waitTimeout = std::chrono::milliseconds(1000);
+
+    private:
+        struct Header;
+        struct Slot;
+
+        char* data = nullptr;
+        size_t mappedSize = 0;
+
+        SharedDocumentCache() = default;
+
+        void map(int fd, size_t size);
+        void initialize(size_t slotCount);
+
+        Header& header() const;
+        Slot* slots() const;
+
+        // Parse the source in the slot claimed by this process and publish the document,
+        // frozen into the fallback if it doesn't fit or if another process took the claim over
+        FrozenDocument parse(Slot& slot, uint64_t claim, std::string_view source, std::string& fallback, Type mask);
+        // Publish the frozen document in the claimed slot, returns the offset of the entry or zero if it doesn't fit
+        uint64_t publish(Slot& slot, uint64_t claim, std::string_view source, const std::string& frozen);
+        std::optional<FrozenDocument> read(uint64_t offset, std::string_view source) const;
+
+        static uint64_t makeKey(std::string_view source, Type mask);
+    };
+}
+
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef _h_cppmarkdownsourcemap
+#define _h_cppmarkdownsourcemap
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+
+namespace Markdown
+{
+    struct Span;
+
+    // Line and column of a byte offset, both starting at 1, column counts bytes
+    struct SourceLocation
+    {
+        size_t line = 0;
+        size_t column = 0;
+    };
+
+    // Run of parsed content taken from a contiguous run of the source, see SourceMap::ContentGuard
+    struct ContentPart
+    {
+        uint32_t content; // Offset of the run in the content
+        uint32_t source; // Offset of the run in the source
+    };
+    // Parts of the content ordered by their offsets, each lasting until the next one
+    using ContentOrigin = std::vector<ContentPart>;
+
+    // Records source ranges of elements and spans parsed while the map is active
+    // The map keeps the parsed source and an index of line starts, offsets are converted to lines in O(log n)
+    // Parsing with no active map records nothing
+    class SourceMap : public ThreadContext<SourceMap>
+    {
+    public:
+        // Text entries parsed in the scope were parsed from content taken from the source as the origin describes,
+        // set by the element which removed the syntax around the content - spans of other text entries get no ranges
+        struct ContentGuard
+        {
+            ContentGuard(ContentOrigin origin);
+            ContentGuard(const ContentGuard&) = delete;
+            ContentGuard& operator=(const ContentGuard&) = delete;
+            ~ContentGuard();
+
+        private:
+            SourceMap* map;
+            ContentOrigin origin;
+            const ContentOrigin* previous;
+        };
+
+        // Extends the element over the current line while it's being parsed
+        // Rejected line is taken back, e.g. when the element is invalid or completes without the line
+        class Tracker
+        {
+        public:
+            Tracker(Element& element)
+                : map(SourceMap::current)
+            {
+                if (this->map)
+                    this->begin(element);
+            }
+
+            ~Tracker()
+            {
+                if (this->map)
+                    this->end();
+            }
+
+            void reject()
+            {
+                this->rejected = true;
+            }
+
+        private:
+            SourceMap* map;
+            Element* element = nullptr;
+            SourceRange previousRange;
+            bool rejected = false;
+
+            void begin(Element& element);
+            void end();
+        };
+
+    public:
+        // Add next line of the source, without the line ending
+        void addLine(std::string_view line);
+        void clear();
+
+        const std::string& getSource() const;
+        std::string_view getText(SourceRange range) const;
+
+        size_t getLineCount() const;
+        SourceLocation getLocation(size_t offset) const;
+        // Range of the line, without the line ending
+        SourceRange getLineRange(size_t line) const;
+
+        // Extend the element over the current line
+        void extend(Element& element) const;
+        // Source offset of text ending the current line, e.g. a line without the syntax of the blocks enclosing it
+        // SourceRange::npos if the line doesn't end with the text
+        uint32_t getLineOffset(std::string_view text) const;
+        // Origin of content ending the current line of the active map, empty with no active map
+        static ContentOrigin getLineOrigin(std::string_view text);
+        // Convert ranges of the spans, set relative to the parsed content of given length, to the source ranges
+        // using the content origin
+        void locate(std::vector<std::unique_ptr<Span>>::iterator begin, std::vector<std::unique_ptr<Span>>::iterator end, size_t length) const;
+
+        static SourceRange join(SourceRange a, SourceRange b);
+
+    private:
+        std::string source;
+        std::vector<uint32_t> lineStarts;
+        SourceRange line; // Last added line
+        const ContentOrigin* origin = nullptr; // Origin of the parsed content, see ContentGuard
+    };
+}
+
+#endif
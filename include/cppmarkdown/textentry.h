@@ -2,10 +2,12 @@
 #define _h_cppmarkdowntextentry
 
 #include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/elementhandler.h"
 
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 namespace Markdown
 {
@@ -17,7 +19,8 @@ namespace Markdown
     enum class SpanSearchFlags
     {
         Normal = 0x00,
-        AddEmpty = 0x01
+        AddEmpty = 0x01,
+        Literal = 0x02 // Styles and escapes are not parsed, the markdown is kept as written
     };
 
     class SpanContainer
@@ -53,6 +56,7 @@ namespace Markdown
         std::string text;
         std::shared_ptr<MarkdownStyle> style;
         std::vector<std::unique_ptr<Span>> children;
+        SourceRange sourceRange; // Only recorded while parsing with an active SourceMap
 
         Span(const std::string& text, std::shared_ptr<MarkdownStyle> style, const std::vector<std::unique_ptr<Span>>& children = {});
         virtual ~Span() = default;
@@ -72,7 +76,24 @@ namespace Markdown
         virtual std::string getHtml() const;
         virtual std::string getMarkdown() const;
 
+        // Report span's text and styles to the handler
+        virtual void walk(ElementHandler& handler) const;
+        // Write the span and its children to the frozen document
+        virtual void freeze(FrozenWriter& writer) const;
+        // Add the memory held by the span and its children to the element type owning the text
+        virtual void measure(MemoryUsage& usage, Type owner) const;
+        virtual void shrinkToFit();
+
     protected:
+        // Report the styled span with given attributes, enclosing its content
+        void walk(ElementHandler& handler, const Attributes& attributes) const;
+        // Report the children of the span, or its text if it has none
+        void walkContent(ElementHandler& handler) const;
+        // Tags and text of the span, followed by its children
+        void freezeContent(FrozenWriter& writer) const;
+        // Span object of given size, its text, style and children
+        void measureSpan(MemoryUsage& usage, Type owner, size_t size) const;
+
         virtual std::vector<std::unique_ptr<Span>> findStyle(
             const std::string& source,
             const std::vector<std::string>& autoescape,
@@ -92,13 +113,15 @@ namespace Markdown
     public:
         std::vector<std::unique_ptr<Span>> spans;
 
-        TextEntry(const std::string& content = "", const std::shared_ptr<MarkdownStyle> defaultStyle = nullptr);
+        TextEntry(const std::string& content = "", const std::shared_ptr<MarkdownStyle> defaultStyle = nullptr, SpanSearchFlags searchFlags = SpanSearchFlags::AddEmpty);
         TextEntry(const TextEntry& b);
         TextEntry(TextEntry&& b) = default;
 
         TextEntry& operator=(const TextEntry& b);
         TextEntry& operator=(TextEntry&& b) = default;
 
+        virtual void parse(const std::string& markdown, const std::shared_ptr<MarkdownStyle> defaultStyle = nullptr, SpanSearchFlags searchFlags = SpanSearchFlags::AddEmpty) override;
+
         virtual Container& getSpans() override;
         virtual const Container& getSpans() const override;
 
@@ -107,6 +130,12 @@ namespace Markdown
         std::string getInnerHtml() const;
         std::string getMarkdown() const;
 
+        void walk(ElementHandler& handler) const;
+        void freeze(FrozenWriter& writer) const;
+        // Add the memory of the spans, the entry itself is a part of its owner
+        void measure(MemoryUsage& usage, Type owner) const;
+        void shrinkToFit();
+
         bool empty() const;
     };
 
@@ -131,6 +160,21 @@ namespace Markdown
             }
         };
 
+        // Scans done by the earlier searches of the same source, findStyle keeps one for every style
+        // so that searching the style again doesn't scan the same part of the source twice
+        struct SearchState
+        {
+            // First unescaped occurrence of a character found by a scan starting at given position
+            struct Scan
+            {
+                size_t from = std::string::npos;
+                size_t found = std::string::npos;
+            };
+
+            std::unordered_map<char, Scan> scans;
+            std::unordered_map<size_t, size_t> rechecks; // Closing candidate rejected by GenericStyle and the closing it led to
+        };
+
         std::string markdownOpening = "";
         std::string markdownClosing = "";
         Style style;
@@ -165,7 +209,16 @@ namespace Markdown
             return std::make_shared<T>("", "", opening, closing);
         }
 
-        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap) const = 0;
+        // Find the first occurrence of the style at or after the offset
+        // Searching again from any offset up to the found position must find the same occurrence, and nothing found
+        // means there is nothing at any later offset either - findStyle searches every style once per found occurrence
+        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap, SearchState& state) const = 0;
+
+        // Position of the text of a found span relative to its first markdown character
+        virtual size_t getTextOffset() const
+        {
+            return this->markdownOpening.size();
+        }
     };
 
     struct GenericStyle : public MarkdownStyle
@@ -182,7 +235,7 @@ namespace Markdown
 
         virtual bool operator==(const MarkdownStyle& b) const override;
 
-        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap) const override;
+        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap, SearchState& state) const override;
     };
 
     struct LinkStyle : public MarkdownStyle
@@ -190,20 +243,25 @@ namespace Markdown
         struct LinkSpan : Span
         {
             std::string url;
-            ReferenceManager* refman = nullptr;
+            std::shared_ptr<const ReferenceManager> refman; // Set for reference-style syntax, kept alive by the span
 
             LinkSpan(const std::string& text, const std::string& url, std::shared_ptr<MarkdownStyle> style,
-                     const std::vector<std::unique_ptr<Span>>& children = {}, ReferenceManager* refman = nullptr);
+                     const std::vector<std::unique_ptr<Span>>& children = {}, std::shared_ptr<const ReferenceManager> refman = nullptr);
 
             std::unique_ptr<Span> clone() const override;
 
             virtual std::string getHtml() const override;
             virtual std::string getMarkdown() const override;
+            virtual void walk(ElementHandler& handler) const override;
+            virtual void freeze(FrozenWriter& writer) const override;
+            virtual void measure(MemoryUsage& usage, Type owner) const override;
+            virtual void shrinkToFit() override;
         };
 
         virtual bool operator==(const MarkdownStyle& b) const override;
 
-        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap) const override;
+        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap, SearchState& state) const override;
+        virtual size_t getTextOffset() const override;
     };
 
     struct ImageStyle : public MarkdownStyle
@@ -211,20 +269,25 @@ namespace Markdown
         struct ImageSpan : Span
         {
             std::string url;
-            ReferenceManager* refman = nullptr;
+            std::shared_ptr<const ReferenceManager> refman; // Set for reference-style syntax, kept alive by the span
 
             ImageSpan(const std::string& text, const std::string& url, std::shared_ptr<MarkdownStyle> style,
-                const std::vector<std::unique_ptr<Span>>& children = {}, ReferenceManager* refman = nullptr);
+                const std::vector<std::unique_ptr<Span>>& children = {}, std::shared_ptr<const ReferenceManager> refman = nullptr);
 
             std::unique_ptr<Span> clone() const override;
 
             virtual std::string getHtml() const override;
             virtual std::string getMarkdown() const override;
+            virtual void walk(ElementHandler& handler) const override;
+            virtual void freeze(FrozenWriter& writer) const override;
+            virtual void measure(MemoryUsage& usage, Type owner) const override;
+            virtual void shrinkToFit() override;
         };
 
         virtual bool operator==(const MarkdownStyle& b) const override;
 
-        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap) const override;
+        virtual Result findIn(const std::string& str, size_t offset, const StyleContainer& stylemap, SearchState& state) const override;
+        virtual size_t getTextOffset() const override;
     };
 
     DEFINE_BITFIELD(TextEntry::HtmlOptions);
@@ -0,0 +1,137 @@
+#ifndef _h_cppmarkdowntracer
+#define _h_cppmarkdowntracer
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Markdown
+{
+    // Phases of parsing and rendering a document
+    enum class Phase
+    {
+        LineSplit, // Splitting the source into lines
+        BlockParse, // Parsing lines into block elements
+        InlineParse, // Parsing text into spans
+        Finalize, // Finalizing the elements of the document
+        Render // Rendering the document
+    };
+
+    const char* getPhaseName(Phase phase);
+
+    // Operation reported to the tracer when it begins and ends
+    struct TraceEvent
+    {
+        const char* name; // Static name of the operation, e.g. "parseLine"
+        Phase phase;
+        Type type; // Type of the element the operation runs on, None if there is none
+        size_t bytes; // Size of the parsed source or of the rendered output
+    };
+
+    // Receives begin and end events of the traced operations - parsing the source and its lines,
+    // finalizing the elements, parsing their text and rendering them
+    // Tracers activated while others are active receive the events along with them, innermost first
+    class Tracer : public ThreadContext<Tracer>
+    {
+    public:
+        // Activates the tracer in addition to the active ones, a tracer which is already active isn't added again
+        struct ContextGuard : public ThreadContext<Tracer>::ContextGuard
+        {
+            ContextGuard(Tracer& tracer);
+            ~ContextGuard();
+
+        private:
+            Tracer* added = nullptr;
+        };
+
+        // Reports the operation to the active tracer for the lifetime of the scope
+        class Scope
+        {
+        public:
+            Scope(const char* name, Phase phase, Type type = Type::None, size_t bytes = 0)
+                : tracer(Tracer::current)
+            {
+                if (this->tracer)
+                {
+                    this->event = { name, phase, type, bytes };
+                    for (Tracer* tracer = this->tracer; tracer; tracer = tracer->next)
+                        tracer->begin(this->event);
+                }
+            }
+
+            ~Scope()
+            {
+                for (Tracer* tracer = this->tracer; tracer; tracer = tracer->next)
+                    tracer->end(this->event);
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+            // Details known only once the operation ran, reported with its end
+            void setType(Type type)
+            {
+                if (this->tracer)
+                    this->event.type = type;
+            }
+
+            void setBytes(size_t bytes)
+            {
+                if (this->tracer)
+                    this->event.bytes = bytes;
+            }
+
+        private:
+            Tracer* tracer;
+            TraceEvent event;
+        };
+
+    public:
+        virtual ~Tracer() = default;
+
+        virtual void begin(const TraceEvent& event) = 0;
+        virtual void end(const TraceEvent& event) = 0;
+
+        // Whether the tracer receives the events
+        bool isActive() const;
+
+    private:
+        Tracer* next = nullptr; // Tracer active before this one
+    };
+
+    // Records the events and writes them as Chrome trace_event JSON, to be opened in chrome://tracing or Perfetto
+    // Events are only stored while tracing, so that formatting them doesn't skew the recorded times
+    class ChromeTraceSink : public Tracer
+    {
+    public:
+        ChromeTraceSink();
+
+        virtual void begin(const TraceEvent& event) override;
+        virtual void end(const TraceEvent& event) override;
+
+        size_t getEventCount() const;
+        void clear();
+
+        void write(std::ostream& out) const;
+        std::string getJson() const;
+
+    private:
+        struct Record
+        {
+            TraceEvent event;
+            bool begin;
+            int64_t time; // Nanoseconds since the sink was created
+        };
+
+        std::chrono::steady_clock::time_point start;
+        std::vector<Record> records;
+
+        void record(const TraceEvent& event, bool begin);
+    };
+}
+
+#endif
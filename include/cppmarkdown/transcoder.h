@@ -0,0 +1,67 @@
+#ifndef _h_cppmarkdowntranscoder
+#define _h_cppmarkdowntranscoder
+
+#include "cppmarkdown/cppmarkdowncommon.h"
+#include "cppmarkdown/elementstream.h"
+
+#include <string_view>
+#include <istream>
+#include <functional>
+#include <deque>
+
+namespace Markdown
+{
+    // Converts Markdown to HTML, writing every top-level block to the sink as soon as it's complete.
+    // Blocks are not retained after being written, only the reference definitions are kept.
+    // The output is the same as Document::getHtml, except for references used before their definition:
+    //  - ReferencePolicy::Immediate writes such blocks right away, with the reference unresolved (empty url),
+    //  - ReferencePolicy::Defer holds such block, and all of the following blocks, until the reference is
+    //    defined or the input ends - memory use then depends on the distance between use and definition
+    class Transcoder
+    {
+    public:
+        enum class ReferencePolicy
+        {
+            Immediate,
+            Defer
+        };
+
+        using Sink = std::function<void(std::string_view html)>;
+        // Read up to size bytes into buffer, returns the number of bytes read, 0 at the end of input
+        using Reader = std::function<size_t(char* buffer, size_t size)>;
+
+        bool addDocumentTags = true; // Wrap the output with the same tags as Document::getHtml
+        bool addCharset = false;
+
+        Transcoder(Sink sink, ReferencePolicy policy = ReferencePolicy::Immediate, Type mask = Type::None, const ParseLimits& limits = ParseLimits());
+        Transcoder(const Transcoder&) = delete;
+        Transcoder& operator=(const Transcoder&) = delete;
+
+        // Parse chunk of Markdown, writing all of the blocks completed so far
+        void feed(std::string_view chunk);
+        // Write all of the remaining blocks and the closing tags
+        void finish();
+
+        // Limits exceeded by the content transcoded so far, see ParseLimits
+        Limit getExceededLimits() const;
+
+        static void transcode(std::istream& input, Sink sink, ReferencePolicy policy = ReferencePolicy::Immediate, const ParseLimits& limits = ParseLimits());
+        static void transcode(Reader reader, Sink sink, ReferencePolicy policy = ReferencePolicy::Immediate, const ParseLimits& limits = ParseLimits());
+
+    private:
+        Sink sink;
+        ReferencePolicy policy;
+        ElementStream stream;
+        std::deque<std::shared_ptr<Element>> deferred;
+        bool started = false;
+
+        void start();
+        void complete(std::shared_ptr<Element> element);
+        void write(const Element& element);
+        void flushDeferred(bool force);
+
+        static bool hasUnresolvedReferences(const Element& element);
+    };
+}
+
+#endif
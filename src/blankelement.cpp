@@ -1,4 +1,7 @@
 #include "cppmarkdown/blankelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/linebreakelement.h"
 
 #include <sstream>
@@ -6,8 +9,8 @@
 
 namespace Markdown
 {
-    BlankElement::BlankElement(const std::string& text)
-        : text(text)
+    BlankElement::BlankElement(const std::string& text, SpanSearchFlags searchFlags)
+        : text(text, nullptr, searchFlags)
     {
     }
 
@@ -31,6 +34,32 @@ namespace Markdown
         return this->text.getHtml();
     }
 
+    void BlankElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::Blank, {});
+        this->text.walk(handler);
+        handler.exitBlock(Type::Blank);
+    }
+
+    void BlankElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::Blank);
+        this->text.freeze(writer);
+        writer.endNode();
+    }
+
+    void BlankElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        this->text.measure(usage, Type::Blank);
+    }
+
+    void BlankElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->text.shrinkToFit();
+    }
+
     // Util
 
     std::shared_ptr<BlankElement> toBlankElement(const Element& element)
@@ -0,0 +1,191 @@
+#include "cppmarkdown/blockcache.h"
+
+#include <algorithm>
+
+namespace Markdown
+{
+    // Shard
+
+    std::list<BlockCache::Entry>::iterator BlockCache::Shard::find(uint64_t key, std::string_view source, uint64_t context)
+    {
+        auto range = this->index.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const Entry& entry = *it->second;
+            if (entry.context == context && entry.source == source)
+                return it->second;
+        }
+        return this->entries.end();
+    }
+
+    void BlockCache::Shard::erase(std::list<Entry>::iterator it)
+    {
+        auto range = this->index.equal_range(it->key);
+        for (auto indexIt = range.first; indexIt != range.second; ++indexIt)
+        {
+            if (indexIt->second == it)
+            {
+                this->index.erase(indexIt);
+                break;
+            }
+        }
+
+        this->size -= it->size();
+        this->entries.erase(it);
+    }
+
+    void BlockCache::Shard::evict(size_t required)
+    {
+        while (!this->entries.empty() && this->size + required > this->capacity)
+        {
+            this->erase(std::prev(this->entries.end()));
+            this->statistics.evictions++;
+        }
+    }
+
+    // Block cache
+
+    BlockCache::BlockCache(size_t capacity, size_t shardCount)
+        : capacity(capacity)
+    {
+        shardCount = std::max<size_t>(shardCount, 1);
+        for (size_t i = 0; i < shardCount; i++)
+        {
+            this->shards.push_back(std::make_unique<Shard>());
+            this->shards.back()->capacity = capacity / shardCount;
+        }
+    }
+
+    BlockCache& BlockCache::get()
+    {
+        static BlockCache cache;
+        return cache;
+    }
+
+    std::optional<std::string> BlockCache::find(std::string_view source, uint64_t context)
+    {
+        uint64_t key = makeKey(source, context);
+        Shard& shard = this->getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.find(key, source, context);
+        if (it == shard.entries.end())
+        {
+            shard.statistics.misses++;
+            return {};
+        }
+
+        shard.statistics.hits++;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it);
+        return it->html;
+    }
+
+    void BlockCache::insert(std::string_view source, uint64_t context, const std::string& html)
+    {
+        uint64_t key = makeKey(source, context);
+        Shard& shard = this->getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.find(key, source, context);
+        if (it != shard.entries.end())
+            shard.erase(it);
+
+        size_t size = source.size() + html.size();
+        if (size > shard.capacity)
+            return;
+
+        shard.evict(size);
+        shard.entries.push_front({ key, context, std::string(source), html });
+        shard.index.emplace(key, shard.entries.begin());
+        shard.size += size;
+    }
+
+    void BlockCache::invalidate(std::string_view source, uint64_t context)
+    {
+        uint64_t key = makeKey(source, context);
+        Shard& shard = this->getShard(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.find(key, source, context);
+        if (it != shard.entries.end())
+            shard.erase(it);
+    }
+
+    void BlockCache::clear()
+    {
+        for (auto& shard : this->shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->entries.clear();
+            shard->index.clear();
+            shard->size = 0;
+        }
+    }
+
+    size_t BlockCache::getCapacity() const
+    {
+        return this->capacity;
+    }
+
+    void BlockCache::setCapacity(size_t capacity)
+    {
+        this->capacity = capacity;
+        for (auto& shard : this->shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->capacity = capacity / this->shards.size();
+            shard->evict(0);
+        }
+    }
+
+    BlockCache::Statistics BlockCache::getStatistics() const
+    {
+        Statistics result;
+        for (const auto& shard : this->shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            result.hits += shard->statistics.hits;
+            result.misses += shard->statistics.misses;
+            result.evictions += shard->statistics.evictions;
+            result.entries += shard->entries.size();
+            result.size += shard->size;
+        }
+        return result;
+    }
+
+    void BlockCache::resetStatistics()
+    {
+        for (auto& shard : this->shards)
+        {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->statistics = Statistics();
+        }
+    }
+
+    uint64_t BlockCache::hash(std::string_view data, uint64_t seed)
+    {
+        uint64_t result = seed;
+        for (char c : data)
+        {
+            result ^= static_cast<unsigned char>(c);
+            result *= 1099511628211ull;
+        }
+        return result;
+    }
+
+    uint64_t BlockCache::hash(uint64_t value, uint64_t seed)
+    {
+        return hash(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), seed);
+    }
+
+    uint64_t BlockCache::makeKey(std::string_view source, uint64_t context)
+    {
+        return hash(source, hash(context));
+    }
+
+    BlockCache::Shard& BlockCache::getShard(uint64_t key)
+    {
+        // Low bits of FNV-1a are weaker, mix in the high ones
+        return *this->shards.at((key ^ (key >> 32)) % this->shards.size());
+    }
+}
@@ -1,12 +1,35 @@
 #include "cppmarkdown/blockquoteelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/cppmarkdowncommon.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/parselimits.h"
 
 #include <sstream>
 
 namespace Markdown
 {
+    namespace
+    {
+        // Levels of quotes the block depth limit allows at the current depth
+        int getQuoteLevels()
+        {
+            ParseLimiter* limiter = ParseLimiter::get();
+            return limiter ? static_cast<int>(std::min<size_t>(limiter->getBlockLevels(), INT_MAX)) : INT_MAX;
+        }
+
+        // Report markers left in the text by the limit, the text is parsed as plain text
+        void checkQuoteLevels(const std::string& line, size_t pos)
+        {
+            if (pos < line.size() && line[pos] == '>')
+                ParseLimiter::get()->exceed(Limit::BlockDepth);
+        }
+    }
+
     BlockquoteElement::BlockquoteElement(const std::string& text)
+        : elements(this)
     {
         if (!text.empty())
             this->elements.parse(text);
@@ -19,15 +42,17 @@ namespace Markdown
 
     ParseResult BlockquoteElement::parse(const std::string& line, std::shared_ptr<Element>)
     {
-        int level = getBlockquoteLevel(line);
+        int level = 0;
+        int maxLevel = getQuoteLevels();
+        size_t pos = getBlockquoteTextPosition(line, level, maxLevel);
+        if (maxLevel != INT_MAX)
+            checkQuoteLevels(line, pos);
 
         if (level == -1)
             return ParseResult(ParseCode::Invalid);
 
-        auto el = std::make_shared<BlockquoteElement>();
-        el->level = level;
-
-        this->buffer += line + "\n";
+        ParseLimiter::BlockScope depth(level);
+        this->supplyText(level, line.substr(pos));
         return ParseResult(ParseCode::RequestMore);
     }
 
@@ -36,20 +61,54 @@ namespace Markdown
         if (line.empty())
             return ParseResult(ParseCode::ElementCompleteParseNext);
 
-        size_t pos = getBlockquoteLevel(line);
-        if (pos == -1)
+        int level = 0;
+        int maxLevel = getQuoteLevels();
+        size_t pos = getBlockquoteTextPosition(line, level, maxLevel);
+        if (level == -1)
             return ParseResult(ParseCode::ElementCompleteParseNext);
 
-        this->buffer += line + "\n";
+        if (maxLevel != INT_MAX)
+            checkQuoteLevels(line, pos);
+
+        ParseLimiter::BlockScope depth(level);
+        this->supplyText(level, line.substr(pos));
 
         return ParseResult(ParseCode::RequestMore);
     }
 
     void BlockquoteElement::finalize()
     {
-        std::string source = getEligibleText(this->buffer);
-        this->elements.parse(source);
-        this->buffer.clear();
+        // Closes any nested blockquotes which are still open
+        this->elements.finishParsing(this->state);
+    }
+
+    void BlockquoteElement::supplyText(int level, const std::string& text)
+    {
+        // Nested blockquotes are not parsed with parseElement
+        if (SourceMap* sourceMap = SourceMap::get())
+            sourceMap->extend(*this);
+
+        if (level <= 1)
+        {
+            // Any nested blockquote still open completes on its own when given unquoted text
+            this->elements.parseNextLine(text, this->state);
+            return;
+        }
+
+        std::shared_ptr<BlockquoteElement> nested;
+        if (this->state.activeElement && this->state.activeElement->getType() == Type::Blockquote)
+        {
+            nested = std::static_pointer_cast<BlockquoteElement>(this->state.activeElement);
+        }
+        else
+        {
+            this->elements.finishParsing(this->state);
+            nested = std::make_shared<BlockquoteElement>();
+            this->state.activeElement = nested;
+            this->state.previousElement = nested;
+        }
+
+        nested->supplyText(level - 1, text);
     }
 
     std::string BlockquoteElement::getText() const
@@ -88,6 +147,38 @@ namespace Markdown
         return result;
     }
 
+    void BlockquoteElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::Blockquote, {});
+        for (const auto& element : this->elements)
+        {
+            element->walk(handler);
+        }
+        handler.exitBlock(Type::Blockquote);
+    }
+
+    void BlockquoteElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::Blockquote);
+        for (const auto& element : this->elements)
+        {
+            element->freeze(writer);
+        }
+        writer.endNode();
+    }
+
+    void BlockquoteElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        this->elements.measureElements(usage, Type::Blockquote);
+    }
+
+    void BlockquoteElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->elements.shrinkElements();
+    }
+
     std::string BlockquoteElement::dump(int indent) const
     {
         std::string result = Element::dump(indent) + "\n";
@@ -106,12 +197,30 @@ namespace Markdown
         return -1;
     }
 
+    size_t BlockquoteElement::getBlockquoteTextPosition(const std::string& line, int& level, int maxLevel)
+    {
+        level = 0;
+        size_t pos = line.find_first_not_of(' ');
+        while (pos != std::string::npos && line[pos] == '>' && level < maxLevel)
+        {
+            level++;
+            pos = line.find_first_not_of(' ', pos + 1);
+        }
+
+        if (level == 0)
+            level = -1;
+
+        return pos == std::string::npos ? line.size() : pos;
+    }
+
     std::string BlockquoteElement::getBlockquoteText(const std::string& line)
     {
         auto pos = line.find_first_not_of('>');
         if (pos == std::string::npos)
             return "";
         pos = line.find_first_not_of(' ', pos);
+        if (pos == std::string::npos)
+            return "";
         return line.substr(pos);
     }
 
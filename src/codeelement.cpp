@@ -1,4 +1,7 @@
 #include "cppmarkdown/codeelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/html.h"
 
 #include <cassert>
@@ -18,6 +21,28 @@ namespace Markdown
     {
         if (line.empty())
             return ParseResult(ParseCode::Invalid);
+
+        size_t fencePos = 0;
+        if (size_t length = getFenceLength(line, this->fenceChar, fencePos))
+        {
+            size_t infoBegin = line.find_first_not_of(" \t", fencePos + length);
+            if (infoBegin != std::string::npos)
+            {
+                size_t infoEnd = line.find_last_not_of(" \t");
+                this->language = line.substr(infoBegin, infoEnd - infoBegin + 1);
+
+                // Backtick fence cannot have backticks in its info string
+                if (this->fenceChar == '`' && this->language.find('`') != std::string::npos)
+                {
+                    this->language.clear();
+                    this->fenceChar = 0;
+                    return ParseResult(ParseCode::Invalid);
+                }
+            }
+
+            this->fenceLength = length;
+            return ParseResult(ParseCode::RequestMore);
+        }
         
         if (previous && previous->getType() != Type::LineBreak)
             // Must have line break before code block
@@ -31,8 +56,7 @@ namespace Markdown
             return ParseResult(ParseCode::Invalid);
         }
 
-        std::string code = getCodeText(line);
-        this->text += code;
+        this->appendLine(line, getCodeTextPosition(line));
 
         // Previous element must be a line break
         // Since this is block-type element anyways - the line break is redundant - remove it
@@ -41,6 +65,19 @@ namespace Markdown
 
     ParseResult CodeElement::supply(const std::string& line, std::shared_ptr<Element>)
     {
+        if (this->isFenced())
+        {
+            char closingChar = 0;
+            size_t closingPos = 0;
+            size_t closingLength = getFenceLength(line, closingChar, closingPos);
+            if (closingLength >= this->fenceLength && closingChar == this->fenceChar && line.find_first_not_of(" \t", closingPos + closingLength) == std::string::npos)
+                return ParseResult(ParseCode::ElementComplete);
+
+            // Fenced code is kept verbatim, including empty lines
+            this->appendLine(line, 0);
+            return ParseResult(ParseCode::RequestMore);
+        }
+
         if (line.empty())
             return ParseResult(ParseCode::ElementCompleteParseNext);
 
@@ -48,8 +85,7 @@ namespace Markdown
         if (pos == 0)
             return ParseResult(ParseCode::ElementCompleteParseNext);
 
-        std::string code = getCodeText(line);
-        this->text += "\n" + code;
+        this->appendLine(line, getCodeTextPosition(line));
 
         return ParseResult(ParseCode::RequestMore);
     }
@@ -61,26 +97,102 @@ namespace Markdown
 
     std::string CodeElement::getHtml() const
     {
-        auto& tag = HtmlProvider::get().getCode();
-        return tag.first + this->text + tag.second;
+        const auto& tag = HtmlProvider::get().getCode();
+
+        std::string result;
+        result.reserve(tag.first.size() + this->text.size() + tag.second.size());
+        result.append(tag.first);
+        appendEscapedHtml(result, this->text);
+        result.append(tag.second);
+        return result;
     }
 
     std::string CodeElement::getMarkdown() const
     {
-        auto splitted = split(this->getText(), '\n');
+        if (this->isFenced())
+        {
+            std::string fence(this->fenceLength, this->fenceChar);
+
+            std::string result;
+            result.reserve(fence.size() * 2 + this->language.size() + this->text.size() + 2);
+            result.append(fence).append(this->language).append(1, '\n');
+            if (!this->text.empty())
+                result.append(this->text).append(1, '\n');
+            result.append(fence);
+            return result;
+        }
+
+        static const std::string indent = "    ";
+
+        size_t lines = std::count(this->text.begin(), this->text.end(), '\n') + 1;
+
         std::string result;
-        for (const auto& line : splitted)
+        result.reserve(this->text.size() + lines * indent.size());
+
+        size_t begin = 0;
+        while (begin <= this->text.size())
         {
-            result += "    " + line + "\n";
+            size_t end = this->text.find('\n', begin);
+            if (end == std::string::npos)
+                end = this->text.size();
+
+            result.append(indent).append(this->text, begin, end - begin);
+            if (end < this->text.size())
+                result.append(1, '\n');
+
+            begin = end + 1;
         }
-        result.pop_back();
+
         return result;
     }
 
+    void CodeElement::walk(ElementHandler& handler) const
+    {
+        Attributes attributes;
+        if (!this->language.empty())
+            attributes.emplace_back("language", this->language);
+
+        handler.enterBlock(Type::Code, attributes);
+        if (!this->text.empty())
+            handler.text(this->text);
+        handler.exitBlock(Type::Code);
+    }
+
+    void CodeElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::Code);
+        writer.writeString(this->text);
+        writer.endNode();
+    }
+
+    void CodeElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        usage.addString(Type::Code, this->text);
+        usage.addString(Type::Code, this->language);
+    }
+
+    void CodeElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->text.shrink_to_fit();
+        this->language.shrink_to_fit();
+    }
+
+    bool CodeElement::isFenced() const
+    {
+        return this->fenceLength > 0;
+    }
+
     std::string CodeElement::getCodeText(const std::string& line)
+    {
+        return line.substr(getCodeTextPosition(line));
+    }
+
+    size_t CodeElement::getCodeTextPosition(const std::string& line)
     {
         if (line.empty())
-            return line;
+            return 0;
 
         auto chr = 0;
         if (line.front() == '\t')
@@ -90,9 +202,9 @@ namespace Markdown
         auto pos = line.find_first_not_of(chr);
 
         if (pos == std::string::npos)
-            return "";
+            return line.size();
 
-        return line.substr(pos);
+        return pos;
     }
 
     unsigned int CodeElement::getCodeLevel(const std::string& line)
@@ -117,4 +229,34 @@ namespace Markdown
 
         return pos;
     }
+
+    void CodeElement::appendLine(const std::string& line, size_t pos)
+    {
+        if (this->lineCount++ > 0)
+            this->text.push_back('\n');
+        this->text.append(line, pos, std::string::npos);
+    }
+
+    size_t CodeElement::getFenceLength(const std::string& line, char& fenceChar, size_t& pos)
+    {
+        // Fence may be indented by up to three spaces
+        pos = line.find_first_not_of(' ');
+        if (pos == std::string::npos || pos > 3)
+            return 0;
+
+        char chr = line[pos];
+        if (chr != '`' && chr != '~')
+            return 0;
+
+        size_t end = line.find_first_not_of(chr, pos);
+        if (end == std::string::npos)
+            end = line.size();
+
+        size_t length = end - pos;
+        if (length < 3)
+            return 0;
+
+        fenceChar = chr;
+        return length;
+    }
 }
@@ -1,6 +1,10 @@
 #include "cppmarkdown/cppmarkdowncommon.h"
 #include "cppmarkdown/document.h"
 #include "cppmarkdown/textentry.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/tracer.h"
+#include "cppmarkdown/memoryusage.h"
 
 #include <unordered_map>
 #include <sstream>
@@ -22,7 +26,11 @@ namespace Markdown
             { Type::Table, "Table" },
             { Type::LineBreak, "LineBreak" },
             { Type::Code, "Code" },
-            { Type::Line, "Line" }
+            { Type::Line, "Line" },
+            { Type::Reference, "Reference" },
+            { Type::Extension, "Extension" },
+            { Type::TableRow, "TableRow" },
+            { Type::TableCell, "TableCell" }
 		};
         auto it = map.find(type);
         if (it != map.end())
@@ -76,29 +84,130 @@ namespace Markdown
         return result;
     }
 
-    // References
+    const std::string& Element::getCachedHtml() const
+    {
+        return this->renderCache.getHtml([this] {
+            Tracer::Scope trace("render", Phase::Render, this->getType());
+            std::string html = this->getHtml();
+            trace.setBytes(html.size());
+            return html;
+        });
+    }
+
+    const std::string& Element::getCachedText() const
+    {
+        return this->renderCache.getText([this] {
+            Tracer::Scope trace("renderText", Phase::Render, this->getType());
+            std::string text = this->getText();
+            trace.setBytes(text.size());
+            return text;
+        });
+    }
+
+    void Element::invalidate()
+    {
+        for (Element* element = this; element; element = element->parent)
+            element->renderCache.clear();
+    }
+
+    void Element::walk(ElementHandler& handler) const
+    {
+        Type type = this->getType();
+        handler.enterBlock(type, {});
+
+        std::string text = this->getText();
+        if (!text.empty())
+            handler.text(text);
+
+        handler.exitBlock(type);
+    }
+
+    void Element::freeze(FrozenWriter& writer) const
+    {
+        writer.beginNode(FrozenNode::RenderedElement);
+        writer.writeInteger(static_cast<uint32_t>(this->getType()));
+        writer.writeString(this->getHtml());
+        writer.writeString(this->getText());
+        writer.endNode();
+    }
+
+    void Element::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(Element));
+    }
+
+    void Element::shrinkToFit()
+    {
+        this->renderCache.shrinkToFit();
+    }
 
-    ReferenceManager* ReferenceManager::current = nullptr;
+    void Element::measureElement(MemoryUsage& usage, size_t size) const
+    {
+        Type type = this->getType();
+        usage.addObject(type, size);
+        this->renderCache.measure(usage, type);
+    }
+
+    // Render cache
+
+    std::atomic<unsigned int> RenderCache::currentGeneration = 0;
+    thread_local const RenderCache* RenderCache::rendering = nullptr;
+
+    void RenderCache::dependOn(const ReferenceManager& manager)
+    {
+        if (RenderCache::rendering)
+        {
+            RenderCache::rendering->references = &manager;
+            RenderCache::rendering->referencesGeneration = manager.getGeneration();
+        }
+    }
+
+    void RenderCache::validate() const
+    {
+        unsigned int generation = RenderCache::currentGeneration;
+        if (this->generation == generation && (!this->references || this->references->getGeneration() == this->referencesGeneration))
+            return;
+
+        this->html.reset();
+        this->text.reset();
+        this->generation = generation;
+        this->references = nullptr;
+    }
 
-    ReferenceManager::ContextGuard::ContextGuard(ReferenceManager& manager)
+    void RenderCache::measure(MemoryUsage& usage, Type type) const
     {
-        ReferenceManager::current = &manager;
+        // Output of an older generation is held until it's requested again
+        if (this->html)
+            usage.addString(type, *this->html);
+        if (this->text)
+            usage.addString(type, *this->text);
     }
 
-    ReferenceManager::ContextGuard::~ContextGuard()
+    void RenderCache::shrinkToFit()
     {
-        ReferenceManager::current = nullptr;
+        if (this->html)
+            this->html->shrink_to_fit();
+        if (this->text)
+            this->text->shrink_to_fit();
     }
 
-    ReferenceManager* ReferenceManager::get()
+    // References
+
+    std::shared_ptr<const ReferenceManager> ReferenceManager::share() const
     {
-        return ReferenceManager::current;
+        if (std::shared_ptr<const ReferenceManager> owned = this->weak_from_this().lock())
+            return owned;
+
+        return std::shared_ptr<const ReferenceManager>(std::shared_ptr<const ReferenceManager>(), this);
     }
 
     void ReferenceManager::registerReference(const Reference& reference)
     {
         assert(current);
         this->references[reference.id] = reference;
+
+        // Links and images resolve references when rendered, their cached output is discarded
+        this->generation++;
     }
 
     std::optional<Reference> ReferenceManager::getReference(const std::string& name) const
@@ -109,17 +218,26 @@ namespace Markdown
         return {};
     }
 
+    const std::unordered_map<std::string, Reference>& ReferenceManager::getReferences() const
+    {
+        return this->references;
+    }
+
+    unsigned int ReferenceManager::getGeneration() const
+    {
+        return this->generation;
+    }
+
     bool isEscaped(const std::string& str, size_t position)
     {
         if (position == 0 || position >= str.length())
             return false;
 
-        if (str[position - 1] != '\\')
-            return false;
-
-        if (!isEscaped(str, position - 1))
-            return str[position - 1] == '\\';
+        // Escaped by an odd number of backslashes, counted without recursion so that long runs can't exhaust the stack
+        size_t backslashes = 0;
+        while (backslashes < position && str[position - backslashes - 1] == '\\')
+            backslashes++;
 
-        return false;
+        return backslashes % 2 == 1;
     }
 }
\ No newline at end of file
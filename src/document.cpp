@@ -1,5 +1,11 @@
 #include "cppmarkdown/document.h"
 #include "cppmarkdown/extensions.h"
+#include "cppmarkdown/elementstream.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/blockcache.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/html.h"
+#include "cppmarkdown/tracer.h"
 
 #include "cppmarkdown/paragraphelement.h"
 #include "cppmarkdown/linebreakelement.h"
@@ -15,11 +21,18 @@
 #include <sstream>
 #include <cassert>
 #include <functional>
+#include <algorithm>
+#include <stdexcept>
 
 namespace Markdown
 {
 	// Element container
 
+	ElementContainer::ElementContainer(Element* owner)
+		: owner(owner)
+	{
+	}
+
 	ParseResult ElementContainer::parseLine(const std::string& line, std::shared_ptr<Element> previous, std::shared_ptr<Element> active, Type mask)
 	{
 		ParserCollection parsers {
@@ -49,6 +62,7 @@ namespace Markdown
 	{
 		if (activeElement)
 		{
+			Tracer::Scope trace("finalize", Phase::BlockParse, activeElement->getType());
 			activeElement->finalize();
 			this->addElement(activeElement);
 			activeElement = nullptr;
@@ -57,73 +71,94 @@ namespace Markdown
 
 	void ElementContainer::parse(const std::string& content, Type mask)
 	{
-		std::shared_ptr<Element> activeElement = nullptr; // Element which requested more lines
-		std::shared_ptr<Element> previousElement = nullptr; // Currently parsed element
-		std::shared_ptr<Element> lastElement = nullptr; // Currently parsed element
+		Tracer::Scope trace("parse", Phase::LineSplit, Type::None, content.size());
+		ParseState state;
 
-		ParseResult result;
+		std::string line;
+		splitLines(content, line, [&](const std::string& completeLine) {
+			this->parseNextLine(completeLine, state, mask);
+		});
 
-		std::istringstream str(content);
-		for (std::string line; std::getline(str, line); )
-		{
-			bool retry = true;
-			while (retry)
-			{
-				retry = false;
-				result = this->parseLine(line, previousElement, activeElement, mask);
+		if (!line.empty())
+			this->parseNextLine(line, state, mask);
 
-				if (result.flags & ParseFlags::ErasePrevious && !this->elements.empty())
-				{
-					previousElement = nullptr;
-					this->elements.pop_back();
-				}
-
-				switch (result.code)
-				{
-				case ParseCode::Discard:
-					break;
+		this->finishParsing(state);
+	}
 
-				case ParseCode::ReplacePrevious:
-					this->finalizeElement(activeElement);
-					activeElement = nullptr;
+	void ElementContainer::parseNextLine(const std::string& line, ParseState& state, Type mask)
+	{
+		if (ParseLimiter* limiter = ParseLimiter::get())
+			limiter->checkDeadline();
 
-					this->elements.back() = result.element;
-					break;
+		bool retry = true;
+		while (retry)
+		{
+			// Every dispatch is traced - a completed element lets the line be parsed again
+			Tracer::Scope trace("parseLine", Phase::BlockParse, Type::None, line.size());
+			retry = false;
+			ParseResult result = this->parseLine(line, state.previousElement, state.activeElement, mask);
+			if (result.element)
+				trace.setType(result.element->getType());
+
+			if (result.flags & ParseFlags::ErasePrevious && !this->elements.empty())
+			{
+				state.previousElement = nullptr;
+				this->release(*this->elements.back());
+				this->elements.pop_back();
+				this->invalidate();
+			}
 
-				case ParseCode::ElementComplete:
-					this->finalizeElement(activeElement);
-					activeElement = nullptr;
+			switch (result.code)
+			{
+			case ParseCode::Discard:
+				break;
+
+			case ParseCode::ReplacePrevious:
+				this->finalizeElement(state.activeElement);
+				this->release(*this->elements.back());
+				this->adopt(*result.element);
+				this->elements.back() = result.element;
+				this->invalidate();
+				break;
+
+			case ParseCode::ElementComplete:
+			{
+				// Active element completing itself is added by finalizeElement
+				bool completesActive = result.element == state.activeElement;
+				this->finalizeElement(state.activeElement);
+				if (!completesActive)
 					this->addElement(result.element);
-					break;
-				
-				case ParseCode::ElementCompleteParseNext:
-					this->finalizeElement(activeElement);
-					activeElement = nullptr;
-					retry = true;
-					break;
+				break;
+			}
 
-				case ParseCode::RequestMore:
-					activeElement = result.element;
-					break;
+			case ParseCode::ElementCompleteParseNext:
+				this->finalizeElement(state.activeElement);
+				retry = true;
+				if (ParseStats* stats = ParseStats::get())
+					stats->retries++;
+				break;
 
-				case ParseCode::Invalid:
-					this->finalizeElement(activeElement);
-					activeElement = nullptr;
-					break;
-				}
+			case ParseCode::RequestMore:
+				state.activeElement = result.element;
+				break;
 
-				if (result.element)
-					previousElement = result.element;
+			case ParseCode::Invalid:
+				this->finalizeElement(state.activeElement);
+				break;
 			}
-		}
 
-		if (activeElement)
-		{
-			activeElement->finalize();
-			this->addElement(activeElement);
+			if (result.element)
+				state.previousElement = result.element;
 		}
 	}
 
+	void ElementContainer::finishParsing(ParseState& state)
+	{
+		// Element which requested more lines completes its parsing
+		this->finalizeElement(state.activeElement);
+		state.previousElement = nullptr;
+	}
+
 	std::string ElementContainer::dump(int indent) const
 	{
 		std::string result;
@@ -134,14 +169,36 @@ namespace Markdown
 		return result;
 	}
 
+	void ElementContainer::measureElements(MemoryUsage& usage, Type owner) const
+	{
+		usage.addVector(owner, this->elements);
+		for (const auto& child : this->elements)
+		{
+			child->measure(usage);
+		}
+	}
+
+	void ElementContainer::shrinkElements()
+	{
+		this->elements.shrink_to_fit();
+		for (const auto& child : this->elements)
+		{
+			child->shrinkToFit();
+		}
+	}
+
 	void ElementContainer::addElement(std::shared_ptr<Element> element)
 	{
+		this->adopt(*element);
 		this->elements.push_back(element);
+		this->invalidate();
 	}
 
 	void ElementContainer::addElement(std::shared_ptr<Element> element, Container::const_iterator it)
 	{
+		this->adopt(*element);
 		this->elements.insert(it, element);
+		this->invalidate();
 	}
 
 	void ElementContainer::iterate(std::function<void(ElementContainer&, Container::iterator, const Element*, const Element*)> pred)
@@ -173,12 +230,17 @@ namespace Markdown
 
 	void ElementContainer::eraseElement(Container::const_iterator it)
 	{
+		this->release(**it);
 		this->elements.erase(it);
+		this->invalidate();
 	}
 
 	void ElementContainer::replaceElement(Container::iterator it, std::shared_ptr<Element> replacement)
 	{
+		this->release(**it);
+		this->adopt(*replacement);
 		*it = replacement;
+		this->invalidate();
 	}
 
 	void ElementContainer::replaceElements(std::function<bool(const Element&)> pred, std::function<std::shared_ptr<Element>(const Element&)> replacementPred)
@@ -205,7 +267,11 @@ namespace Markdown
 
 	void ElementContainer::clear()
 	{
+		for (const auto& element : this->elements)
+			this->release(*element);
+
 		this->elements.clear();
+		this->invalidate();
 	}
 
 	size_t ElementContainer::size() const
@@ -221,7 +287,9 @@ namespace Markdown
 	std::shared_ptr<Element> ElementContainer::take(size_t index)
 	{
 		auto el = this->elements.at(index);
+		this->release(*el);
 		this->elements.erase(this->elements.begin() + index);
+		this->invalidate();
 		return el;
 	}
 
@@ -240,6 +308,24 @@ namespace Markdown
 		return this->elements.size();
 	}
 
+	void ElementContainer::invalidate()
+	{
+		if (this->owner)
+			this->owner->invalidate();
+	}
+
+	void ElementContainer::adopt(Element& element)
+	{
+		element.parent = this->owner;
+	}
+
+	void ElementContainer::release(Element& element)
+	{
+		// The element may already be adopted by another container, e.g. when unpacked
+		if (element.parent == this->owner)
+			element.parent = nullptr;
+	}
+
 	ElementContainer::Container::iterator ElementContainer::begin()
 	{
 		return this->elements.begin();
@@ -268,92 +354,664 @@ namespace Markdown
 			return line;
 
 		auto pos = line.find_first_not_of(' ');
+		if (pos == std::string::npos)
+			return "";
 		return line.substr(pos);
 	}
 
 	Document Document::load(const std::string& path)
 	{
-		std::ifstream ifs(path, std::ios_base::ate);
+		std::ifstream ifs(path);
 		if (ifs.is_open())
 		{
-			std::stringstream buf;
-			buf << ifs.rdbuf();
-
 			Document doc;
-			doc.parse(buf.str());
+			Builder builder(doc);
+
+			// Feed the file in chunks instead of reading it whole
+			std::vector<char> buffer(64 * 1024);
+			while (ifs.read(buffer.data(), buffer.size()) || ifs.gcount() > 0)
+			{
+				builder.feed(std::string_view(buffer.data(), static_cast<size_t>(ifs.gcount())));
+			}
+
+			builder.finish();
 			return doc;
 		}
 
 		throw FileException("File " + path + " could not be opened");
 	}
 
+	ElementRange Document::lazyElements(std::string_view source, Type mask, const ParseLimits& limits)
+	{
+		return ElementRange(source, mask, limits);
+	}
+
 	void Document::parse(const std::string& content, Type mask)
 	{
-		ReferenceManager::ContextGuard cg(this->referenceManager);
-		ElementContainer::parse(content, mask);
-		this->finalize();
+		Tracer::Scope trace("parse", Phase::LineSplit, Type::None, content.size());
+
+		// Content of an earlier parse is replaced, including its references and retained source
+		this->referenceManager = std::make_shared<ReferenceManager>();
+		this->sourceBlocks.clear();
+		this->sourceJoined = false;
+
+		if (this->keepSource)
+		{
+			this->limiter.reset(this->limits);
+			std::string_view source = content;
+			if (content.size() > this->limits.maxInputBytes)
+			{
+				// Lines ending past the limit are dropped, as Builder::feed drops them
+				size_t end = this->limits.maxInputBytes > 0 ? content.rfind('\n', this->limits.maxInputBytes - 1) : std::string::npos;
+				source = source.substr(0, end == std::string::npos ? 0 : end + 1);
+				this->limiter.exceed(Limit::InputBytes);
+			}
+			this->sourceMask = mask;
+			this->parseSource(source);
+			return;
+		}
+
+		this->clear();
+		Builder builder(*this, mask);
+		builder.feed(content);
+		builder.finish();
+	}
+
+	void Document::parse(const std::string& content, ParseStats& stats, Type mask)
+	{
+		stats = ParseStats();
+		ParseStatsCollector collector(stats);
+		this->parse(content, mask);
+		collector.finish(content, *this);
 	}
 
 	void Document::finalize()
 	{
-		std::shared_ptr<Element> previous = nullptr;
-		auto it = this->elements.begin();
-		while(it != this->elements.end())
+		this->elements = finalizeElements(std::move(this->elements));
+	}
+
+	Limit Document::getExceededLimits() const
+	{
+		return this->limiter.getExceeded();
+	}
+
+	ElementContainer::Container Document::finalizeElements(Container elements)
+	{
+		Tracer::Scope trace("finalizeElements", Phase::Finalize);
+
+		// Single sweep building the result - an element erased by its successor is simply popped from the back
+		Container finalized;
+		finalized.reserve(elements.size());
+
+		for (auto& element : elements)
 		{
+			std::shared_ptr<Element> previous = finalized.empty() ? nullptr : finalized.back();
 			FinalizeAction result = FinalizeAction::None;
-
-			do {
-				auto& element = *it;
+			{
+				Tracer::Scope elementTrace("documentFinalize", Phase::Finalize, element->getType());
 				result = element->documentFinalize(previous);
-				previous = element;
+			}
+
+			if (result & FinalizeAction::ErasePrevious)
+			{
+				assert(previous && "No element should return ErasePrevious if it's the first element");
+				if (previous)
+					finalized.pop_back();
+			}
+			else if (previous)
+			{
+				Tracer::Scope elementTrace("finishDocumentFinalize", Phase::Finalize, previous->getType());
+				previous->finishDocumentFinalize();
+			}
+
+			finalized.push_back(std::move(element));
+		}
+
+		if (!finalized.empty())
+		{
+			Tracer::Scope elementTrace("finishDocumentFinalize", Phase::Finalize, finalized.back()->getType());
+			finalized.back()->finishDocumentFinalize();
+		}
+
+		return finalized;
+	}
+
+	// Retained source
+
+	namespace
+	{
+		// Length of the line starting at given position, including the line ending
+		size_t getLineLength(std::string_view text, size_t pos)
+		{
+			size_t end = text.find('\n', pos);
+			return end == std::string_view::npos ? text.size() - pos : end - pos + 1;
+		}
 
-				if (result & FinalizeAction::ErasePrevious && it != this->elements.begin())
+		std::string getLine(std::string_view text, size_t pos, size_t length)
+		{
+			std::string_view line = text.substr(pos, length);
+			if (!line.empty() && line.back() == '\n')
+				line.remove_suffix(1);
+			return std::string(line);
+		}
+
+		// Whether any of the elements defines a reference, including the nested ones
+		bool containsReference(ElementContainer::Container::const_iterator begin, ElementContainer::Container::const_iterator end)
+		{
+			struct ReferenceFinder : public ElementHandler
+			{
+				bool found = false;
+
+				virtual void enterBlock(Type type, const Attributes& /*attributes*/) override
 				{
-					it = this->elements.erase(it - 1);
-						previous = *(it);
-						it++;
+					if (type == Type::Reference)
+						this->found = true;
 				}
-				else if (result & FinalizeAction::ErasePrevious && it == this->elements.begin())
+			};
+
+			ReferenceFinder finder;
+			for (auto it = begin; it != end && !finder.found; ++it)
+				(*it)->walk(finder);
+			return finder.found;
+		}
+	}
+
+	// Parses the source line by line, splitting it into independent blocks
+	class Document::SourceParser
+	{
+	public:
+		// Previous is the last element before the parsed text, the first line may depend on it
+		SourceParser(Type mask, std::shared_ptr<Element> previous = nullptr)
+			: mask(mask)
+		{
+			this->state.previousElement = previous;
+		}
+
+		// Parse single line, length includes the line ending
+		// Returns true if the line is a blank line ending all of the open elements - the next block may start here
+		bool parseLine(const std::string& line, size_t length)
+		{
+			if (SourceMap* sourceMap = SourceMap::get())
+				sourceMap->addLine(line);
+
+			this->source += line;
+			if (length > line.size())
+				this->source += '\n';
+			this->lastLength = length;
+
+			std::shared_ptr<Element> previous = this->state.previousElement;
+			this->elements.parseNextLine(line, this->state, this->mask);
+
+			// Elements of the previous block were erased - it's not independent, join the blocks
+			while (this->blocks.size() > 1 && this->elements.size() < this->blocks.back().firstElement)
+				this->blocks.pop_back();
+
+			bool blockStart =
+				!this->state.activeElement &&
+				this->state.previousElement &&
+				this->state.previousElement != previous &&
+				this->state.previousElement->getType() == Type::LineBreak &&
+				!this->elements.empty() &&
+				this->elements.back() == this->state.previousElement &&
+				LineBreakElement::isAllWhitespace(line);
+
+			if (blockStart && this->lastLine() != this->blocks.back().begin)
+				this->blocks.push_back({ this->lastLine(), this->elements.size() - 1 });
+
+			return blockStart;
+		}
+
+		// Parse all lines of the text
+		void parseText(std::string_view text)
+		{
+			Tracer::Scope trace("parseText", Phase::LineSplit, Type::None, text.size());
+			for (size_t pos = 0; pos < text.size(); )
+			{
+				size_t length = getLineLength(text, pos);
+				this->parseLine(getLine(text, pos, length), length);
+				pos += length;
+			}
+		}
+
+		// Remove the block started by the last line - it's equal to an already parsed block
+		void dropLastBlock()
+		{
+			assert(this->blocks.back().begin == this->lastLine());
+
+			this->elements.take(this->elements.size() - 1);
+			this->blocks.pop_back();
+			this->source.resize(this->lastLine());
+		}
+
+		// Finish parsing and finalize elements of every block separately
+		// Blocks are placed at given offset and first element of the document
+		void finish(Container& result, std::vector<SourceBlock>& resultBlocks, size_t begin, size_t firstElement)
+		{
+			this->elements.finishParsing(this->state);
+
+			for (size_t i = 0; i < this->blocks.size(); i++)
+			{
+				bool last = i + 1 == this->blocks.size();
+				size_t end = last ? this->source.size() : this->blocks.at(i + 1).begin;
+				size_t endElement = last ? this->elements.size() : this->blocks.at(i + 1).firstElement;
+
+				Container block;
+				for (size_t j = this->blocks.at(i).firstElement; j < endElement; j++)
+				{
+					block.push_back(this->elements.at(j));
+				}
+
+				block = finalizeElements(std::move(block));
+				size_t blockBegin = this->blocks.at(i).begin;
+				resultBlocks.push_back({ this->source.substr(blockBegin, end - blockBegin), block.size(), begin + blockBegin, firstElement + result.size() });
+				result.insert(result.end(), block.begin(), block.end());
+			}
+		}
+
+	private:
+		struct Block
+		{
+			size_t begin;
+			size_t firstElement;
+		};
+
+		Type mask;
+		ElementContainer elements;
+		ParseState state;
+		std::vector<Block> blocks{ { 0, 0 } };
+		std::string source; // Parsed lines
+		size_t lastLength = 0; // Length of the last parsed line
+
+		size_t lastLine() const
+		{
+			return this->source.size() - this->lastLength;
+		}
+	};
+
+	void Document::parseSource(std::string_view source)
+	{
+		ReferenceManager::ContextGuard cg(*this->referenceManager);
+		ParseLimiter::ContextGuard lg(this->limiter);
+
+		SourceParser parser(this->sourceMask);
+		parser.parseText(source);
+
+		this->elements.clear();
+		this->sourceBlocks.clear();
+		parser.finish(this->elements, this->sourceBlocks, 0, 0);
+
+		this->deltaBlock = 0;
+		this->offsetDelta = 0;
+		this->elementDelta = 0;
+		this->sourceJoined = false;
+	}
+
+	size_t Document::getBlockBegin(size_t block) const
+	{
+		const SourceBlock& sourceBlock = this->sourceBlocks.at(block);
+		return block < this->deltaBlock ? sourceBlock.begin : sourceBlock.begin + this->offsetDelta;
+	}
+
+	size_t Document::getBlockElement(size_t block) const
+	{
+		const SourceBlock& sourceBlock = this->sourceBlocks.at(block);
+		return block < this->deltaBlock ? sourceBlock.firstElement : sourceBlock.firstElement + this->elementDelta;
+	}
+
+	size_t Document::getSourceSize() const
+	{
+		if (this->sourceBlocks.empty())
+			return 0;
+
+		size_t last = this->sourceBlocks.size() - 1;
+		return this->getBlockBegin(last) + this->sourceBlocks.back().source.size();
+	}
+
+	void Document::moveDeltas(size_t block)
+	{
+		if (this->offsetDelta == 0 && this->elementDelta == 0)
+		{
+			this->deltaBlock = block;
+			return;
+		}
+
+		for (; this->deltaBlock < block; this->deltaBlock++)
+		{
+			this->sourceBlocks.at(this->deltaBlock).begin += this->offsetDelta;
+			this->sourceBlocks.at(this->deltaBlock).firstElement += this->elementDelta;
+		}
+
+		for (; this->deltaBlock > block; this->deltaBlock--)
+		{
+			this->sourceBlocks.at(this->deltaBlock - 1).begin -= this->offsetDelta;
+			this->sourceBlocks.at(this->deltaBlock - 1).firstElement -= this->elementDelta;
+		}
+	}
+
+	void Document::applyEdit(size_t offset, size_t removedLength, const std::string& insertedText)
+	{
+		if (!this->keepSource)
+			throw std::logic_error("Document source is not retained - enable keepSource before parsing");
+
+		// Edited source is not truncated to the input limit, the others apply to the re-parsed blocks
+		this->limiter.reset(this->limits);
+
+		size_t sourceSize = this->getSourceSize();
+		offset = std::min(offset, sourceSize);
+		removedLength = std::min(removedLength, sourceSize - offset);
+		size_t editEnd = offset + removedLength;
+
+		// Ranges of all the following elements would move - record the whole source again
+		if (SourceMap* sourceMap = SourceMap::get())
+		{
+			std::string source = this->getSource();
+			source.replace(offset, removedLength, insertedText);
+			sourceMap->clear();
+			this->referenceManager = std::make_shared<ReferenceManager>();
+			this->parseSource(source);
+			return;
+		}
+
+		if (this->sourceBlocks.empty())
+			this->sourceBlocks.push_back({ "", 0, 0, 0 });
+
+		// Find the last block starting at or before the edit
+		size_t low = 0;
+		size_t high = this->sourceBlocks.size();
+		while (high - low > 1)
+		{
+			size_t middle = low + (high - low) / 2;
+			if (this->getBlockBegin(middle) <= offset)
+				low = middle;
+			else
+				high = middle;
+		}
+		size_t first = low;
+
+		// The edit may change the blank line starting the block - then the preceding block is affected too
+		if (first > 0)
+		{
+			const std::string& blockSource = this->sourceBlocks.at(first).source;
+			if (offset <= this->getBlockBegin(first) + getLine(blockSource, 0, getLineLength(blockSource, 0)).size())
+				first--;
+		}
+
+		size_t regionBegin = this->getBlockBegin(first);
+		size_t elementBegin = this->getBlockElement(first);
+
+		std::string region;
+		size_t next = first;
+		while (next < this->sourceBlocks.size() && (next == first || regionBegin + region.size() <= editEnd))
+		{
+			region += this->sourceBlocks.at(next).source;
+			next++;
+		}
+		region.replace(offset - regionBegin, removedLength, insertedText);
+
+		Container parsed;
+		std::vector<SourceBlock> parsedBlocks;
+		{
+			ReferenceManager::ContextGuard cg(*this->referenceManager);
+			ParseLimiter::ContextGuard lg(this->limiter);
+
+			SourceParser parser(this->sourceMask, elementBegin > 0 ? this->elements.at(elementBegin - 1) : nullptr);
+			parser.parseText(region);
+
+			// Continue until a following block starts the same way it did before the edit
+			while (next < this->sourceBlocks.size())
+			{
+				std::string_view block = this->sourceBlocks.at(next).source;
+				size_t length = getLineLength(block, 0);
+				if (parser.parseLine(getLine(block, 0, length), length))
 				{
-					assert(!"No element should return ErasePrevious if it's the first element");
-					previous = nullptr;
-					it++;
+					parser.dropLastBlock();
 					break;
 				}
-				else
-					it++;
-			} while (result & FinalizeAction::Continue && it != this->elements.end());
+
+				parser.parseText(block.substr(length));
+				next++;
+			}
+
+			parser.finish(parsed, parsedBlocks, regionBegin, elementBegin);
+		}
+
+		size_t elementEnd = next < this->sourceBlocks.size() ? this->getBlockElement(next) : this->elements.size();
+
+		// References are registered document-wide - the replaced definitions can't be undone, parse everything again
+		bool references =
+			containsReference(this->elements.begin() + elementBegin, this->elements.begin() + elementEnd) ||
+			containsReference(parsed.begin(), parsed.end());
+
+		// Replace the elements and blocks in place, only a change of their count moves the following ones
+		this->moveDeltas(next);
+
+		size_t replaced = std::min(parsed.size(), elementEnd - elementBegin);
+		std::move(parsed.begin(), parsed.begin() + replaced, this->elements.begin() + elementBegin);
+		if (replaced < parsed.size())
+			this->elements.insert(this->elements.begin() + elementEnd, std::make_move_iterator(parsed.begin() + replaced), std::make_move_iterator(parsed.end()));
+		else
+			this->elements.erase(this->elements.begin() + elementBegin + replaced, this->elements.begin() + elementEnd);
+
+		size_t replacedBlocks = std::min(parsedBlocks.size(), next - first);
+		std::move(parsedBlocks.begin(), parsedBlocks.begin() + replacedBlocks, this->sourceBlocks.begin() + first);
+		if (replacedBlocks < parsedBlocks.size())
+			this->sourceBlocks.insert(this->sourceBlocks.begin() + next, std::make_move_iterator(parsedBlocks.begin() + replacedBlocks), std::make_move_iterator(parsedBlocks.end()));
+		else
+			this->sourceBlocks.erase(this->sourceBlocks.begin() + first + replacedBlocks, this->sourceBlocks.begin() + next);
+
+		this->deltaBlock = first + parsedBlocks.size();
+		this->offsetDelta += static_cast<ptrdiff_t>(insertedText.size()) - static_cast<ptrdiff_t>(removedLength);
+		this->elementDelta += static_cast<ptrdiff_t>(parsed.size()) - static_cast<ptrdiff_t>(elementEnd - elementBegin);
+		this->sourceJoined = false;
+
+		if (references)
+		{
+			this->referenceManager = std::make_shared<ReferenceManager>();
+			this->parseSource(this->getSource());
+		}
+	}
+
+	const std::string& Document::getSource() const
+	{
+		if (!this->sourceJoined)
+		{
+			this->source.clear();
+			for (const auto& block : this->sourceBlocks)
+				this->source += block.source;
+			this->sourceJoined = true;
+		}
+
+		return this->source;
+	}
+
+	bool Document::renderBlocks(std::string& html) const
+	{
+		if (!this->blockCache || this->sourceBlocks.empty())
+			return false;
+
+		// Blocks no longer describe the elements, e.g. after adding an element
+		if (this->getBlockElement(this->sourceBlocks.size() - 1) + this->sourceBlocks.back().elements != this->elements.size())
+			return false;
+
+		// Parsing depends on the mask and extensions, rendering on the provider
+		uint64_t context = BlockCache::hash(HtmlProvider::get().getFingerprint());
+		context = BlockCache::hash(static_cast<uint64_t>(this->sourceMask), context);
+		context = BlockCache::hash(ExtensionsManager::getInstance().getExtensionCount(), context);
+
+		// Links may use references defined anywhere in the document, the order of definitions doesn't matter
+		uint64_t references = 0;
+		for (const auto& [id, reference] : this->referenceManager->getReferences())
+			references += BlockCache::hash(reference.title, BlockCache::hash(reference.value, BlockCache::hash(id)));
+		context = BlockCache::hash(references, context);
+
+		size_t element = 0;
+		for (const auto& block : this->sourceBlocks)
+		{
+			// Blocks start with a blank line, so they're rendered the same regardless of the preceding ones
+			std::string_view blockSource = block.source;
+
+			if (std::optional<std::string> cached = this->blockCache->find(blockSource, context))
+				html += *cached;
+			else
+			{
+				std::string blockHtml;
+				for (size_t i = element; i < element + block.elements; i++)
+					blockHtml += this->elements.at(i)->getCachedHtml();
+
+				this->blockCache->insert(blockSource, context, blockHtml);
+				html += blockHtml;
+			}
+
+			element += block.elements;
 		}
+
+		return true;
 	}
 
 	std::string Document::getText() const
 	{
+		Tracer::Scope trace("renderText", Phase::Render);
 		std::string result;
 		for (const auto &el : *this)
 		{
-			result += el->getText() + "\n";
+			result += el->getCachedText() + "\n";
 		}
 		
 		if (!result.empty())
 			result.pop_back();
 
+		trace.setBytes(result.size());
+
 		return result;
 	}
 	
 	std::string Document::getHtml() const
 	{
+		Tracer::Scope trace("render", Phase::Render);
 		std::string result = "<!DOCTYPE html><html><head>";
 		if (this->addCharset)
 			result += "<meta charset=\"utf-8\">";
 		result += "</head><body>";
-		for (const auto &el : *this)
+		if (!this->renderBlocks(result))
 		{
-			result += el->getHtml();
+			for (const auto &el : *this)
+			{
+				result += el->getCachedHtml();
+			}
 		}
 		result += "</body></html>";
+		trace.setBytes(result.size());
 		return result;
 	}
 
+	std::string Document::freeze() const
+	{
+		FrozenWriter writer;
+		writer.beginNode(FrozenNode::Document);
+		writer.writeInteger(this->addCharset ? 1 : 0);
+		writer.writeReferences(*this->referenceManager);
+		for (const auto &el : *this)
+		{
+			el->freeze(writer);
+		}
+		writer.endNode();
+		return writer.finish();
+	}
+
+	MemoryUsage Document::memoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.addObject(Type::None, sizeof(Document));
+		usage.addString(Type::None, this->source);
+		usage.addVector(Type::None, this->sourceBlocks);
+		for (const auto& block : this->sourceBlocks)
+			usage.addString(Type::None, block.source);
+		this->measureElements(usage, Type::None);
+
+		// Nodes of the map hold the name and the reference, buckets point to the nodes
+		MemoryUsage references;
+		const auto& map = this->referenceManager->getReferences();
+		for (const auto& [name, reference] : map)
+		{
+			references.addString(Type::None, name);
+			references.addString(Type::None, reference.id);
+			references.addString(Type::None, reference.value);
+			references.addString(Type::None, reference.title);
+		}
+		usage[Type::None].references += references.total() + map.size() * (sizeof(std::pair<const std::string, Reference>) + 2 * sizeof(void*))
+			+ map.bucket_count() * sizeof(void*);
+
+		return usage;
+	}
+
+	void Document::shrinkToFit()
+	{
+		this->source.shrink_to_fit();
+		this->sourceBlocks.shrink_to_fit();
+		for (auto& block : this->sourceBlocks)
+			block.source.shrink_to_fit();
+		this->shrinkElements();
+	}
+
+	// Document builder
+
+	Document::Builder::Builder(Document& document, Type mask)
+		: document(document)
+		, mask(mask)
+	{
+		this->document.limiter.reset(this->document.limits);
+	}
+
+	void Document::Builder::feed(std::string_view chunk)
+	{
+		assert(!this->finished && "Cannot feed finished document builder");
+
+		ReferenceManager::ContextGuard cg(*this->document.referenceManager);
+		ParseLimiter::ContextGuard lg(this->document.limiter);
+		Tracer::Scope trace("feed", Phase::LineSplit, Type::None, chunk.size());
+
+		// Content past the input limit is dropped, together with the line it cuts
+		size_t remaining = this->document.limits.maxInputBytes - std::min(this->fed, this->document.limits.maxInputBytes);
+		bool truncated = chunk.size() > remaining;
+		if (truncated)
+		{
+			chunk = chunk.substr(0, remaining);
+			this->document.limiter.exceed(Limit::InputBytes);
+		}
+		this->fed += chunk.size();
+
+		SourceMap* sourceMap = SourceMap::get();
+		splitLines(chunk, this->line, [this, sourceMap](const std::string& completeLine) {
+			if (sourceMap)
+				sourceMap->addLine(completeLine);
+			this->document.parseNextLine(completeLine, this->state, this->mask);
+		});
+
+		if (truncated)
+			this->line.clear();
+	}
+
+	void Document::Builder::finish()
+	{
+		if (this->finished)
+			return;
+
+		ReferenceManager::ContextGuard cg(*this->document.referenceManager);
+		ParseLimiter::ContextGuard lg(this->document.limiter);
+
+		if (!this->line.empty())
+		{
+			if (SourceMap* sourceMap = SourceMap::get())
+				sourceMap->addLine(this->line);
+			this->document.parseNextLine(this->line, this->state, this->mask);
+			this->line.clear();
+		}
+
+		this->document.finishParsing(this->state);
+		this->document.finalize();
+		this->finished = true;
+	}
+
 	// Subelement parser
 
 	void SubelementParser::parseSubelements(const std::string& source)
@@ -367,7 +1025,9 @@ namespace Markdown
 			{
 				if (supply)
 				{
-					this->supply(line, nullptr);
+					// Lines after the element is complete don't belong to it
+					if (this->supply(line, nullptr).code != ParseCode::RequestMore)
+						break;
 				}
 				else
 				{
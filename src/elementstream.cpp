@@ -0,0 +1,248 @@
+#include "cppmarkdown/elementstream.h"
+#include "cppmarkdown/elementhandler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace Markdown
+{
+    // Element stream
+
+    ElementStream::ElementStream(Callback callback, Type mask, const ParseLimits& limits)
+        : callback(callback)
+        , mask(mask)
+        , limiter(limits)
+    {
+    }
+
+    void ElementStream::feed(std::string_view chunk)
+    {
+        assert(!this->isFinished && "Cannot feed finished element stream");
+
+        ReferenceManager::ContextGuard cg(*this->referenceManager);
+        ParseLimiter::ContextGuard lg(this->limiter);
+
+        // Content past the input limit is dropped, together with the line it cuts
+        size_t maxInputBytes = this->limiter.getLimits().maxInputBytes;
+        size_t remaining = maxInputBytes - std::min(this->fed, maxInputBytes);
+        bool truncated = chunk.size() > remaining;
+        if (truncated)
+        {
+            chunk = chunk.substr(0, remaining);
+            this->limiter.exceed(Limit::InputBytes);
+        }
+        this->fed += chunk.size();
+
+        splitLines(chunk, this->line, [this](const std::string& completeLine) {
+            this->parseLine(completeLine);
+        });
+
+        if (truncated)
+            this->line.clear();
+    }
+
+    void ElementStream::finish()
+    {
+        if (this->isFinished)
+            return;
+
+        ReferenceManager::ContextGuard cg(*this->referenceManager);
+        ParseLimiter::ContextGuard lg(this->limiter);
+
+        if (!this->line.empty())
+        {
+            this->parseLine(this->line);
+            this->line.clear();
+        }
+
+        this->container.finishParsing(this->state);
+        while (!this->container.empty())
+            this->complete(this->container.take(0));
+
+        if (this->pending)
+        {
+            this->pending->finishDocumentFinalize();
+            this->callback(std::move(this->pending));
+        }
+
+        this->pending = nullptr;
+        this->isFinished = true;
+    }
+
+    bool ElementStream::finished() const
+    {
+        return this->isFinished;
+    }
+
+    ReferenceManager& ElementStream::getReferenceManager()
+    {
+        return *this->referenceManager;
+    }
+
+    Limit ElementStream::getExceededLimits() const
+    {
+        return this->limiter.getExceeded();
+    }
+
+    void ElementStream::parseLine(const std::string& line)
+    {
+        if (SourceMap* sourceMap = SourceMap::get())
+            sourceMap->addLine(line);
+
+        this->container.parseNextLine(line, this->state, this->mask);
+
+        // Next line may only replace or erase the last element - all of the preceding ones are complete
+        while (this->container.size() > 1)
+            this->complete(this->container.take(0));
+    }
+
+    void ElementStream::complete(std::shared_ptr<Element> element)
+    {
+        // Same as Document::finalize, with the pending element being the last element of the finalized document
+        FinalizeAction result = element->documentFinalize(this->pending);
+
+        if (this->pending && !(result & FinalizeAction::ErasePrevious))
+        {
+            this->pending->finishDocumentFinalize();
+            this->callback(std::move(this->pending));
+        }
+
+        this->pending = std::move(element);
+    }
+
+    // Element range
+
+    ElementRange::iterator::iterator(ElementRange* range)
+        : range(range)
+    {
+        if (this->range)
+            this->current = this->range->next();
+    }
+
+    ElementRange::iterator::reference ElementRange::iterator::operator*() const
+    {
+        return this->current;
+    }
+
+    ElementRange::iterator::pointer ElementRange::iterator::operator->() const
+    {
+        return &this->current;
+    }
+
+    ElementRange::iterator& ElementRange::iterator::operator++()
+    {
+        this->current = this->range->next();
+        return *this;
+    }
+
+    bool ElementRange::iterator::operator==(const iterator& b) const
+    {
+        return this->current == b.current;
+    }
+
+    bool ElementRange::iterator::operator!=(const iterator& b) const
+    {
+        return !(*this == b);
+    }
+
+    ElementRange::ElementRange(std::string_view source, Type mask, const ParseLimits& limits)
+        : source(source)
+        , stream([this](std::shared_ptr<Element> element) { this->ready.push_back(std::move(element)); }, mask, limits)
+    {
+    }
+
+    ElementRange::iterator ElementRange::begin()
+    {
+        return iterator(this);
+    }
+
+    ElementRange::iterator ElementRange::end()
+    {
+        return iterator();
+    }
+
+    size_t ElementRange::position() const
+    {
+        return this->offset;
+    }
+
+    ReferenceManager& ElementRange::getReferenceManager()
+    {
+        return this->stream.getReferenceManager();
+    }
+
+    Limit ElementRange::getExceededLimits() const
+    {
+        return this->stream.getExceededLimits();
+    }
+
+    std::shared_ptr<Element> ElementRange::next()
+    {
+        // Feed the source line by line until the stream completes an element
+        while (this->ready.empty() && !this->stream.finished())
+        {
+            if (this->offset < this->source.size())
+            {
+                size_t lineEnd = this->source.find('\n', this->offset);
+                lineEnd = lineEnd == std::string_view::npos ? this->source.size() : lineEnd + 1;
+
+                this->stream.feed(this->source.substr(this->offset, lineEnd - this->offset));
+                this->offset = lineEnd;
+            }
+            else
+                this->stream.finish();
+        }
+
+        if (this->ready.empty())
+            return nullptr;
+
+        std::shared_ptr<Element> element = std::move(this->ready.front());
+        this->ready.pop_front();
+        return element;
+    }
+
+    // Event parser
+
+    EventParser::EventParser(ElementHandler& handler, Type mask, const ParseLimits& limits)
+        : stream([&handler](std::shared_ptr<Element> element) {
+            element->walk(handler);
+        }, mask, limits)
+    {
+    }
+
+    void EventParser::feed(std::string_view chunk)
+    {
+        this->stream.feed(chunk);
+    }
+
+    void EventParser::finish()
+    {
+        this->stream.finish();
+    }
+
+    Limit EventParser::getExceededLimits() const
+    {
+        return this->stream.getExceededLimits();
+    }
+
+    void EventParser::parse(const std::string& content, ElementHandler& handler, Type mask)
+    {
+        EventParser parser(handler, mask);
+        parser.feed(content);
+        parser.finish();
+    }
+
+    void EventParser::parse(std::istream& stream, ElementHandler& handler, Type mask)
+    {
+        EventParser parser(handler, mask);
+
+        std::vector<char> buffer(64 * 1024);
+        while (stream.read(buffer.data(), buffer.size()) || stream.gcount() > 0)
+        {
+            parser.feed(std::string_view(buffer.data(), static_cast<size_t>(stream.gcount())));
+        }
+
+        parser.finish();
+    }
+}
@@ -1,6 +1,13 @@
 #include "cppmarkdown/ext/tableelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/paragraphelement.h"
+#include "cppmarkdown/parselimits.h"
+#include "cppmarkdown/sourcemap.h"
 
+#include <algorithm>
 #include <sstream>
 
 namespace Markdown
@@ -20,6 +27,15 @@ namespace Markdown
         size_t countPipes = std::count(line.begin(), line.end(), '|');
         if (countPipes > 0)
         {
+            // Lines of tables wider than the limit are kept as written, joined into a single paragraph
+            ParseLimiter* limiter = ParseLimiter::get();
+            if (limiter && parseColumnCount(line) > limiter->getLimits().maxTableColumns)
+            {
+                limiter->exceed(Limit::TableColumns);
+                auto paragraph = std::make_shared<ParagraphElement>();
+                return ParseResult(paragraph->parseLiteral(line).code, ParseFlags::Replace, paragraph);
+            }
+
             this->setColumns(parseRow(line));
             return ParseResult(ParseCode::RequestMore);
         }
@@ -70,6 +86,7 @@ namespace Markdown
     void TableElement::setColumns(size_t n)
     {
         this->header.resize(n);
+        this->invalidate();
     }
 
     void TableElement::setColumns(const std::initializer_list<Cell>& headerCells)
@@ -86,6 +103,7 @@ namespace Markdown
     void TableElement::setColumns(const Row& row)
     {
         this->header = row;
+        this->invalidate();
     }
 
     size_t TableElement::rowCount() const
@@ -100,11 +118,13 @@ namespace Markdown
         {
             this->rows.back().push_back(cell);
         }
+        this->invalidate();
     }
 
     void TableElement::addRow(const Row& cells)
     {
         this->rows.push_back(cells);
+        this->invalidate();
     }
 
     TableElement::Cell* TableElement::getCell(size_t row, size_t column)
@@ -138,7 +158,15 @@ namespace Markdown
 
     std::string TableElement::getText() const
     {
-        std::vector<size_t> lengths(this->columnCount(), 0);
+        if (this->header.empty())
+            return "";
+
+        // Rows added through addRow may be wider than the header
+        size_t columns = this->columnCount();
+        for (const auto& row : this->rows)
+            columns = std::max(columns, row.size());
+
+        std::vector<size_t> lengths(columns, 0);
         size_t i = 0;
         for (const auto &th : this->header)
         {
@@ -229,6 +257,86 @@ namespace Markdown
         return this->getText();
     }
 
+    void TableElement::walk(ElementHandler& handler) const
+    {
+        auto walkRow = [&handler](const Row& row, bool header) {
+            Attributes attributes;
+            if (header)
+                attributes.emplace_back("header", "true");
+
+            handler.enterBlock(Type::TableRow, attributes);
+            for (const auto& cell : row)
+            {
+                handler.enterBlock(Type::TableCell, attributes);
+                cell.walk(handler);
+                handler.exitBlock(Type::TableCell);
+            }
+            handler.exitBlock(Type::TableRow);
+        };
+
+        handler.enterBlock(Type::Table, {});
+        walkRow(this->header, true);
+        for (const auto& row : this->rows)
+        {
+            walkRow(row, false);
+        }
+        handler.exitBlock(Type::Table);
+    }
+
+    void TableElement::freeze(FrozenWriter& writer) const
+    {
+        auto freezeRow = [&writer](const Row& row, bool header) {
+            writer.beginElement(Type::TableRow);
+            writer.writeInteger(header ? 1 : 0);
+            for (const auto& cell : row)
+            {
+                writer.beginElement(Type::TableCell);
+                cell.freeze(writer);
+                writer.endNode();
+            }
+            writer.endNode();
+        };
+
+        writer.beginElement(Type::Table);
+        freezeRow(this->header, true);
+        for (const auto& row : this->rows)
+        {
+            freezeRow(row, false);
+        }
+        writer.endNode();
+    }
+
+    void TableElement::measure(MemoryUsage& usage) const
+    {
+        // Rows and cells are parts of the table rather than elements of their own
+        Type type = this->getType();
+        auto measureRow = [&usage, type](const Row& row) {
+            usage.addVector(type, row);
+            for (const auto& cell : row)
+                cell.measure(usage, type);
+        };
+
+        this->measureElement(usage, sizeof(*this));
+        measureRow(this->header);
+        usage.addVector(type, this->rows);
+        for (const auto& row : this->rows)
+            measureRow(row);
+    }
+
+    void TableElement::shrinkToFit()
+    {
+        auto shrinkRow = [](Row& row) {
+            row.shrink_to_fit();
+            for (auto& cell : row)
+                cell.shrinkToFit();
+        };
+
+        Element::shrinkToFit();
+        shrinkRow(this->header);
+        this->rows.shrink_to_fit();
+        for (auto& row : this->rows)
+            shrinkRow(row);
+    }
 
     bool TableElement::tableLineValid(const std::string &line, size_t requiredPipes)
     {
@@ -260,12 +368,22 @@ namespace Markdown
 
     TableElement::Row TableElement::parseRow(const std::string& line)
     {
+        SourceMap* sourceMap = SourceMap::get();
+        uint32_t lineOffset = sourceMap ? sourceMap->getLineOffset(line) : SourceRange::npos;
+
         auto splitted = split(line, '|');
         TableElement::Row row(splitted.size());
         size_t i = 0;
+        size_t position = 0; // Of the cell in the line
         for (std::string s : splitted)
         {
+            ContentOrigin origin;
+            if (sourceMap && lineOffset != SourceRange::npos)
+                origin = { { 0, static_cast<uint32_t>(lineOffset + position + s.size() - ltrimmed(s).size()) } };
+
+            SourceMap::ContentGuard content(std::move(origin));
             row.at(i++) = trimmed(s);
+            position += s.size() + 1;
         }
 
         if (row.back().empty())
@@ -25,6 +25,11 @@ namespace Markdown
         this->extensions.push_back(std::move(extension));
     }
 
+    size_t ExtensionsManager::getExtensionCount() const
+    {
+        return this->extensions.size();
+    }
+
     void ExtensionsManager::extend(ParserCollection& parsers)
     {
         for (auto& extension : this->extensions)
@@ -38,6 +43,7 @@ namespace Markdown
     void registerStandardExtensions()
     {
         ExtensionsManager& manager = ExtensionsManager::getInstance();
-        manager.registerExtension(std::make_unique<StandardExtension>());
+        if (!manager.hasExtension<StandardExtension>())
+            manager.registerExtension(std::make_unique<StandardExtension>());
     }
 }
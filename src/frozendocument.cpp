@@ -0,0 +1,752 @@
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/html.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Markdown
+{
+    namespace
+    {
+        const char magic[4] = { 'C', 'M', 'D', 'F' };
+
+        void checkLength(size_t length)
+        {
+            if (length > std::numeric_limits<uint32_t>::max())
+                throw FrozenFormatException("Frozen document exceeds 4 GiB");
+        }
+
+        // Remove the separator after the last part appended since start
+        void popSeparator(std::string& out, size_t start)
+        {
+            if (out.size() > start)
+                out.pop_back();
+        }
+    }
+
+    // Writer
+
+    FrozenWriter::FrozenWriter()
+        : buffer(FrozenDocument::headerSize, '\0')
+    {
+    }
+
+    void FrozenWriter::beginNode(FrozenNode node)
+    {
+        // Count and size are filled when the node ends
+        this->openNodes.push_back(this->buffer.size());
+        this->writeInteger(static_cast<uint32_t>(node));
+        this->writeInteger(0);
+        this->writeInteger(0);
+    }
+
+    void FrozenWriter::beginElement(Type type)
+    {
+        this->beginNode(FrozenNode::Element);
+        this->writeInteger(static_cast<uint32_t>(type));
+    }
+
+    void FrozenWriter::endNode()
+    {
+        size_t offset = this->openNodes.back();
+        this->openNodes.pop_back();
+
+        checkLength(this->buffer.size() - offset);
+        this->setInteger(offset + 4, static_cast<uint32_t>(this->buffer.size() - offset));
+
+        if (!this->openNodes.empty())
+        {
+            size_t parent = this->openNodes.back();
+            uint32_t count = 0;
+            for (int i = 3; i >= 0; i--)
+                count = (count << 8) | static_cast<unsigned char>(this->buffer[parent + 8 + i]);
+            this->setInteger(parent + 8, count + 1);
+        }
+    }
+
+    void FrozenWriter::writeInteger(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            this->buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+    }
+
+    void FrozenWriter::writeString(std::string_view value)
+    {
+        checkLength(value.size());
+        this->writeInteger(static_cast<uint32_t>(value.size()));
+        this->buffer.append(value);
+    }
+
+    void FrozenWriter::writeReferences(const ReferenceManager& references)
+    {
+        std::vector<const Reference*> sorted;
+        for (const auto& entry : references.getReferences())
+            sorted.push_back(&entry.second);
+
+        std::sort(sorted.begin(), sorted.end(), [](const Reference* a, const Reference* b) {
+            return a->id < b->id;
+        });
+
+        this->writeInteger(static_cast<uint32_t>(sorted.size()));
+        size_t table = this->buffer.size();
+        this->buffer.append(sorted.size() * 4, '\0');
+
+        for (size_t i = 0; i < sorted.size(); i++)
+        {
+            checkLength(this->buffer.size());
+            this->setInteger(table + i * 4, static_cast<uint32_t>(this->buffer.size()));
+            this->writeString(sorted[i]->id);
+            this->writeString(sorted[i]->value);
+            this->writeString(sorted[i]->title);
+        }
+    }
+
+    std::string FrozenWriter::finish()
+    {
+        checkLength(this->buffer.size());
+
+        std::memcpy(this->buffer.data(), magic, sizeof(magic));
+        this->setInteger(4, FrozenDocument::version);
+        this->setInteger(8, static_cast<uint32_t>(this->buffer.size()));
+        this->setInteger(12, FrozenDocument::checksum(std::string_view(this->buffer).substr(FrozenDocument::headerSize)));
+
+        std::string result = std::move(this->buffer);
+        this->buffer.assign(FrozenDocument::headerSize, '\0');
+        this->openNodes.clear();
+        return result;
+    }
+
+    void FrozenWriter::setInteger(size_t offset, uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            this->buffer[offset + i] = static_cast<char>((value >> (i * 8)) & 0xff);
+    }
+
+    // Renderer
+
+    // Reads the nodes in place, every read is checked against the end of the buffer
+    class FrozenDocument::Renderer
+    {
+    public:
+        struct Node
+        {
+            FrozenNode kind;
+            uint32_t count; // Children
+            size_t fields; // Offset of the fields
+            size_t end;
+        };
+
+        // Level of nested nodes rendered for the lifetime of the scope
+        class DepthScope
+        {
+        public:
+            DepthScope(const Renderer& renderer)
+                : renderer(renderer)
+            {
+                if (++this->renderer.depth > this->renderer.document.maxDepth)
+                {
+                    this->renderer.depth--;
+                    throw FrozenFormatException("Frozen document is nested too deep");
+                }
+            }
+
+            ~DepthScope()
+            {
+                this->renderer.depth--;
+            }
+
+            DepthScope(const DepthScope&) = delete;
+            DepthScope& operator=(const DepthScope&) = delete;
+
+        private:
+            const Renderer& renderer;
+        };
+
+        Renderer(const FrozenDocument& document)
+            : document(document)
+            , buffer(document.buffer)
+        { }
+
+        uint32_t readInteger(size_t& offset) const
+        {
+            if (offset > this->buffer.size() || this->buffer.size() - offset < 4)
+                throw FrozenFormatException("Frozen document is truncated");
+
+            uint32_t value = 0;
+            for (int i = 3; i >= 0; i--)
+                value = (value << 8) | static_cast<unsigned char>(this->buffer[offset + i]);
+            offset += 4;
+            return value;
+        }
+
+        std::string_view readString(size_t& offset) const
+        {
+            uint32_t length = this->readInteger(offset);
+            if (this->buffer.size() - offset < length)
+                throw FrozenFormatException("Frozen document is truncated");
+
+            std::string_view result = this->buffer.substr(offset, length);
+            offset += length;
+            return result;
+        }
+
+        Node readNode(size_t offset) const
+        {
+            size_t begin = offset;
+            Node node;
+            node.kind = static_cast<FrozenNode>(this->readInteger(offset));
+            uint32_t size = this->readInteger(offset);
+            node.count = this->readInteger(offset);
+            node.fields = offset;
+            node.end = begin + size;
+
+            if (node.end < node.fields || node.end > this->buffer.size())
+                throw FrozenFormatException("Frozen document node is corrupted");
+            return node;
+        }
+
+        // Type of the element, the offset is moved to its fields
+        Type readType(const Node& node, size_t& offset) const
+        {
+            if (node.kind != FrozenNode::Element && node.kind != FrozenNode::RenderedElement)
+                throw FrozenFormatException("Frozen document node is not an element");
+
+            offset = node.fields;
+            return static_cast<Type>(this->readInteger(offset));
+        }
+
+        // Find the reference among the references sorted by id
+        bool findReference(std::string_view id, std::string_view& url, std::string_view& title) const
+        {
+            size_t low = 0;
+            size_t high = this->document.referenceCount;
+            while (low < high)
+            {
+                size_t middle = (low + high) / 2;
+                size_t table = this->document.referenceTable + middle * 4;
+                size_t offset = this->readInteger(table);
+
+                std::string_view referenceId = this->readString(offset);
+                if (referenceId < id)
+                    low = middle + 1;
+                else if (id < referenceId)
+                    high = middle;
+                else
+                {
+                    url = this->readString(offset);
+                    title = this->readString(offset);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Elements, the end of the node is returned
+
+        size_t elementHtml(size_t offset, std::string& out) const
+        {
+            DepthScope scope(*this);
+            Node node = this->readNode(offset);
+            size_t fields;
+            Type type = this->readType(node, fields);
+
+            if (node.kind == FrozenNode::RenderedElement)
+            {
+                out += this->readString(fields);
+                return node.end;
+            }
+
+            const HtmlProvider& provider = HtmlProvider::get();
+            switch (type)
+            {
+            case Type::Paragraph:
+            case Type::Heading:
+            case Type::Blank:
+            case Type::TableCell:
+                this->children(node, fields, out, &Renderer::spanHtml);
+                break;
+
+            case Type::Blockquote:
+                this->wrapChildren(node, fields, provider.getBlockquote(), out, &Renderer::elementHtml);
+                break;
+
+            case Type::List:
+            {
+                bool ordered = this->readInteger(fields);
+                this->wrapChildren(node, fields, ordered ? provider.getOrderedList() : provider.getUnorderedList(), out, &Renderer::elementHtml);
+                break;
+            }
+
+            case Type::ListItem:
+            {
+                uint32_t spans = this->readInteger(fields);
+                auto tag = provider.getListItem();
+                out += tag.first;
+                for (uint32_t i = 0; i < node.count; i++)
+                    fields = i < spans ? this->spanHtml(fields, out) : this->elementHtml(fields, out);
+                out += tag.second;
+                break;
+            }
+
+            case Type::Code:
+            {
+                std::string_view text = this->readString(fields);
+                auto tag = provider.getCode();
+                out += tag.first;
+                appendEscapedHtml(out, text.data(), text.size());
+                out += tag.second;
+                break;
+            }
+
+            case Type::LineBreak:
+            {
+                auto tag = provider.getLineBreak();
+                out += tag.first + tag.second;
+                break;
+            }
+
+            case Type::Line:
+            {
+                auto tag = provider.getLine();
+                out += tag.first + tag.second;
+                break;
+            }
+
+            case Type::Reference:
+                break;
+
+            case Type::Table:
+            {
+                auto tagTable = provider.getTable();
+                auto tagRow = provider.getTableRow();
+                auto tagCell = provider.getTableCell();
+                auto tagHeader = provider.getTableHeader();
+
+                out += tagTable.first;
+                for (uint32_t row = 0; row < node.count; row++)
+                {
+                    Node rowNode = this->readNode(fields);
+                    size_t cell;
+                    this->readType(rowNode, cell);
+                    const auto& tag = this->readInteger(cell) ? tagHeader : tagCell;
+
+                    out += tagRow.first;
+                    for (uint32_t i = 0; i < rowNode.count; i++)
+                    {
+                        out += tag.first;
+                        cell = this->elementHtml(cell, out);
+                        out += tag.second;
+                    }
+                    out += tagRow.second;
+
+                    fields = rowNode.end;
+                }
+                out += tagTable.second;
+                break;
+            }
+
+            default:
+                throw FrozenFormatException("Frozen document contains unknown element");
+            }
+
+            return node.end;
+        }
+
+        size_t elementText(size_t offset, std::string& out) const
+        {
+            DepthScope scope(*this);
+            Node node = this->readNode(offset);
+            size_t fields;
+            Type type = this->readType(node, fields);
+
+            if (node.kind == FrozenNode::RenderedElement)
+            {
+                this->readString(fields);
+                out += this->readString(fields);
+                return node.end;
+            }
+
+            switch (type)
+            {
+            case Type::Paragraph:
+            case Type::Heading:
+            case Type::Blank:
+            case Type::TableCell:
+                this->children(node, fields, out, &Renderer::spanText);
+                break;
+
+            case Type::Blockquote:
+            {
+                size_t start = out.size();
+                for (uint32_t i = 0; i < node.count; i++)
+                {
+                    fields = this->elementText(fields, out);
+                    out += '\n';
+                }
+                popSeparator(out, start);
+                break;
+            }
+
+            case Type::List:
+            {
+                bool ordered = this->readInteger(fields);
+                size_t start = out.size();
+                for (uint32_t i = 0; i < node.count; i++)
+                {
+                    if (ordered)
+                        out += std::to_string(i + 1) + ". ";
+                    else if (!this->sublistFirst(fields))
+                        out += "- ";
+
+                    fields = this->elementText(fields, out);
+                    out += '\n';
+                }
+                popSeparator(out, start);
+                break;
+            }
+
+            case Type::ListItem:
+            {
+                uint32_t spans = this->readInteger(fields);
+                size_t start = out.size();
+                for (uint32_t i = 0; i < spans && i < node.count; i++)
+                    fields = this->spanText(fields, out);
+                if (out.size() > start)
+                    out += '\n';
+
+                for (uint32_t i = spans; i < node.count; i++)
+                {
+                    size_t itemFields;
+                    if (this->readType(this->readNode(fields), itemFields) == Type::LineBreak)
+                    {
+                        fields = this->readNode(fields).end;
+                        continue;
+                    }
+
+                    fields = this->elementText(fields, out);
+                    out += '\n';
+                }
+                popSeparator(out, start);
+                break;
+            }
+
+            case Type::Code:
+            case Type::Line:
+                out += this->readString(fields);
+                break;
+
+            case Type::LineBreak:
+                out += '\n';
+                break;
+
+            case Type::Reference:
+                break;
+
+            case Type::Table:
+                this->tableText(node, fields, out);
+                break;
+
+            default:
+                throw FrozenFormatException("Frozen document contains unknown element");
+            }
+
+            return node.end;
+        }
+
+        // Spans, the end of the node is returned
+
+        size_t spanHtml(size_t offset, std::string& out) const
+        {
+            DepthScope scope(*this);
+            Node node = this->readNode(offset);
+            size_t fields = node.fields;
+
+            if (node.kind == FrozenNode::Span)
+            {
+                this->spanContentHtml(node, fields, out);
+                return node.end;
+            }
+
+            if (node.kind != FrozenNode::LinkSpan && node.kind != FrozenNode::ImageSpan)
+                throw FrozenFormatException("Frozen document node is not a span");
+
+            std::string url;
+            std::string title;
+            std::string_view source = this->readString(fields);
+            if (this->readInteger(fields))
+            {
+                std::string_view referenceUrl;
+                std::string_view referenceTitle;
+                if (this->findReference(source, referenceUrl, referenceTitle))
+                {
+                    url = referenceUrl;
+                    title = referenceTitle;
+                }
+            }
+            else
+                url = source;
+
+            const HtmlProvider& provider = HtmlProvider::get();
+            if (!provider.isUrlAllowed(url))
+                url = "#";
+
+            if (node.kind == FrozenNode::LinkSpan)
+            {
+                auto tag = provider.getLink(url, title);
+                out += tag.first;
+                this->spanContentHtml(node, fields, out);
+                out += tag.second;
+            }
+            else
+            {
+                this->readString(fields);
+                this->readString(fields);
+                auto tag = provider.getImage(std::string(this->readString(fields)), url, title);
+                out += tag.first + tag.second;
+            }
+
+            return node.end;
+        }
+
+        size_t spanText(size_t offset, std::string& out) const
+        {
+            DepthScope scope(*this);
+            Node node = this->readNode(offset);
+            size_t fields = node.fields;
+
+            if (node.kind == FrozenNode::LinkSpan || node.kind == FrozenNode::ImageSpan)
+            {
+                this->readString(fields);
+                this->readInteger(fields);
+            }
+            else if (node.kind != FrozenNode::Span)
+                throw FrozenFormatException("Frozen document node is not a span");
+
+            this->readString(fields);
+            this->readString(fields);
+            std::string_view text = this->readString(fields);
+
+            if (node.count > 0)
+                this->children(node, fields, out, &Renderer::spanText);
+            else
+                out += text;
+
+            return node.end;
+        }
+
+    private:
+        const FrozenDocument& document;
+        std::string_view buffer;
+        mutable size_t depth = 0;
+
+        using Render = size_t (Renderer::*)(size_t, std::string&) const;
+
+        void children(const Node& node, size_t offset, std::string& out, Render render) const
+        {
+            for (uint32_t i = 0; i < node.count; i++)
+                offset = (this->*render)(offset, out);
+        }
+
+        void wrapChildren(const Node& node, size_t offset, const std::pair<std::string, std::string>& tag, std::string& out, Render render) const
+        {
+            out += tag.first;
+            this->children(node, offset, out, render);
+            out += tag.second;
+        }
+
+        // Opening tag, closing tag and text of the span, followed by its children
+        void spanContentHtml(const Node& node, size_t offset, std::string& out) const
+        {
+            std::string_view opening = this->readString(offset);
+            std::string_view closing = this->readString(offset);
+            std::string_view text = this->readString(offset);
+
+            out += opening;
+            if (node.count > 0)
+                this->children(node, offset, out, &Renderer::spanHtml);
+            else
+                appendEscapedHtml(out, text.data(), text.size());
+            out += closing;
+        }
+
+        // Whether the first element of the list item, following its spans, is a list
+        bool sublistFirst(size_t offset) const
+        {
+            Node item = this->readNode(offset);
+            size_t fields;
+            this->readType(item, fields);
+            uint32_t spans = this->readInteger(fields);
+            if (item.count <= spans)
+                return false;
+
+            for (uint32_t i = 0; i < spans; i++)
+                fields = this->readNode(fields).end;
+
+            size_t listFields;
+            return this->readType(this->readNode(fields), listFields) == Type::List;
+        }
+
+        // Columns are padded to the longest cell, see TableElement::getText
+        void tableText(const Node& node, size_t offset, std::string& out) const
+        {
+            std::vector<size_t> lengths;
+            std::string cellText;
+
+            // Offset of the first cell of each row, rows are followed by their cells
+            auto cells = [this](size_t& rowOffset, uint32_t& count) {
+                Node row = this->readNode(rowOffset);
+                size_t cell;
+                this->readType(row, cell);
+                this->readInteger(cell);
+
+                count = row.count;
+                rowOffset = row.end;
+                return cell;
+            };
+
+            size_t rowOffset = offset;
+            for (uint32_t row = 0; row < node.count; row++)
+            {
+                uint32_t count;
+                size_t cell = cells(rowOffset, count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    cellText.clear();
+                    cell = this->elementText(cell, cellText);
+
+                    if (i >= lengths.size())
+                        lengths.resize(i + 1, 0);
+                    lengths[i] = std::max(lengths[i], cellText.size() + 1);
+                }
+            }
+
+            size_t start = out.size();
+            rowOffset = offset;
+            for (uint32_t row = 0; row < node.count; row++)
+            {
+                size_t line = out.size();
+                uint32_t count;
+                size_t cell = cells(rowOffset, count);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    cellText.clear();
+                    cell = this->elementText(cell, cellText);
+
+                    if (i > 0)
+                        out += ' ';
+                    out += cellText;
+                    out.append(lengths[i] - cellText.size(), ' ');
+                    out += '|';
+                }
+                popSeparator(out, line);
+                out += '\n';
+
+                // Header is followed by the separator line
+                if (row == 0)
+                {
+                    line = out.size();
+                    for (size_t i = 0; i < lengths.size(); i++)
+                    {
+                        out.append(lengths[i] + (i > 0 ? 1 : 0), '-');
+                        out += '|';
+                    }
+                    popSeparator(out, line);
+                    out += '\n';
+                }
+            }
+            popSeparator(out, start);
+        }
+    };
+
+    // Frozen document
+
+    FrozenDocument::FrozenDocument(std::string_view buffer, const FrozenOptions& options)
+        : buffer(buffer)
+        , maxDepth(options.maxDepth)
+    {
+        if (buffer.size() < headerSize || std::memcmp(buffer.data(), magic, sizeof(magic)) != 0)
+            throw FrozenFormatException("Buffer is not a frozen document");
+
+        Renderer renderer(*this);
+        size_t offset = 4;
+        if (renderer.readInteger(offset) != version)
+            throw FrozenFormatException("Unsupported version of frozen document");
+        if (renderer.readInteger(offset) != buffer.size())
+            throw FrozenFormatException("Frozen document is truncated");
+        uint32_t expected = renderer.readInteger(offset);
+        if (options.verifyChecksum && expected != checksum(buffer.substr(headerSize)))
+            throw FrozenFormatException("Frozen document checksum mismatch");
+
+        Renderer::Node root = renderer.readNode(headerSize);
+        if (root.kind != FrozenNode::Document)
+            throw FrozenFormatException("Frozen document root is corrupted");
+
+        offset = root.fields;
+        this->addCharset = renderer.readInteger(offset) != 0;
+        this->referenceCount = renderer.readInteger(offset);
+        this->referenceTable = offset;
+
+        // Elements follow the last reference
+        offset += static_cast<size_t>(this->referenceCount) * 4;
+        for (uint32_t i = 0; i < this->referenceCount; i++)
+        {
+            renderer.readString(offset);
+            renderer.readString(offset);
+            renderer.readString(offset);
+        }
+
+        this->elementCount = root.count;
+        this->elements = offset;
+    }
+
+    size_t FrozenDocument::elementsCount() const
+    {
+        return this->elementCount;
+    }
+
+    std::string FrozenDocument::getText() const
+    {
+        Renderer renderer(*this);
+
+        std::string result;
+        size_t offset = this->elements;
+        for (uint32_t i = 0; i < this->elementCount; i++)
+        {
+            offset = renderer.elementText(offset, result);
+            result += '\n';
+        }
+
+        popSeparator(result, 0);
+        return result;
+    }
+
+    std::string FrozenDocument::getHtml() const
+    {
+        Renderer renderer(*this);
+
+        std::string result = "<!DOCTYPE html><html><head>";
+        if (this->addCharset)
+            result += "<meta charset=\"utf-8\">";
+        result += "</head><body>";
+
+        size_t offset = this->elements;
+        for (uint32_t i = 0; i < this->elementCount; i++)
+            offset = renderer.elementHtml(offset, result);
+
+        result += "</body></html>";
+        return result;
+    }
+
+    uint32_t FrozenDocument::checksum(std::string_view data)
+    {
+        // 32-bit FNV-1a
+        uint32_t result = 2166136261u;
+        for (char c : data)
+        {
+            result ^= static_cast<unsigned char>(c);
+            result *= 16777619u;
+        }
+        return result;
+    }
+}
@@ -1,6 +1,10 @@
 #include "cppmarkdown/headingelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/paragraphelement.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/sourcemap.h"
 
 #include <cassert>
 
@@ -22,9 +26,12 @@ namespace Markdown
         
         if (heading != Heading::Invalid)
         {
+            std::string text = getHeadingText(line);
+            SourceMap::ContentGuard content(SourceMap::getLineOrigin(text));
+
             auto headingStyle = getDefaultStyle(heading);
             this->heading = heading;
-            this->text = TextEntry(getHeadingText(line), headingStyle);
+            this->text = TextEntry(text, headingStyle);
             return ParseResult(ParseCode::ElementComplete);
         }
 
@@ -34,7 +41,12 @@ namespace Markdown
 
             if (heading != Heading::Invalid)
             {
-                std::string text = std::static_pointer_cast<ParagraphElement>(previous)->text.getMarkdown();
+                auto paragraph = std::static_pointer_cast<ParagraphElement>(previous);
+                std::string text = paragraph->text.getMarkdown();
+
+                // Heading replaces the paragraph, including its lines
+                this->sourceRange = SourceMap::join(previous->sourceRange, this->sourceRange);
+                SourceMap::ContentGuard content(text == paragraph->markdown ? paragraph->origin : ContentOrigin());
 
                 auto headingStyle = getDefaultStyle(heading);
                 this->heading = heading;
@@ -61,6 +73,32 @@ namespace Markdown
         return std::string(static_cast<int>(this->heading) + 1, '#') + this->getText();
     }
 
+    void HeadingElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::Heading, { { "level", std::to_string(static_cast<int>(this->heading)) } });
+        this->text.walk(handler);
+        handler.exitBlock(Type::Heading);
+    }
+
+    void HeadingElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::Heading);
+        this->text.freeze(writer);
+        writer.endNode();
+    }
+
+    void HeadingElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        this->text.measure(usage, Type::Heading);
+    }
+
+    void HeadingElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->text.shrinkToFit();
+    }
+
     std::shared_ptr<MarkdownStyle> HeadingElement::getDefaultStyle(Heading heading)
     {
         if (heading == Heading::Invalid)
@@ -79,6 +117,8 @@ namespace Markdown
         if (pos == std::string::npos)
             return "";
         pos = line.find_first_not_of(' ', pos);
+        if (pos == std::string::npos)
+            return "";
         return line.substr(pos);
     }
 
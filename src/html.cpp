@@ -1,9 +1,123 @@
 #include "cppmarkdown/html.h"
 
 #include <cassert>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPPMARKDOWN_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace Markdown
 {
+	// Escaping
+
+	namespace
+	{
+		using EscapeTable = std::array<bool, 256>;
+
+		EscapeTable makeEscapeTable(EscapeMode mode)
+		{
+			EscapeTable table{};
+			table['&'] = table['<'] = table['>'] = true;
+			if (mode == EscapeMode::Attribute)
+				table['"'] = table['\''] = true;
+			return table;
+		}
+
+		const EscapeTable& getEscapeTable(EscapeMode mode)
+		{
+			static const EscapeTable text = makeEscapeTable(EscapeMode::Text);
+			static const EscapeTable attribute = makeEscapeTable(EscapeMode::Attribute);
+			return mode == EscapeMode::Attribute ? attribute : text;
+		}
+
+		// Find position of the first character requiring escaping, size if there's none
+		size_t findEscaped(const char* data, size_t pos, size_t size, EscapeMode mode)
+		{
+#ifdef CPPMARKDOWN_SSE2
+			// Skip clean 16 byte blocks, the block containing special character is scanned below
+			const __m128i amp = _mm_set1_epi8('&');
+			const __m128i lt = _mm_set1_epi8('<');
+			const __m128i gt = _mm_set1_epi8('>');
+			const __m128i quot = _mm_set1_epi8('"');
+			const __m128i apos = _mm_set1_epi8('\'');
+			const bool attribute = mode == EscapeMode::Attribute;
+
+			while (pos + 16 <= size)
+			{
+				__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+				__m128i found = _mm_or_si128(_mm_cmpeq_epi8(block, amp), _mm_or_si128(_mm_cmpeq_epi8(block, lt), _mm_cmpeq_epi8(block, gt)));
+				if (attribute)
+					found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(block, quot), _mm_cmpeq_epi8(block, apos)));
+
+				if (_mm_movemask_epi8(found))
+					break;
+
+				pos += 16;
+			}
+#endif
+
+			const EscapeTable& table = getEscapeTable(mode);
+			for (; pos < size; pos++)
+			{
+				if (table[static_cast<unsigned char>(data[pos])])
+					return pos;
+			}
+
+			return size;
+		}
+
+		const char* getEntity(char chr)
+		{
+			switch (chr)
+			{
+			case '&': return "&amp;";
+			case '<': return "&lt;";
+			case '>': return "&gt;";
+			case '"': return "&quot;";
+			case '\'': return "&#39;";
+			}
+
+			assert(false && "Character does not require escaping");
+			return "";
+		}
+	}
+
+	void appendEscapedHtml(std::string& target, const char* data, size_t size, EscapeMode mode)
+	{
+		size_t pos = 0;
+		while (pos < size)
+		{
+			// Copy clean run at once
+			size_t special = findEscaped(data, pos, size, mode);
+			target.append(data + pos, special - pos);
+			if (special == size)
+				break;
+
+			target.append(getEntity(data[special]));
+			pos = special + 1;
+		}
+	}
+
+	void appendEscapedHtml(std::string& target, const std::string& source, EscapeMode mode)
+	{
+		appendEscapedHtml(target, source.data(), source.size(), mode);
+	}
+
+	std::string escapeHtml(const std::string& source, EscapeMode mode)
+	{
+		std::string result;
+		result.reserve(source.size());
+		appendEscapedHtml(result, source, mode);
+		return result;
+	}
+
+	// Tag builder
+
 	Tag::Tag(const std::string& name)
 		: result("<" + name)
 	{
@@ -17,7 +131,9 @@ namespace Markdown
 
 	Tag& Tag::addattribute(const std::string& name, const std::string& value)
 	{
-		this->result += " " + name + "=\"" + value + "\"";
+		this->result.append(1, ' ').append(name).append("=\"");
+		appendEscapedHtml(this->result, value, EscapeMode::Attribute);
+		this->result.append(1, '"');
 		return *this;
 	}
 
@@ -42,6 +158,73 @@ namespace Markdown
 		return *currentProvider;
 	}
 
+	bool HtmlProvider::isUrlAllowed(const std::string& url) const
+	{
+		static const std::vector<std::string> allowedSchemes = { "http", "https", "mailto", "ftp" };
+
+		std::string scheme = getUrlScheme(url);
+		return scheme.empty() || std::find(allowedSchemes.begin(), allowedSchemes.end(), scheme) != allowedSchemes.end();
+	}
+
+	std::string HtmlProvider::getFingerprint() const
+	{
+		std::string result;
+		auto add = [&result](const std::pair<std::string, std::string>& tags) {
+			result += tags.first;
+			result += '\0';
+			result += tags.second;
+			result += '\0';
+		};
+
+		add(this->getBlockquote());
+		add(this->getParagraph());
+		for (int h = 1; h <= 6; h++)
+			add(this->getHeading(h));
+		add(this->getCode());
+		add(this->getOrderedList());
+		add(this->getUnorderedList());
+		add(this->getListItem());
+		add(this->getImage("alt", "url", "title"));
+		add(this->getLink("url", "title"));
+		add(this->getTable());
+		add(this->getTableRow());
+		add(this->getTableCell());
+		add(this->getTableHeader());
+		add(this->getLineBreak());
+		add(this->getLine());
+		add(this->getEmphasis());
+		add(this->getStrong());
+		add(this->getInlineCode());
+
+		for (const char* url : { "http:", "https:", "mailto:", "ftp:", "file:", "data:", "javascript:", "vbscript:" })
+			result += this->isUrlAllowed(url) ? '1' : '0';
+
+		return result;
+	}
+
+	std::string HtmlProvider::getUrlScheme(const std::string& url)
+	{
+		std::string scheme;
+		for (char chr : url)
+		{
+			// Browsers ignore whitespace and control characters, e.g. "java\tscript:"
+			if (static_cast<unsigned char>(chr) <= ' ')
+				continue;
+
+			if (chr == ':')
+				return scheme;
+
+			bool valid = std::isalpha(static_cast<unsigned char>(chr)) ||
+				(!scheme.empty() && (std::isdigit(static_cast<unsigned char>(chr)) || chr == '+' || chr == '-' || chr == '.'));
+			if (!valid)
+				break;
+
+			scheme.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(chr))));
+		}
+
+		return "";
+	}
+
 	// Default provider
 
 	std::pair<std::string, std::string> DefaultHtmlProvider::getBlockquote() const
@@ -1,4 +1,7 @@
 #include "cppmarkdown/linebreakelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/html.h"
 
 #include <cassert>
@@ -47,6 +50,23 @@ namespace Markdown
         return "\n";
     }
 
+    void LineBreakElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::LineBreak, {});
+        handler.exitBlock(Type::LineBreak);
+    }
+
+    void LineBreakElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::LineBreak);
+        writer.endNode();
+    }
+
+    void LineBreakElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+    }
+
     bool LineBreakElement::isAllWhitespace(const std::string& line)
     {
         return std::all_of(line.begin(), line.end(), [](char c) { return std::isspace(c); });
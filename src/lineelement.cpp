@@ -1,4 +1,7 @@
 #include "cppmarkdown/lineelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/paragraphelement.h"
 #include "cppmarkdown/html.h"
 
@@ -28,6 +31,8 @@ namespace Markdown
         
         std::vector<char> linechars = {'*', '-', '_'};
         std::string txttrimmed = trimmed(line);
+        if (txttrimmed.length() < 3)
+            return ParseResult(ParseCode::Invalid);
 
         for (char c : linechars)
         {
@@ -53,4 +58,22 @@ namespace Markdown
     {
         return std::string(this->textLineLength, this->textLineCharacter);
     }
+
+    void LineElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::Line, {});
+        handler.exitBlock(Type::Line);
+    }
+
+    void LineElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::Line);
+        writer.writeString(this->getText());
+        writer.endNode();
+    }
+
+    void LineElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+    }
 }
\ No newline at end of file
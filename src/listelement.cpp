@@ -1,7 +1,13 @@
 #include "cppmarkdown/listelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/linebreakelement.h"
 #include "cppmarkdown/blankelement.h"
+#include "cppmarkdown/paragraphelement.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/parselimits.h"
 
 #include <sstream>
 #include <cassert>
@@ -13,13 +19,26 @@ namespace Markdown
     // List item
 
     ListItem::ListItem(const std::string& text)
+        : ElementContainer(this)
     {
-        if (!text.empty())
-            this->parse(ListElement::getListItemText(text), nullptr);
+        size_t begin = 0;
+        while (begin < text.size())
+        {
+            size_t end = std::min(text.find('\n', begin), text.size());
+            std::string line = text.substr(begin, end - begin);
+
+            if (begin == 0)
+                this->parse(line, nullptr);
+            else
+                this->supply(line, nullptr);
+
+            begin = end + 1;
+        }
     }
 
     ListItem::ListItem(ListElement* parent)
-        : parent(parent)
+        : ElementContainer(this)
+        , parent(parent)
     {
     }
 
@@ -52,53 +71,72 @@ namespace Markdown
         ListElement::ListMarker marker = ListElement::getListLevel(line, true);
         this->level = marker.level;
 
-        ElementContainer::parse(ListElement::getListItemText(line));
-        this->buffer += line + "\n";
+        if (ListElement::findMarker(line) == std::string::npos)
+            this->parseContent(ltrimmed(line));
+        else
+            this->parseContent(ListElement::getListText(line));
+
         return ParseResult(ParseCode::RequestMore);
     }
 
-    ParseResult ListItem::supply(const std::string& line, std::shared_ptr<Element> previous)
+    ParseResult ListItem::supply(const std::string& line, std::shared_ptr<Element>)
     {
-        ListElement::ListMarker marker = ListElement::getListLevel(line);
+        this->parseContent(ltrimmed(line));
+        return ParseResult(ParseCode::RequestMore);
+    }
 
-        auto lastItem = this->getLastItem();
+    void ListItem::parseContent(const std::string& text)
+    {
+        if (text.empty())
+            return;
 
-        auto lastParentItem = this->parent->getLastItem();
-        if (!lastItem || marker.level <= lastParentItem->getListLevel())
-        {
-            return ParseResult(ParseCode::ElementCompleteParseNext);
-        }
+        // Content is nested in the item and its list, and in the items and lists containing them
+        ParseLimiter::BlockScope depth(this->parent ? 2 + 2 * this->parent->nesting : 2);
 
-        ParseResult result;
-        if (auto container = std::dynamic_pointer_cast<ElementContainer>(lastItem))
+        // Paragraphs are masked out - plain text is kept in blank elements, so it's not wrapped in paragraph tags
+        std::shared_ptr<Element> element;
+        ParseResult result = this->parseLine(text, nullptr, nullptr, 1 << Type::Paragraph);
+
+        switch (result.code)
         {
-            std::string listText = ListElement::getListTextWithMarker(line);
-            result = container->parseLine(listText, previous, previous);
-            if (result.element)
-                result.element->finalize();
-        }
+        case ParseCode::RequestMore:
+            result.element->finalize();
+            element = result.element;
+            break;
 
-        if (result.code == ParseCode::Invalid)
+        case ParseCode::ElementComplete:
+            // Paragraph only replaces a refused element, kept as written in a blank element like the rest of the text
+            if (result.element->getType() == Type::Paragraph)
+            {
+                SourceMap::ContentGuard content(SourceMap::getLineOrigin(text));
+                element = std::make_shared<BlankElement>(text, SpanSearchFlags::AddEmpty | SpanSearchFlags::Literal);
+            }
+            else
+                element = result.element;
+            break;
+
+        default:
         {
-            ElementContainer::parse(ListElement::getListItemText(line));
-            this->replaceElements(Type::Paragraph, toBlankElement);
+            SourceMap::ContentGuard content(SourceMap::getLineOrigin(text));
+            element = std::make_shared<BlankElement>(text);
+            break;
+        }
         }
 
-        this->buffer += line + "\n";
-        return ParseResult(ParseCode::RequestMore);
+        this->appendElement(element);
     }
 
-    void ListItem::finalize()
+    void ListItem::appendElement(std::shared_ptr<Element> element)
     {
-        std::string text = ListElement::getListItemText(this->buffer);
-
-        for (auto& el : this->elements)
-            el->parent = this;
+        if (SourceMap* sourceMap = SourceMap::get())
+            sourceMap->extend(*element);
 
-        if (!this->elements.empty() && this->elements.front()->getType() == Type::Paragraph)
-            this->replaceElement(this->elements.begin(), std::make_shared<BlankElement>(this->elements.front()->getInnerHtml()));
+        // Consecutive lines of text are separated with line breaks
+        auto last = this->getLastItem();
+        if (last && last->getType() == Type::Blank && element->getType() == Type::Blank)
+            ElementContainer::addElement(std::make_shared<LineBreakElement>());
 
-        this->iterate(prependBlankElementsWithNewlines);
+        ElementContainer::addElement(element);
     }
 
     ElementContainer& ListItem::getContainer()
@@ -145,6 +183,46 @@ namespace Markdown
         return html;
     }
 
+    void ListItem::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::ListItem, {});
+        this->text.walk(handler);
+        for (const auto& element : this->elements)
+        {
+            element->walk(handler);
+        }
+        handler.exitBlock(Type::ListItem);
+    }
+
+    void ListItem::freeze(FrozenWriter& writer) const
+    {
+        // Count of the spans tells them apart from the nested elements that follow
+        writer.beginElement(Type::ListItem);
+        writer.writeInteger(static_cast<uint32_t>(this->text.spans.size()));
+        this->text.freeze(writer);
+        for (const auto& element : this->elements)
+        {
+            element->freeze(writer);
+        }
+        writer.endNode();
+    }
+
+    void ListItem::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        this->text.measure(usage, Type::ListItem);
+        usage.addString(Type::ListItem, this->label);
+        this->measureElements(usage, Type::ListItem);
+    }
+
+    void ListItem::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->text.shrinkToFit();
+        this->label.shrink_to_fit();
+        this->shrinkElements();
+    }
+
     std::string ListItem::dump(int indent) const
     {
         std::string result = Element::dump(indent) + "\n";
@@ -155,8 +233,10 @@ namespace Markdown
     // List element
 
     ListElement::ListElement(const std::string& text)
+        : ElementContainer(this)
     {
-        ElementContainer::parse(text);
+        if (!text.empty())
+            ElementContainer::parse(text);
     }
 
     ParseResult ListElement::parseLine(const std::string& line, std::shared_ptr<Element> previous, std::shared_ptr<Element> active, Type)
@@ -182,52 +262,105 @@ namespace Markdown
         if (!marker)
             return ParseResult(ParseCode::Invalid);
 
-        auto item = std::make_shared<ListItem>(this);
-        auto result = item->parse(line, nullptr);
-        result.element = item;
-
-        if (result.code != ParseCode::Invalid)
+        // List and its item take two levels, past the block depth limit the line is kept as written
+        ParseLimiter* limiter = ParseLimiter::get();
+        if (limiter && limiter->getBlockLevels() < 2)
         {
-            this->listType = marker.type;
-            ElementContainer::addElement(item);
+            limiter->exceed(Limit::BlockDepth);
+            auto paragraph = std::make_shared<ParagraphElement>();
+            return ParseResult(paragraph->parseLiteral(line).code, ParseFlags::Replace, paragraph);
         }
 
-        return result;
+        this->level = marker.level;
+        this->openLists = { this };
+
+        auto item = this->appendItem(line, marker.type);
+        return ParseResult(ParseCode::RequestMore, ParseFlags::None, item);
     }
 
     ParseResult ListElement::supply(const std::string& line, std::shared_ptr<Element> previous)
     {
-        auto result = this->getLastItem()->supply(line, nullptr);
+        if (this->openLists.empty())
+            return this->parse(line, previous);
 
-        if (result.code == ParseCode::ElementCompleteParseNext)
-        {
-            this->getLastItem()->finalize();
-            result = this->parse(line, previous);
-        }
+        if (line.empty())
+            return ParseResult(ParseCode::ElementCompleteParseNext);
+
+        ListMarker marker = getListLevel(line);
+        std::shared_ptr<ListItem> item;
 
-        if (result.code == ParseCode::Invalid)
+        if (marker)
         {
-            result.code = ParseCode::ElementCompleteParseNext;
+            // Close lists nested deeper than the marker
+            while (this->openLists.size() > 1 && this->openLists.back()->level > marker.level)
+                this->openLists.pop_back();
+
+            ListElement* list = this->openLists.back();
+            ParseLimiter* limiter = ParseLimiter::get();
+            if (list->level >= marker.level)
+            {
+                item = list->appendItem(line, marker.type);
+            }
+            else if (limiter && limiter->getBlockLevels() < 2 * list->nesting + 4)
+            {
+                // Sublist past the block depth limit, the line continues the item as plain text
+                limiter->exceed(Limit::BlockDepth);
+                item = list->getLastItem();
+                item->supply(line, previous);
+            }
+            else
+            {
+                auto sublist = std::make_shared<ListElement>();
+                sublist->level = marker.level;
+                sublist->nesting = list->nesting + 1;
+                item = sublist->appendItem(line, marker.type);
+
+                list->getLastItem()->appendElement(sublist);
+                this->openLists.push_back(sublist.get());
+            }
         }
-        else if (result.code != ParseCode::RequestMore)
+        else
         {
-            ElementContainer::addElement(result.element);
-            result.code = ParseCode::RequestMore;
+            // Text which is not indented past the list completes it
+            if (marker.level <= this->level)
+                return ParseResult(ParseCode::ElementCompleteParseNext);
+
+            // Otherwise it continues the most nested item indented less than the text
+            while (this->openLists.size() > 1 && this->openLists.back()->level >= marker.level)
+                this->openLists.pop_back();
+
+            item = this->openLists.back()->getLastItem();
+            item->supply(line, previous);
         }
-        else
+
+        // The line belongs to every open list and to the item of each of them containing the nested one
+        if (SourceMap* sourceMap = SourceMap::get())
         {
-            result.element = this->getLastItem();
+            for (ListElement* list : this->openLists)
+            {
+                sourceMap->extend(*list);
+                sourceMap->extend(*list->getLastItem());
+            }
         }
 
-        return result;
+        return ParseResult(ParseCode::RequestMore, ParseFlags::None, item);
     }
 
     void ListElement::finalize()
     {
-        for (auto item : this->elements)
-        {
-            item->finalize();
-        }
+        this->openLists.clear();
+    }
+
+    std::shared_ptr<ListItem> ListElement::appendItem(const std::string& line, ListType type)
+    {
+        auto item = std::make_shared<ListItem>(this);
+        if (SourceMap* sourceMap = SourceMap::get())
+            sourceMap->extend(*item);
+        item->parse(line, nullptr);
+
+        this->listType = type;
+        ElementContainer::addElement(item);
+        return item;
     }
 
     std::shared_ptr<ListItem> ListElement::getLastItem() const
@@ -294,6 +427,41 @@ namespace Markdown
         return this->getText();
     }
 
+    void ListElement::walk(ElementHandler& handler) const
+    {
+        handler.enterBlock(Type::List, { { "type", this->listType == ListType::Ordered ? "ordered" : "unordered" } });
+        for (const auto& element : this->elements)
+        {
+            element->walk(handler);
+        }
+        handler.exitBlock(Type::List);
+    }
+
+    void ListElement::freeze(FrozenWriter& writer) const
+    {
+        writer.beginElement(Type::List);
+        writer.writeInteger(this->listType == ListType::Ordered ? 1 : 0);
+        for (const auto& element : this->elements)
+        {
+            element->freeze(writer);
+        }
+        writer.endNode();
+    }
+
+    void ListElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        usage.addVector(Type::List, this->openLists);
+        this->measureElements(usage, Type::List);
+    }
+
+    void ListElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->openLists.shrink_to_fit();
+        this->shrinkElements();
+    }
+
     std::string ListElement::dump(int indent) const
     {
         return ElementContainer::dump(indent);
@@ -349,6 +517,10 @@ namespace Markdown
                 return { std::string::npos, std::string::npos };
         }
 
+        // Dot starting the text has no number
+        if (numlen == 0)
+            return { std::string::npos, std::string::npos };
+
         return { pos, numlen };
     }
 
@@ -420,7 +592,12 @@ namespace Markdown
         auto pos = findMarker(line);
         if (pos == std::string::npos)
             return "";
-        return line.substr(line.find_first_not_of(' ', pos + 1));
+
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos)
+            return "";
+
+        return line.substr(pos);
     }
 
     std::string ListElement::getListTextWithMarker(const std::string& line)
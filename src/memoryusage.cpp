@@ -0,0 +1,66 @@
+#include "cppmarkdown/memoryusage.h"
+#include "cppmarkdown/textentry.h"
+
+namespace Markdown
+{
+    MemoryUsage::Breakdown& MemoryUsage::Breakdown::operator+=(const Breakdown& b)
+    {
+        this->elements += b.elements;
+        this->spans += b.spans;
+        this->strings += b.strings;
+        this->stringsUsed += b.stringsUsed;
+        this->vectors += b.vectors;
+        this->vectorsUsed += b.vectorsUsed;
+        this->styles += b.styles;
+        this->references += b.references;
+        return *this;
+    }
+
+    MemoryUsage::Breakdown MemoryUsage::getTotal() const
+    {
+        Breakdown result;
+        for (const auto& breakdown : this->types)
+            result += breakdown;
+        return result;
+    }
+
+    size_t MemoryUsage::total() const
+    {
+        return this->getTotal().total();
+    }
+
+    void MemoryUsage::addObject(Type type, size_t size)
+    {
+        (*this)[type].elements += size;
+    }
+
+    void MemoryUsage::addString(Type type, const std::string& str)
+    {
+        // Short strings are stored inside of the object
+        static const size_t inlineCapacity = std::string().capacity();
+        if (str.capacity() <= inlineCapacity)
+            return;
+
+        Breakdown& breakdown = (*this)[type];
+        breakdown.strings += str.capacity() + 1;
+        breakdown.stringsUsed += str.size() + 1;
+    }
+
+    void MemoryUsage::addStyle(Type type, const std::shared_ptr<MarkdownStyle>& style)
+    {
+        if (!style || !this->styles.insert(style.get()).second)
+            return;
+
+        // Strings of the style count as the style as well
+        MemoryUsage strings;
+        strings.addString(type, style->markdownOpening);
+        strings.addString(type, style->markdownClosing);
+        strings.addString(type, style->style.openingTag);
+        strings.addString(type, style->style.closingTag);
+        strings.addVector(type, style->autoescape);
+        for (const auto& escape : style->autoescape)
+            strings.addString(type, escape);
+
+        (*this)[type].styles += sizeof(MarkdownStyle) + strings.total();
+    }
+}
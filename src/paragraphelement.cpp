@@ -1,6 +1,10 @@
 #include "cppmarkdown/paragraphelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 #include "cppmarkdown/linebreakelement.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/sourcemap.h"
 
 #include <vector>
 
@@ -14,6 +18,7 @@ namespace Markdown
 
 	ParagraphElement::ParagraphElement(const std::string& content)
 		: text(content, getParagraphStyle())
+		, markdown(content)
 	{
 	}
 
@@ -23,26 +28,62 @@ namespace Markdown
 	}
 
 	ParseResult ParagraphElement::parse(const std::string& line, std::shared_ptr<Element> previous)
+	{
+		this->literal = false;
+		return this->parseText(line);
+	}
+
+	ParseResult ParagraphElement::parseLiteral(const std::string& line)
+	{
+		this->literal = true;
+		return this->parseText(line);
+	}
+
+	ParseResult ParagraphElement::parseText(const std::string& line)
 	{
 		std::string text = getMarkdownText(line);
 
 		if (text.empty())
 			return ParseResult(ParseCode::Invalid);
 
-		this->text = TextEntry(text, getParagraphStyle());
+		this->origin = SourceMap::getLineOrigin(text);
+		SourceMap::ContentGuard content(this->origin);
+		this->text = TextEntry(text, getParagraphStyle(), this->getSearchFlags());
+		this->markdown = std::move(text);
 
 		return ParseResult(ParseCode::ElementComplete);
 	}
 
+	SpanSearchFlags ParagraphElement::getSearchFlags() const
+	{
+		if (this->literal)
+			return SpanSearchFlags::AddEmpty | SpanSearchFlags::Literal;
+
+		return SpanSearchFlags::AddEmpty;
+	}
+
 	FinalizeAction ParagraphElement::documentFinalize(std::shared_ptr<Element> previous)
 	{
 		if (previous && previous->getType() == Type::Paragraph)
 		{
 			auto previousParagraph = std::static_pointer_cast<ParagraphElement>(previous);
 			
-			if (!text.empty() && !previousParagraph->text.empty())
+			if (!text.empty() && !previousParagraph->text.empty() && previousParagraph->literal == this->literal)
 			{
-				this->text = TextEntry(previousParagraph->getMarkdown() + " " + this->getMarkdown(), getParagraphStyle());
+				// Parsing the joined text for every line would be quadratic in the number of lines
+				this->sourceRange = SourceMap::join(previous->sourceRange, this->sourceRange);
+				if (SourceMap::get())
+				{
+					// Parts of this line follow the previous lines and the space joining them
+					uint32_t shift = static_cast<uint32_t>(previousParagraph->markdown.size() + 1);
+					if (this->origin.empty() || this->origin.front().content > 0)
+						this->origin.insert(this->origin.begin(), { 0, SourceRange::npos });
+					for (auto& part : this->origin)
+						part.content += shift;
+					this->origin.insert(this->origin.begin(), previousParagraph->origin.begin(), previousParagraph->origin.end());
+				}
+				this->markdown = std::move(previousParagraph->markdown) + " " + this->markdown;
+				this->joined = true;
 				return FinalizeAction::ErasePrevious | FinalizeAction::Continue;
 			}
 		}
@@ -53,6 +94,21 @@ namespace Markdown
 		return FinalizeAction::None;
 	}
 
+	void ParagraphElement::finishDocumentFinalize()
+	{
+		// Source and origin are needed only while parsing, the text keeps its own copy
+		SourceMap::ContentGuard content(std::move(this->origin));
+		this->origin = {};
+		std::string markdown = std::move(this->markdown);
+		this->markdown = {};
+
+		if (!this->joined)
+			return;
+
+		this->text = TextEntry(markdown, getParagraphStyle(), this->getSearchFlags());
+		this->joined = false;
+	}
+
 	std::string ParagraphElement::getText() const
 	{
 		return this->text.getText();
@@ -72,4 +128,32 @@ namespace Markdown
 	{
 		return this->text.getMarkdown();
 	}
+
+	void ParagraphElement::walk(ElementHandler& handler) const
+	{
+		handler.enterBlock(Type::Paragraph, {});
+		this->text.walk(handler);
+		handler.exitBlock(Type::Paragraph);
+	}
+
+	void ParagraphElement::freeze(FrozenWriter& writer) const
+	{
+		writer.beginElement(Type::Paragraph);
+		this->text.freeze(writer);
+		writer.endNode();
+	}
+
+	void ParagraphElement::measure(MemoryUsage& usage) const
+	{
+		this->measureElement(usage, sizeof(*this));
+		this->text.measure(usage, Type::Paragraph);
+		usage.addString(Type::Paragraph, this->markdown);
+	}
+
+	void ParagraphElement::shrinkToFit()
+	{
+		Element::shrinkToFit();
+		this->text.shrinkToFit();
+		this->markdown.shrink_to_fit();
+	}
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include "cppmarkdown/parselimits.h"
+
+namespace Markdown
+{
+    namespace
+    {
+        // Calls between reading the clock
+        const unsigned int deadlineInterval = 32;
+    }
+
+    // Limits
+
+    bool ParseLimits::unlimited() const
+    {
+        return
+            this->maxInputBytes == SIZE_MAX &&
+            this->maxBlockDepth == SIZE_MAX &&
+            this->maxInlineDepth == SIZE_MAX &&
+            this->maxTableColumns == SIZE_MAX &&
+            this->maxSpansPerEntry == SIZE_MAX &&
+            this->timeout == std::chrono::steady_clock::duration::max();
+    }
+
+    // Limiter
+
+    ParseLimiter::ContextGuard::ContextGuard(ParseLimiter& limiter)
+        : ThreadContext<ParseLimiter>::ContextGuard(limiter.limits.unlimited() ? nullptr : &limiter)
+    {
+    }
+
+    ParseLimiter::ParseLimiter(const ParseLimits& limits)
+    {
+        this->reset(limits);
+    }
+
+    void ParseLimiter::reset(const ParseLimits& limits)
+    {
+        this->limits = limits;
+        this->exceeded = Limit::None;
+        this->blockDepth = 0;
+        this->inlineDepth = 0;
+        this->entrySpans = 0;
+        this->countdown = 0;
+
+        auto now = std::chrono::steady_clock::now();
+        if (limits.timeout < std::chrono::steady_clock::time_point::max() - now)
+            this->deadline = now + limits.timeout;
+        else
+            this->deadline = std::chrono::steady_clock::time_point::max();
+    }
+
+    const ParseLimits& ParseLimiter::getLimits() const
+    {
+        return this->limits;
+    }
+
+    Limit ParseLimiter::getExceeded() const
+    {
+        return this->exceeded;
+    }
+
+    void ParseLimiter::exceed(Limit limit)
+    {
+        // Nesting is refused once the deadline passed, it's not reported as the depth limit
+        if (limit == Limit::BlockDepth && this->expired())
+            return;
+
+        this->exceeded |= limit;
+    }
+
+    size_t ParseLimiter::getBlockLevels() const
+    {
+        if (this->expired() || this->limits.maxBlockDepth <= this->blockDepth + 1)
+            return 0;
+
+        return this->limits.maxBlockDepth - this->blockDepth - 1;
+    }
+
+    void ParseLimiter::checkDeadline()
+    {
+        if (this->expired())
+            return;
+
+        if (this->countdown > 0)
+        {
+            this->countdown--;
+            return;
+        }
+
+        this->countdown = deadlineInterval;
+        if (std::chrono::steady_clock::now() >= this->deadline)
+            this->exceed(Limit::Deadline);
+    }
+
+    bool ParseLimiter::expired() const
+    {
+        return this->exceeded & Limit::Deadline;
+    }
+
+    bool ParseLimiter::allowsStyles(const std::string& text)
+    {
+        if (this->expired())
+            return false;
+
+        if (this->inlineDepth > this->limits.maxInlineDepth)
+        {
+            // Only reported if the text could hold a style
+            if (text.find_first_of("*_`[!") != std::string::npos)
+                this->exceed(Limit::InlineDepth);
+            return false;
+        }
+
+        return true;
+    }
+
+    void ParseLimiter::beginEntry()
+    {
+        this->entrySpans = 0;
+    }
+
+    void ParseLimiter::countSpan()
+    {
+        this->entrySpans++;
+    }
+
+    bool ParseLimiter::spansExhausted()
+    {
+        if (this->entrySpans < this->limits.maxSpansPerEntry)
+            return false;
+
+        this->exceed(Limit::SpansPerEntry);
+        return true;
+    }
+}
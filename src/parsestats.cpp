@@ -0,0 +1,68 @@
+#include "cppmarkdown/parsestats.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/elementhandler.h"
+
+#include <algorithm>
+
+namespace Markdown
+{
+    namespace
+    {
+        // Counts the elements of the parsed document and their nesting
+        struct ElementCounter : public ElementHandler
+        {
+            ParseStats& stats;
+            size_t depth = 0;
+
+            ElementCounter(ParseStats& stats)
+                : stats(stats)
+            {
+            }
+
+            virtual void enterBlock(Type type, const Attributes&) override
+            {
+                this->stats.elements[ParseStats::index(type)]++;
+                this->depth++;
+                this->stats.peakDepth = std::max(this->stats.peakDepth, this->depth);
+            }
+
+            virtual void exitBlock(Type) override
+            {
+                this->depth--;
+            }
+        };
+    }
+
+    // Collector
+
+    ParseStatsCollector::ParseStatsCollector(ParseStats& stats)
+        : stats(stats)
+        , statsGuard(stats)
+        , guard(*this)
+    {
+    }
+
+    std::chrono::steady_clock::duration ParseStatsCollector::read() const
+    {
+        return std::chrono::steady_clock::now().time_since_epoch();
+    }
+
+    void ParseStatsCollector::finish(const std::string& source, const ElementContainer& elements)
+    {
+        this->stats.bytes = source.size();
+        this->stats.lines = std::count(source.begin(), source.end(), '\n');
+        if (!source.empty() && source.back() != '\n')
+            this->stats.lines++;
+
+        ElementCounter counter(this->stats);
+        for (const auto& element : elements)
+            element->walk(counter);
+
+        auto seconds = [this](Phase phase) {
+            return std::chrono::duration<double>(this->getTotal(phase)).count();
+        };
+        this->stats.blockParseSeconds = seconds(Phase::LineSplit) + seconds(Phase::BlockParse);
+        this->stats.inlineParseSeconds = seconds(Phase::InlineParse);
+        this->stats.finalizeSeconds = seconds(Phase::Finalize);
+    }
+}
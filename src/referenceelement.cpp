@@ -1,6 +1,10 @@
 #include "cppmarkdown/referenceelement.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/memoryusage.h"
 
 #include <sstream>
+#include <algorithm>
 
 namespace Markdown
 {
@@ -31,8 +35,14 @@ namespace Markdown
 		do
 		{
 			end = line.find_first_of(']', end);
-			if (end == std::string::npos || line[end - 1] == '\\')
+			if (end == std::string::npos)
+				break;
+
+			if (line[end - 1] == '\\')
+			{
+				end++;
 				continue;
+			}
 			found = true;
 		} while (end != std::string::npos && !found);
 
@@ -48,6 +58,8 @@ namespace Markdown
 
         // Find URL
 		size_t beginUrl = end + 2;
+        if (beginUrl >= line.length())
+            return ParseResult(ParseCode::Invalid);
 
         while (std::isspace(line.at(beginUrl)))
         {
@@ -56,7 +68,7 @@ namespace Markdown
                 return ParseResult(ParseCode::Invalid);
         }
 
-		size_t endUrl = beginUrl + 1;
+		size_t endUrl = std::min(beginUrl + 1, line.length() - 1);
 
         while (!std::isspace(line.at(endUrl)) || line.at(endUrl - 1) == '\\')
         {
@@ -84,7 +96,7 @@ namespace Markdown
                 char titleChar = line.at(titleBegin);
                 char endingChar = titleCharMap.at(titleChar);
 
-                titleEnd = titleBegin + 1;
+                titleEnd = std::min(titleBegin + 1, line.length() - 1);
                 while (line.at(titleEnd) != endingChar || line.at(titleEnd - 1) == '\\')
                 {
                     titleEnd++;
@@ -134,4 +146,37 @@ namespace Markdown
     {
         return this->reference.title;
     }
+
+    void ReferenceElement::walk(ElementHandler& handler) const
+    {
+        Attributes attributes{ { "id", this->reference.id }, { "url", this->reference.value } };
+        if (!this->reference.title.empty())
+            attributes.emplace_back("title", this->reference.title);
+
+        handler.enterBlock(Type::Reference, attributes);
+        handler.exitBlock(Type::Reference);
+    }
+
+    void ReferenceElement::freeze(FrozenWriter& writer) const
+    {
+        // The reference itself is frozen with the references of the document
+        writer.beginElement(Type::Reference);
+        writer.endNode();
+    }
+
+    void ReferenceElement::measure(MemoryUsage& usage) const
+    {
+        this->measureElement(usage, sizeof(*this));
+        usage.addString(Type::Reference, this->reference.id);
+        usage.addString(Type::Reference, this->reference.value);
+        usage.addString(Type::Reference, this->reference.title);
+    }
+
+    void ReferenceElement::shrinkToFit()
+    {
+        Element::shrinkToFit();
+        this->reference.id.shrink_to_fit();
+        this->reference.value.shrink_to_fit();
+        this->reference.title.shrink_to_fit();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,456 @@
+#include "cppmarkdown/shareddocumentcache.h"
+
+#ifdef CPPMARKDOWN_SHARED_CACHE
+
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/blockcache.h"
+#include "cppmarkdown/extensions.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <atomic>
+#include <thread>
+#include <system_error>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <algorithm>
+#include <limits>
+
+namespace Markdown
+{
+    namespace
+    {
+        const char magic[4] = { 'C', 'M', 'D', 'S' };
+        constexpr uint32_t version = 1;
+
+        // Slot of a document that didn't fit in the segment, entries are stored at larger offsets
+        constexpr uint64_t unstorable = 1;
+        // Slot of a document being parsed, marking the process id of the claimer and the low bits of its start time
+        constexpr uint64_t parsing = uint64_t(1) << 63;
+        constexpr uint64_t startTimeMask = (uint64_t(1) << 31) - 1;
+
+        // Start time of the process in clock ticks since boot, zero where /proc is not available
+        uint64_t processStartTime(pid_t pid)
+        {
+            char path[32];
+            std::snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+            FILE* file = std::fopen(path, "r");
+            if (!file)
+                return 0;
+
+            char line[1024];
+            size_t length = std::fread(line, 1, sizeof(line) - 1, file);
+            std::fclose(file);
+            line[length] = '\0';
+
+            // Name of the process may contain spaces and parentheses, the fields follow the last parenthesis
+            // Start time is the 22nd field, the 20th after the name
+            const char* field = std::strrchr(line, ')');
+            for (int i = 0; field && i < 20; i++)
+                field = std::strchr(field + 1, ' ');
+
+            unsigned long long startTime = 0;
+            if (!field || std::sscanf(field, " %llu", &startTime) != 1)
+                return 0;
+            return startTime;
+        }
+
+        uint64_t makeClaim()
+        {
+            static const uint64_t startTime = processStartTime(getpid()) & startTimeMask;
+            return parsing | startTime << 32 | static_cast<uint32_t>(getpid());
+        }
+
+        // Taking a claim over is safe even if the claimer is alive - its publish fails and it keeps its own document
+        bool claimerDied(uint64_t state)
+        {
+            pid_t pid = static_cast<pid_t>(state & 0xffffffff);
+            if (kill(pid, 0) != 0 && errno == ESRCH)
+                return true;
+
+            // Alive, or not allowed to be signalled (EPERM) - unless the id was reused by a process started later
+            uint64_t startTime = state >> 32 & startTimeMask;
+            uint64_t current = processStartTime(pid) & startTimeMask;
+            return startTime != 0 && current != 0 && current != startTime;
+        }
+
+        // Longest sleep between checks of a slot being parsed by another process, in microseconds
+        constexpr int64_t maxWaitDelay = 5000;
+
+        constexpr size_t align(size_t size)
+        {
+            return (size + 7) & ~static_cast<size_t>(7);
+        }
+
+        [[noreturn]] void throwError(const char* call)
+        {
+            throw std::system_error(errno, std::generic_category(), call);
+        }
+
+        std::string parseFrozen(std::string_view source, Type mask)
+        {
+            Document document;
+            document.parse(std::string(source), mask);
+            return document.freeze();
+        }
+    }
+
+    // Layout of the segment - the header, the slots and the entries
+    // Entry is the length of the source and of the frozen document, followed by both of them
+
+    struct SharedDocumentCache::Header
+    {
+        char magic[4];
+        uint32_t version;
+        uint64_t size;
+        uint64_t slotCount;
+        uint64_t entriesOffset;
+        std::atomic<uint64_t> used; // End of the last allocated entry
+        std::atomic<uint64_t> entries;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> parses;
+    };
+
+    // Key is claimed by the process parsing the document, followed by its claim in the state
+    // The state is set to the offset of the entry once it's written
+    struct SharedDocumentCache::Slot
+    {
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> state; // Zero until claimed, claim while parsing, offset of the entry or unstorable afterwards
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared document cache requires lock-free 64-bit atomics");
+
+    SharedDocumentCache::SharedDocumentCache(size_t capacity, size_t slotCount)
+    {
+        size_t size = align(sizeof(Header)) + slotCount * sizeof(Slot) + capacity;
+        this->map(-1, size);
+        this->initialize(slotCount);
+    }
+
+    SharedDocumentCache::SharedDocumentCache(const std::string& name, size_t capacity, size_t slotCount)
+    {
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throwError("shm_open");
+
+        size_t size = align(sizeof(Header)) + slotCount * sizeof(Slot) + capacity;
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            int error = errno;
+            close(fd);
+            shm_unlink(name.c_str());
+            errno = error;
+            throwError("ftruncate");
+        }
+
+        try
+        {
+            this->map(fd, size);
+        }
+        catch (...)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw;
+        }
+
+        close(fd);
+        this->initialize(slotCount);
+    }
+
+    SharedDocumentCache SharedDocumentCache::open(const std::string& name)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+            throwError("shm_open");
+
+        struct stat status;
+        if (fstat(fd, &status) != 0)
+        {
+            int error = errno;
+            close(fd);
+            errno = error;
+            throwError("fstat");
+        }
+
+        SharedDocumentCache cache;
+        try
+        {
+            cache.map(fd, static_cast<size_t>(status.st_size));
+        }
+        catch (...)
+        {
+            close(fd);
+            throw;
+        }
+        close(fd);
+
+        const Header& header = cache.header();
+        if (cache.mappedSize < sizeof(Header)
+            || std::memcmp(header.magic, magic, sizeof(magic)) != 0
+            || header.version != version
+            || header.size != cache.mappedSize)
+            throw std::runtime_error("Shared memory segment " + name + " is not a document cache");
+
+        return cache;
+    }
+
+    void SharedDocumentCache::remove(const std::string& name)
+    {
+        if (shm_unlink(name.c_str()) != 0)
+            throwError("shm_unlink");
+    }
+
+    SharedDocumentCache::SharedDocumentCache(SharedDocumentCache&& other) noexcept
+        : waitTimeout(other.waitTimeout)
+        , data(other.data)
+        , mappedSize(other.mappedSize)
+    {
+        other.data = nullptr;
+        other.mappedSize = 0;
+    }
+
+    SharedDocumentCache::~SharedDocumentCache()
+    {
+        if (this->data)
+            munmap(this->data, this->mappedSize);
+    }
+
+    std::optional<FrozenDocument> SharedDocumentCache::find(std::string_view source, Type mask)
+    {
+        Header& header = this->header();
+        Slot* slots = this->slots();
+        uint64_t key = makeKey(source, mask);
+
+        for (uint64_t i = 0; i < header.slotCount; i++)
+        {
+            Slot& slot = slots[(key + i) % header.slotCount];
+            uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+            if (slotKey == 0)
+                break;
+            if (slotKey != key)
+                continue;
+
+            // Different sources with the same key are stored in the following slots
+            uint64_t state = slot.state.load(std::memory_order_acquire);
+            if (state <= unstorable || (state & parsing))
+                continue;
+            if (auto document = this->read(state, source))
+            {
+                header.hits.fetch_add(1, std::memory_order_relaxed);
+                return document;
+            }
+        }
+
+        header.misses.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+
+    FrozenDocument SharedDocumentCache::get(std::string_view source, std::string& fallback, Type mask)
+    {
+        Header& header = this->header();
+        Slot* slots = this->slots();
+        uint64_t key = makeKey(source, mask);
+
+        auto parseFallback = [&]() {
+            header.parses.fetch_add(1, std::memory_order_relaxed);
+            fallback = parseFrozen(source, mask);
+            return FrozenDocument(fallback);
+        };
+
+        for (uint64_t i = 0; i < header.slotCount; i++)
+        {
+            Slot& slot = slots[(key + i) % header.slotCount];
+            uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+            if (slotKey == 0 && slot.key.compare_exchange_strong(slotKey, key, std::memory_order_acq_rel))
+            {
+                // Slot is claimed, no other process will parse the source unless this one dies
+                uint64_t claim = makeClaim();
+                uint64_t state = 0;
+                if (slot.state.compare_exchange_strong(state, claim, std::memory_order_acq_rel))
+                {
+                    header.misses.fetch_add(1, std::memory_order_relaxed);
+                    return this->parse(slot, claim, source, fallback, mask);
+                }
+            }
+
+            if (slot.key.load(std::memory_order_acquire) != key)
+                continue;
+
+            // Wait for the process parsing the document, sleeping longer the longer it takes
+            uint64_t state = slot.state.load(std::memory_order_acquire);
+            auto deadline = std::chrono::steady_clock::now() + this->waitTimeout;
+            auto delay = std::chrono::microseconds(50);
+            while ((state == 0 || (state & parsing)) && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(delay);
+                delay = std::min(delay * 2, std::chrono::microseconds(maxWaitDelay));
+                state = slot.state.load(std::memory_order_acquire);
+            }
+
+            // Take over the claim of a process which died, or which never marked its claim
+            if (state == 0 || ((state & parsing) && claimerDied(state)))
+            {
+                uint64_t claim = makeClaim();
+                if (slot.state.compare_exchange_strong(state, claim, std::memory_order_acq_rel))
+                {
+                    header.misses.fetch_add(1, std::memory_order_relaxed);
+                    return this->parse(slot, claim, source, fallback, mask);
+                }
+            }
+
+            if (state <= unstorable || (state & parsing))
+            {
+                header.misses.fetch_add(1, std::memory_order_relaxed);
+                return parseFallback();
+            }
+
+            if (auto document = this->read(state, source))
+            {
+                header.hits.fetch_add(1, std::memory_order_relaxed);
+                return *document;
+            }
+        }
+
+        // All of the slots are taken
+        header.misses.fetch_add(1, std::memory_order_relaxed);
+        return parseFallback();
+    }
+
+    SharedDocumentCache::Statistics SharedDocumentCache::getStatistics() const
+    {
+        const Header& header = this->header();
+
+        Statistics result;
+        result.hits = header.hits.load(std::memory_order_relaxed);
+        result.misses = header.misses.load(std::memory_order_relaxed);
+        result.parses = header.parses.load(std::memory_order_relaxed);
+        result.entries = header.entries.load(std::memory_order_relaxed);
+        result.capacity = header.size - header.entriesOffset;
+        result.size = std::min(header.used.load(std::memory_order_relaxed), header.size) - header.entriesOffset;
+        return result;
+    }
+
+    void SharedDocumentCache::map(int fd, size_t size)
+    {
+        int flags = fd < 0 ? MAP_SHARED | MAP_ANONYMOUS : MAP_SHARED;
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, 0);
+        if (address == MAP_FAILED)
+            throwError("mmap");
+
+        this->data = static_cast<char*>(address);
+        this->mappedSize = size;
+    }
+
+    void SharedDocumentCache::initialize(size_t slotCount)
+    {
+        if (slotCount == 0)
+            throw std::invalid_argument("Shared document cache requires at least one slot");
+
+        Header* header = new (this->data) Header();
+        header->version = version;
+        header->size = this->mappedSize;
+        header->slotCount = slotCount;
+        header->entriesOffset = align(sizeof(Header)) + slotCount * sizeof(Slot);
+        header->used.store(header->entriesOffset);
+
+        Slot* slots = this->slots();
+        for (size_t i = 0; i < slotCount; i++)
+            new (&slots[i]) Slot();
+
+        // Processes attaching by name check the magic last
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(header->magic, magic, sizeof(magic));
+    }
+
+    SharedDocumentCache::Header& SharedDocumentCache::header() const
+    {
+        return *reinterpret_cast<Header*>(this->data);
+    }
+
+    SharedDocumentCache::Slot* SharedDocumentCache::slots() const
+    {
+        return reinterpret_cast<Slot*>(this->data + align(sizeof(Header)));
+    }
+
+    FrozenDocument SharedDocumentCache::parse(Slot& slot, uint64_t claim, std::string_view source, std::string& fallback, Type mask)
+    {
+        this->header().parses.fetch_add(1, std::memory_order_relaxed);
+
+        std::string frozen;
+        try
+        {
+            frozen = parseFrozen(source, mask);
+        }
+        catch (...)
+        {
+            slot.state.compare_exchange_strong(claim, unstorable, std::memory_order_acq_rel);
+            throw;
+        }
+
+        if (uint64_t offset = this->publish(slot, claim, source, frozen))
+            return *this->read(offset, source);
+
+        fallback = std::move(frozen);
+        return FrozenDocument(fallback);
+    }
+
+    uint64_t SharedDocumentCache::publish(Slot& slot, uint64_t claim, std::string_view source, const std::string& frozen)
+    {
+        Header& header = this->header();
+        size_t size = align(8 + source.size() + frozen.size());
+
+        // Space of an entry that didn't fit is lost, the following ones won't fit either
+        uint64_t offset = header.used.fetch_add(size, std::memory_order_relaxed);
+        if (offset > header.size || header.size - offset < size
+            || source.size() > std::numeric_limits<uint32_t>::max() || frozen.size() > std::numeric_limits<uint32_t>::max())
+        {
+            slot.state.compare_exchange_strong(claim, unstorable, std::memory_order_acq_rel);
+            return 0;
+        }
+
+        char* entry = this->data + offset;
+        uint32_t lengths[2] = { static_cast<uint32_t>(source.size()), static_cast<uint32_t>(frozen.size()) };
+        std::memcpy(entry, lengths, sizeof(lengths));
+        std::memcpy(entry + 8, source.data(), source.size());
+        std::memcpy(entry + 8 + source.size(), frozen.data(), frozen.size());
+
+        // Another process took the claim over, the space of the entry is lost
+        if (!slot.state.compare_exchange_strong(claim, offset, std::memory_order_acq_rel))
+            return 0;
+
+        header.entries.fetch_add(1, std::memory_order_relaxed);
+        return offset;
+    }
+
+    std::optional<FrozenDocument> SharedDocumentCache::read(uint64_t offset, std::string_view source) const
+    {
+        const char* entry = this->data + offset;
+        uint32_t lengths[2];
+        std::memcpy(lengths, entry, sizeof(lengths));
+
+        if (std::string_view(entry + 8, lengths[0]) != source)
+            return {};
+        return FrozenDocument(std::string_view(entry + 8 + lengths[0], lengths[1]));
+    }
+
+    uint64_t SharedDocumentCache::makeKey(std::string_view source, Type mask)
+    {
+        // Documents are parsed with the registered extensions, zero marks an empty slot
+        uint64_t context = BlockCache::hash(static_cast<uint64_t>(mask));
+        context = BlockCache::hash(ExtensionsManager::getInstance().getExtensionCount(), context);
+        uint64_t key = BlockCache::hash(source, context);
+        return key == 0 ? 1 : key;
+    }
+}
+
+#endif
@@ -0,0 +1,182 @@
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/textentry.h"
+
+#include <algorithm>
+
+namespace Markdown
+{
+    namespace
+    {
+        uint32_t toOffset(size_t offset)
+        {
+            // Offsets past 4 GiB are clamped
+            return static_cast<uint32_t>(std::min<size_t>(offset, SourceRange::npos - 1));
+        }
+
+        // Source offset of the content offset, the end of a range belongs to the part before the one starting there
+        uint32_t toSource(const ContentOrigin& origin, size_t offset, bool end)
+        {
+            auto part = std::upper_bound(origin.begin(), origin.end(), offset, [](size_t offset, const ContentPart& part) {
+                return offset < part.content;
+            });
+
+            if (part == origin.begin())
+                return SourceRange::npos;
+            part--;
+
+            if (end && part->content == offset && part != origin.begin())
+                part--;
+
+            if (part->source == SourceRange::npos)
+                return SourceRange::npos;
+            return toOffset(part->source + (offset - part->content));
+        }
+
+        void locateSpan(Span& span, const ContentOrigin* origin, size_t length)
+        {
+            // Span without a range wraps the whole content in the default style, e.g. paragraph
+            SourceRange relative = span.sourceRange;
+            size_t begin = relative.valid() ? relative.begin : 0;
+            size_t end = relative.valid() ? relative.end : length;
+
+            span.sourceRange = SourceRange();
+            if (origin && begin <= end && end <= length)
+            {
+                uint32_t sourceBegin = toSource(*origin, begin, false);
+                uint32_t sourceEnd = toSource(*origin, end, true);
+                if (sourceBegin != SourceRange::npos && sourceEnd != SourceRange::npos && sourceBegin <= sourceEnd)
+                    span.sourceRange = { sourceBegin, sourceEnd };
+            }
+
+            for (auto& child : span.children)
+                locateSpan(*child, origin, length);
+        }
+    }
+
+    // Context
+
+    SourceMap::ContentGuard::ContentGuard(ContentOrigin origin)
+        : map(SourceMap::current)
+        , origin(std::move(origin))
+    {
+        if (this->map)
+        {
+            this->previous = this->map->origin;
+            this->map->origin = &this->origin;
+        }
+    }
+
+    SourceMap::ContentGuard::~ContentGuard()
+    {
+        if (this->map)
+            this->map->origin = this->previous;
+    }
+
+    void SourceMap::Tracker::begin(Element& element)
+    {
+        this->element = &element;
+        this->previousRange = element.sourceRange;
+
+        element.sourceRange = join(element.sourceRange, this->map->line);
+    }
+
+    void SourceMap::Tracker::end()
+    {
+        if (this->rejected)
+            this->element->sourceRange = this->previousRange;
+    }
+
+    // Source map
+
+    void SourceMap::addLine(std::string_view line)
+    {
+        if (!this->lineStarts.empty())
+            this->source.push_back('\n');
+
+        this->lineStarts.push_back(toOffset(this->source.size()));
+        this->source.append(line);
+        this->line = { this->lineStarts.back(), toOffset(this->source.size()) };
+    }
+
+    void SourceMap::clear()
+    {
+        this->source.clear();
+        this->lineStarts.clear();
+        this->line = SourceRange();
+    }
+
+    const std::string& SourceMap::getSource() const
+    {
+        return this->source;
+    }
+
+    std::string_view SourceMap::getText(SourceRange range) const
+    {
+        if (!range.valid() || range.begin > this->source.size())
+            return {};
+
+        return std::string_view(this->source).substr(range.begin, range.length());
+    }
+
+    size_t SourceMap::getLineCount() const
+    {
+        return this->lineStarts.size();
+    }
+
+    SourceLocation SourceMap::getLocation(size_t offset) const
+    {
+        if (this->lineStarts.empty())
+            return {};
+
+        offset = std::min(offset, this->source.size());
+        size_t line = std::upper_bound(this->lineStarts.begin(), this->lineStarts.end(), offset) - this->lineStarts.begin();
+        return { line, offset - this->lineStarts.at(line - 1) + 1 };
+    }
+
+    SourceRange SourceMap::getLineRange(size_t line) const
+    {
+        if (line == 0 || line > this->lineStarts.size())
+            return {};
+
+        uint32_t end = line < this->lineStarts.size() ? this->lineStarts.at(line) - 1 : toOffset(this->source.size());
+        return { this->lineStarts.at(line - 1), end };
+    }
+
+    void SourceMap::extend(Element& element) const
+    {
+        element.sourceRange = join(element.sourceRange, this->line);
+    }
+
+    uint32_t SourceMap::getLineOffset(std::string_view text) const
+    {
+        std::string_view line = this->getText(this->line);
+        if (text.size() > line.size() || line.substr(line.size() - text.size()) != text)
+            return SourceRange::npos;
+
+        return toOffset(this->line.end - text.size());
+    }
+
+    ContentOrigin SourceMap::getLineOrigin(std::string_view text)
+    {
+        if (!SourceMap::current)
+            return {};
+
+        return { { 0, SourceMap::current->getLineOffset(text) } };
+    }
+
+    void SourceMap::locate(std::vector<std::unique_ptr<Span>>::iterator begin, std::vector<std::unique_ptr<Span>>::iterator end, size_t length) const
+    {
+        for (auto it = begin; it != end; ++it)
+            locateSpan(**it, this->origin, length);
+    }
+
+    SourceRange SourceMap::join(SourceRange a, SourceRange b)
+    {
+        if (!a.valid())
+            return b;
+        if (!b.valid())
+            return a;
+
+        return { std::min(a.begin, b.begin), std::max(a.end, b.end) };
+    }
+}
@@ -1,5 +1,12 @@
 #include "cppmarkdown/textentry.h"
 #include "cppmarkdown/html.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/tracer.h"
+#include "cppmarkdown/parsestats.h"
+#include "cppmarkdown/memoryusage.h"
+#include "cppmarkdown/parselimits.h"
 
 #include <queue>
 #include <unordered_map>
@@ -8,32 +15,87 @@ namespace Markdown
 {
 	// Util
 
+	namespace
+	{
+		// Style's last search in the source, searched again only once the found occurrence was passed
+		struct Candidate
+		{
+			MarkdownStyle::Result result;
+			MarkdownStyle::SearchState state;
+			bool searched = false;
+		};
+	}
+
+	// Each style is searched once per occurrence it finds, so a source is searched in linear time
+	// apart from the occurrences overlapping the ones taken before them
 	MarkdownStyle::Result findFirst(
 		const std::string& source,
 		size_t pos,
 		const StyleContainer& stylemap,
+		std::vector<Candidate>& candidates,
 		const std::vector<std::string>& autoescape = {}
 	)
 	{
-		MarkdownStyle::Result result;
+		Candidate* first = nullptr;
 
-		for (const auto& style : stylemap)
+		for (size_t i = 0; i < stylemap.size(); i++)
 		{
+			const auto& style = stylemap[i];
 			if (std::find(autoescape.begin(), autoescape.end(), style->markdownOpening) != autoescape.end())
 				continue; // Autoescape
 
-			MarkdownStyle::Result candidate = style->findIn(source, pos, stylemap);
-			size_t idx = candidate.position;
-			if (idx != std::string::npos && idx < result.position)
+			Candidate& candidate = candidates[i];
+			if (!candidate.searched || (candidate.result && candidate.result.position < pos))
+			{
+				candidate.result = style->findIn(source, pos, stylemap, candidate.state);
+				candidate.searched = true;
+			}
+
+			size_t idx = candidate.result.position;
+			if (idx != std::string::npos && (!first || idx < first->result.position))
 			{
-				result = std::move(candidate);
+				first = &candidate;
 
-				if (idx == 0)
+				if (idx == pos)
 					break;
 			}
 		}
 
-		return result;
+		if (!first)
+			return {};
+
+		first->searched = false;
+		return std::move(first->result);
+	}
+
+	// First unescaped occurrence of the character at or after the position, reusing the last scan for the character
+	static size_t findUnescaped(const std::string& str, char c, size_t pos, MarkdownStyle::SearchState& state)
+	{
+		MarkdownStyle::SearchState::Scan& scan = state.scans[c];
+		if (scan.from <= pos && pos <= scan.found)
+			return scan.found;
+
+		size_t found = str.find(c, pos);
+		while (found != std::string::npos && isEscaped(str, found))
+			found = str.find(c, found + 1);
+
+		scan = { pos, found };
+		return found;
+	}
+
+	// Move range of the span and its children by the offset, a span without a range keeps none
+	static void moveSourceRange(Span& span, size_t offset)
+	{
+		if (!span.sourceRange.valid())
+			span.sourceRange = SourceRange();
+		else
+		{
+			span.sourceRange.begin += static_cast<uint32_t>(offset);
+			span.sourceRange.end += static_cast<uint32_t>(offset);
+		}
+
+		for (auto& child : span.children)
+			moveSourceRange(*child, offset);
 	}
 
 	Style styleFromTag(const std::pair<std::string, std::string>& tag)
@@ -59,12 +121,33 @@ namespace Markdown
 		};
 
 		std::vector<std::unique_ptr<Span>> spans;
+		std::vector<Candidate> candidates(stylemap.size());
+
+		// Ranges are relative to the source until SourceMap locates them
+		bool tracking = SourceMap::get();
+		ParseStats* stats = ParseStats::get();
+		ParseLimiter* limiter = ParseLimiter::get();
+
+		// Spans are counted once found, the candidates left behind and later clones aren't
+		auto addSpan = [&spans, tracking, stats, limiter](std::unique_ptr<Span> span, size_t begin, size_t end) {
+			if (tracking)
+				span->sourceRange = { static_cast<uint32_t>(begin), static_cast<uint32_t>(end) };
+			if (stats)
+				stats->spans++;
+			if (limiter && span->style)
+				limiter->countSpan();
+			spans.push_back(std::move(span));
+		};
 
 		size_t pos = 0;
 
 		while (pos != std::string::npos)
 		{
-			MarkdownStyle::Result style = findFirst(source, pos, stylemap, autoescape);
+			// Past the limit of spans the rest of the source is plain text
+			if (limiter && limiter->spansExhausted())
+				break;
+
+			MarkdownStyle::Result style = findFirst(source, pos, stylemap, candidates, autoescape);
 			if (!style)
 				break;
 
@@ -73,11 +156,11 @@ namespace Markdown
 
 			// If some characters were skipped fill in the blank with empty style span
 			if (idx != pos)
-				spans.emplace_back(std::make_unique<Span>(source.substr(pos, idx - pos), nullptr));
+				addSpan(std::make_unique<Span>(source.substr(pos, idx - pos), nullptr), pos, idx);
 
 			pos = idx + style.length;
 
-			spans.push_back(std::move(style.span));
+			addSpan(std::move(style.span), idx, pos);
 		}
 
 		if (spans.empty())
@@ -85,12 +168,12 @@ namespace Markdown
 			if (flags & SpanSearchFlags::AddEmpty)
 			{
 				// If no spans were found add an empty style span
-				spans.emplace_back(std::make_unique<Span>(source, nullptr));
+				addSpan(std::make_unique<Span>(source, nullptr), 0, source.size());
 			}
 		}
 		else if (pos != source.size())
 			// Fill in the rest of the source
-			spans.emplace_back(std::make_unique<Span>(source.substr(pos), nullptr));
+			addSpan(std::make_unique<Span>(source.substr(pos), nullptr), pos, source.size());
 
 		return spans;
 	}
@@ -102,67 +185,76 @@ namespace Markdown
 		return this->style.openingTag == b.style.openingTag && this->style.closingTag == b.style.closingTag;
 	}
 
-	MarkdownStyle::Result GenericStyle::findIn(const std::string& str, size_t offset, const StyleContainer& stylemap) const
+	MarkdownStyle::Result GenericStyle::findIn(const std::string& str, size_t offset, const StyleContainer& stylemap, SearchState& state) const
 	{
 		size_t beginSize = this->markdownOpening.size();
 		size_t endSize = this->markdownClosing.size();
 
-		size_t begin = std::string::npos;
-		size_t end = std::string::npos;
-		size_t escapeOffset = 0;
-		do
-		{
-			begin = str.find(this->markdownOpening, offset + escapeOffset);
-			escapeOffset++;
-		} while (isEscaped(str, begin));
+		// Escaped markers are skipped, searching on from the next character
+		size_t begin = str.find(this->markdownOpening, offset);
+		while (begin != std::string::npos && isEscaped(str, begin))
+			begin = str.find(this->markdownOpening, begin + 1);
 
-		escapeOffset = 0;
-		do
-		{
-			end = str.find(this->markdownClosing, begin + beginSize + escapeOffset);
-			escapeOffset++;
-		} while (isEscaped(str, end));
+		if (begin == std::string::npos)
+			return {};
+
+		size_t end = str.find(this->markdownClosing, begin + beginSize);
+		while (end != std::string::npos && isEscaped(str, end))
+			end = str.find(this->markdownClosing, end + 1);
+
+		if (end == std::string::npos)
+			return {};
 
-		if (end != std::string::npos)
+		// Recheck if found tag is not part of a larger tag and try to find better alternative
+		// Rejected candidates lead to the same closing on every search, it's remembered so that the run is walked once
+		std::vector<size_t> rejected;
+		size_t recheck = end;
+		size_t closing = std::string::npos;
+		while (recheck != std::string::npos)
 		{
-			// Recheck if found tag is not part of a larger tag and try to find better alternative
-			bool good = false;
-			size_t recheck = end;
-			while (recheck != std::string::npos && !good )
+			auto known = state.rechecks.find(recheck);
+			if (known != state.rechecks.end())
+			{
+				closing = known->second;
+				break;
+			}
+
+			const MarkdownStyle* found = nullptr;
+			for (const auto& style : stylemap)
 			{
-				for (const auto& style : stylemap)
+				const std::string& opening = style->markdownOpening;
+				if (!opening.empty() && str.compare(recheck, opening.size(), opening) == 0)
 				{
-					size_t foundIdx = str.find(style->markdownOpening, recheck);
-					bool found = foundIdx == recheck;
-					bool escaped = isEscaped(str, foundIdx);
-					good = style->markdownOpening == this->markdownOpening && !escaped;
-					if (found && !good)
-					{
-						recheck = str.find(this->markdownClosing, recheck + style->markdownOpening.size());
-						break;
-					}
-					else if (found)
-					{
-						end = recheck;
-						break;
-					}
+					found = style.get();
+					break;
 				}
 			}
-		}
 
-		size_t textBegin = begin + beginSize;
-		size_t textEnd = end - endSize;
+			if (!found)
+				break;
 
-		if (begin != std::string::npos && end != std::string::npos)
-		{
-			return {
-				begin,
-				end - begin + endSize,
-				std::make_unique<Span>(str.substr(textBegin, textEnd - textBegin + endSize), std::make_shared<GenericStyle>(*this))
-			};
+			if (found->markdownOpening == this->markdownOpening && !isEscaped(str, recheck))
+			{
+				closing = recheck;
+				break;
+			}
+
+			rejected.push_back(recheck);
+			recheck = str.find(this->markdownClosing, recheck + found->markdownOpening.size());
 		}
 
-		return {};
+		for (size_t position : rejected)
+			state.rechecks[position] = closing;
+
+		if (closing != std::string::npos)
+			end = closing;
+
+		size_t textBegin = begin + beginSize;
+		return {
+			begin,
+			end - begin + endSize,
+			std::make_unique<Span>(str.substr(textBegin, end - textBegin), std::make_shared<GenericStyle>(*this))
+		};
 	}
 
 	// Span container
@@ -181,16 +273,45 @@ namespace Markdown
 		if (markdown.empty())
 			return;
 
-		std::vector<std::unique_ptr<Span>> foundSpans = this->findStyle(markdown, {}, searchFlags);
+		bool tracking = SourceMap::get();
+		ParseLimiter::InlineScope depth;
+		std::vector<std::unique_ptr<Span>> foundSpans;
+		if (!(searchFlags & SpanSearchFlags::Literal) && depth.allowed(markdown))
+			foundSpans = this->findStyle(markdown, {}, searchFlags);
+		else if (searchFlags & SpanSearchFlags::AddEmpty)
+		{
+			// Literal text, and styles past the inline depth limit or the deadline, are kept as plain text
+			foundSpans.push_back(std::make_unique<Span>(markdown, nullptr));
+			if (tracking)
+				foundSpans.back()->sourceRange = { 0, static_cast<uint32_t>(markdown.size()) };
+			if (ParseStats* stats = ParseStats::get())
+				stats->spans++;
+		}
+
+		// Children are parsed from the span's text - their ranges are moved to the markdown of the span
+		SpanSearchFlags childFlags = searchFlags & SpanSearchFlags::Literal;
+		auto parseSpan = [tracking, childFlags](Span& span) {
+			std::string text = span.getText();
+			span.parse(text, nullptr, childFlags);
+
+			if (tracking && span.sourceRange.valid())
+			{
+				size_t offset = span.sourceRange.begin + (span.style ? span.style->getTextOffset() : 0);
+				for (auto& child : span.children)
+					moveSourceRange(*child, offset);
+			}
+		};
 
 		auto& spans = this->getSpans();
 		if (defaultStyle)
 		{
 			spans.emplace_back(std::make_unique<Span>("", defaultStyle));
+			if (ParseStats* stats = ParseStats::get())
+				stats->spans++;
 
 			for (auto& span : foundSpans)
 			{
-				span->parse(span->getText(), nullptr, SpanSearchFlags::Normal);
+				parseSpan(*span);
 				spans.back()->children.emplace_back(std::move(span));
 			}
 		}
@@ -198,7 +319,7 @@ namespace Markdown
 		{
 			for (auto& span : foundSpans)
 			{
-				span->parse(span->getText(), nullptr, SpanSearchFlags::Normal);
+				parseSpan(*span);
 				spans.emplace_back(std::move(span));
 			}
 		}
@@ -212,14 +333,10 @@ namespace Markdown
 			auto& grandchild = child->getSpans().front();
 			if (child->style && grandchild->style && *child->style == *grandchild->style)
 			{
-				auto& childSpans = child->getSpans();
-				auto& grandchildSpans = grandchild->getSpans();
-				childSpans.insert(childSpans.end(),
-					std::make_move_iterator(grandchildSpans.begin()),
-					std::make_move_iterator(grandchildSpans.end())
-				);
-				child->text = grandchild->text;
-				childSpans.erase(childSpans.begin());
+				// Grandchild is owned by the spans it's replaced with, keep it alive until its children are moved out
+				std::unique_ptr<Span> removed = std::move(grandchild);
+				child->getSpans() = std::move(removed->getSpans());
+				child->text = removed->text;
 			}
 		}
 	}
@@ -239,31 +356,32 @@ namespace Markdown
 	void Span::parse(const std::string& markdown, const std::shared_ptr<MarkdownStyle> defaultStyle, SpanSearchFlags searchFlags)
 	{
 		SpanContainer::parse(markdown, defaultStyle, searchFlags);
-		this->parseEscapes();
+		if (!(searchFlags & SpanSearchFlags::Literal))
+			this->parseEscapes();
 	}
 
 	void Span::parseEscapes()
 	{
-		size_t idx = 0;
+		size_t pos = this->text.find('\\');
+		if (pos == std::string::npos)
+			return;
 
-		while (true)
+		// Single pass, the backslash is dropped and the escaped character kept - a trailing backslash stays
+		size_t length = pos;
+		for (; pos < this->text.length(); pos++)
 		{
-			size_t pos = this->text.find_first_of('\\', idx);
-
-			if (pos == std::string::npos)
-				break;
-			idx = pos;
-			
-			if (pos != this->text.length() - 1)
-				this->text.erase(pos, 1);
-
-			idx++;
+			if (this->text[pos] == '\\' && pos + 1 < this->text.length())
+				pos++;
+			this->text[length++] = this->text[pos];
 		}
+		this->text.resize(length);
 	}
 
 	std::unique_ptr<Span> Span::clone() const
 	{
-		return std::make_unique<Span>(this->text, this->style, this->children);
+		auto span = std::make_unique<Span>(this->text, this->style, this->children);
+		span->sourceRange = this->sourceRange;
+		return span;
 	}
 
 	std::vector<std::unique_ptr<Span>> Span::findStyle(
@@ -315,23 +433,24 @@ namespace Markdown
 
 	std::string Span::getHtml() const
 	{
+		std::string html;
 		if (this->style)
+			html += this->style->style.openingTag;
+
+		if (this->hasSpans())
 		{
-			std::string text;
-			if (this->hasSpans())
+			for (const auto& span : this->getSpans())
 			{
-				for (const auto& span : this->getSpans())
-				{
-					text += span->getHtml();
-				}
+				html += span->getHtml();
 			}
-			else
-				text = this->text;
-
-			return this->style->style.openingTag + text + this->style->style.closingTag;
 		}
 		else
-			return this->getText();
+			appendEscapedHtml(html, this->text);
+
+		if (this->style)
+			html += this->style->style.closingTag;
+
+		return html;
 	}
 
 	std::string Span::getMarkdown() const
@@ -357,81 +476,160 @@ namespace Markdown
 		return result;
 	}
 
-	// Generic link syntax
+	void Span::walk(ElementHandler& handler) const
+	{
+		// Spans without markdown syntax only carry block's tags, e.g. paragraph
+		if (this->style && !this->style->markdownOpening.empty())
+			this->walk(handler, {});
+		else
+			this->walkContent(handler);
+	}
 
-	template<typename Span, typename Style>
-	MarkdownStyle::Result findLink(const std::string& str, size_t offset, const Style& style)
+	void Span::walk(ElementHandler& handler, const Attributes& attributes) const
 	{
-		// Find text syntax
-		size_t begin = str.find_first_of('[', offset);
+		handler.enterSpan(*this->style, attributes);
+		this->walkContent(handler);
+		handler.exitSpan(*this->style);
+	}
 
-		size_t end = begin;
-		bool found = false;
-		do
+	void Span::walkContent(ElementHandler& handler) const
+	{
+		if (this->hasSpans())
 		{
-			end = str.find_first_of(']', end);
-			if (end == std::string::npos || str[end - 1] == '\\')
-				continue;
-			found = true;
-		} while (end != std::string::npos && !found);
+			for (const auto& span : this->children)
+			{
+				span->walk(handler);
+			}
+		}
+		else if (!this->text.empty())
+			handler.text(this->text);
+	}
 
-		if (end == std::string::npos)
-			return {};
+	void Span::freeze(FrozenWriter& writer) const
+	{
+		writer.beginNode(FrozenNode::Span);
+		this->freezeContent(writer);
+		writer.endNode();
+	}
 
-		if (end + 1 == str.length())
-			return {};
+	void Span::freezeContent(FrozenWriter& writer) const
+	{
+		writer.writeString(this->style ? this->style->style.openingTag : "");
+		writer.writeString(this->style ? this->style->style.closingTag : "");
+		writer.writeString(this->text);
 
-		// Find url syntax
-		size_t beginUrl = end + 1;
-		bool referenceStyle = false;
-		char enclosure = ')';
+		for (const auto& span : this->children)
+		{
+			span->freeze(writer);
+		}
+	}
 
-		// Reference-style?
-		if (str.at(end + 1) != '(')
+	void Span::measure(MemoryUsage& usage, Type owner) const
+	{
+		this->measureSpan(usage, owner, sizeof(Span));
+	}
+
+	void Span::measureSpan(MemoryUsage& usage, Type owner, size_t size) const
+	{
+		usage[owner].spans += size;
+		usage.addString(owner, this->text);
+		usage.addStyle(owner, this->style);
+		usage.addVector(owner, this->children);
+
+		for (const auto& span : this->children)
 		{
-			while (std::isspace(str.at(beginUrl)))
-				beginUrl++;
+			span->measure(usage, owner);
+		}
+	}
 
-			if (str.at(beginUrl) != '[')
-				return {};
+	void Span::shrinkToFit()
+	{
+		this->text.shrink_to_fit();
+		this->children.shrink_to_fit();
 
-			referenceStyle = true;
-			enclosure = ']';
+		for (const auto& span : this->children)
+		{
+			span->shrinkToFit();
 		}
+	}
 
-		// Find actual url syntax
-		size_t endUrl = end + 1;
-		bool foundUrl = false;
-		do
+	// Resolve url and title of the link or image, looking up the reference for reference-style syntax
+	static void resolveUrl(const std::string& source, const ReferenceManager* refman, std::string& url, std::string& title)
+	{
+		if (refman)
 		{
-			endUrl = str.find_first_of(enclosure, endUrl);
-			if (endUrl == std::string::npos)
-				break;
+			RenderCache::dependOn(*refman);
+			if (auto ref = refman->getReference(source))
+			{
+				url = ref->value;
+				title = ref->title;
+			}
+		}
+		else
+			url = source;
+	}
+
+	// Generic link syntax
+
+	// Tries every opening in turn - the openings sharing the closing bracket of a rejected one are skipped,
+	// they would be rejected the same way, so the search is linear in the length of the source
+	template<typename Span, typename Style>
+	MarkdownStyle::Result findLink(const std::string& str, size_t offset, const Style& style, const std::string& opening, MarkdownStyle::SearchState& state)
+	{
+		for (size_t begin = str.find(opening, offset); begin != std::string::npos; )
+		{
+			// Find text syntax
+			size_t textBegin = begin + opening.size() - 1;
+			size_t end = findUnescaped(str, ']', textBegin + 1, state);
+
+			if (end == std::string::npos)
+				return {};
+
+			if (end + 1 == str.length())
+				return {};
+
+			// Find url syntax
+			size_t beginUrl = end + 1;
+			bool referenceStyle = false;
+			char enclosure = ')';
+
+			// Reference-style?
+			if (str.at(end + 1) != '(')
+			{
+				while (beginUrl < str.length() && std::isspace(str.at(beginUrl)))
+					beginUrl++;
 
-			if (str[endUrl - 1] == '\\')
+				referenceStyle = true;
+				enclosure = ']';
+			}
+
+			// Find actual url syntax
+			size_t endUrl = std::string::npos;
+			if (!referenceStyle || (beginUrl < str.length() && str.at(beginUrl) == '['))
+				endUrl = findUnescaped(str, enclosure, end + 1, state);
+
+			if (endUrl == std::string::npos)
 			{
-				endUrl++;
+				begin = str.find(opening, end + 1);
 				continue;
 			}
-			foundUrl = true;
-		} while (endUrl != std::string::npos && !foundUrl);
 
-		if (!foundUrl)
-			return {};
+			// Assemble span
+			std::string text = str.substr(textBegin + 1, end - textBegin - 1);
+			std::string url = str.substr(beginUrl + 1, endUrl - beginUrl - 1);
 
-		// Assemble span
-		std::string text = str.substr(begin + 1, end - begin - 1);
-		std::string url = str.substr(beginUrl + 1, endUrl - beginUrl - 1);
+			url.erase(std::remove(url.begin(), url.end(), '\\'), url.end());
 
-		url.erase(std::remove(url.begin(), url.end(), '\\'), url.end());
-		replace_in(url, "\"", "&quot;");
+			ReferenceManager* manager = referenceStyle ? ReferenceManager::get() : nullptr;
+			std::shared_ptr<const ReferenceManager> refman = manager ? manager->share() : nullptr;
+			return {
+				begin,
+				endUrl - begin + 1,
+				std::make_unique<Span>(text, url, std::make_shared<Style>(style), Markdown::SpanContainer::Container{}, refman)
+			};
+		}
 
-		ReferenceManager* refman = referenceStyle ? ReferenceManager::get() : nullptr;
-		return {
-			begin,
-			endUrl - begin + 1,
-			std::make_unique<Span>(text, url, std::make_shared<Style>(style), Markdown::SpanContainer::Container{}, refman)
-		};
+		return {};
 	}
 
 	// Link style
@@ -441,15 +639,20 @@ namespace Markdown
 		return false;
 	}
 
-	MarkdownStyle::Result LinkStyle::findIn(const std::string& str, size_t offset, const StyleContainer& /*stylemap*/) const
+	MarkdownStyle::Result LinkStyle::findIn(const std::string& str, size_t offset, const StyleContainer& /*stylemap*/, SearchState& state) const
+	{
+		return findLink<LinkSpan, LinkStyle>(str, offset, *this, "[", state);
+	}
+
+	size_t LinkStyle::getTextOffset() const
 	{
-		return findLink<LinkSpan, LinkStyle>(str, offset, *this);
+		return 1;
 	}
 
 	// Link span
 
 	LinkStyle::LinkSpan::LinkSpan(const std::string& text, const std::string& url,
-		std::shared_ptr<MarkdownStyle> style, const std::vector<std::unique_ptr<Span>>& children, ReferenceManager* refman)
+		std::shared_ptr<MarkdownStyle> style, const std::vector<std::unique_ptr<Span>>& children, std::shared_ptr<const ReferenceManager> refman)
 		: Span(text, style, children)
 		, url(url)
 		, refman(refman)
@@ -459,28 +662,61 @@ namespace Markdown
 
 	std::unique_ptr<Span> LinkStyle::LinkSpan::clone() const
 	{
-		return std::make_unique<LinkStyle::LinkSpan>(this->text, this->url, this->style, this->children);
+		auto span = std::make_unique<LinkStyle::LinkSpan>(this->text, this->url, this->style, this->children, this->refman);
+		span->sourceRange = this->sourceRange;
+		return span;
 	}
 
 	std::string LinkStyle::LinkSpan::getHtml() const
 	{
 		std::string url;
 		std::string title;
-		if (this->refman)
-		{
-			if (auto ref = this->refman->getReference(this->url))
-			{
-				url = ref->value;
-				title = ref->title;
-			}
-		}
-		else
-			url = this->url;
+		resolveUrl(this->url, this->refman.get(), url, title);
+
+		if (!HtmlProvider::get().isUrlAllowed(url))
+			url = "#";
 
 		auto tag = HtmlProvider::get().getLink(url, title);
 		return tag.first + Span::getHtml() + tag.second;
 	}
 
+	void LinkStyle::LinkSpan::walk(ElementHandler& handler) const
+	{
+		std::string url;
+		std::string title;
+		resolveUrl(this->url, this->refman.get(), url, title);
+
+		Attributes attributes{ { "href", url } };
+		if (!title.empty())
+			attributes.emplace_back("title", title);
+		if (this->refman)
+			attributes.emplace_back("reference", this->url);
+
+		Span::walk(handler, attributes);
+	}
+
+	void LinkStyle::LinkSpan::freeze(FrozenWriter& writer) const
+	{
+		// Reference is resolved when rendered, using the references of the frozen document
+		writer.beginNode(FrozenNode::LinkSpan);
+		writer.writeString(this->url);
+		writer.writeInteger(this->refman ? 1 : 0);
+		this->freezeContent(writer);
+		writer.endNode();
+	}
+
+	void LinkStyle::LinkSpan::measure(MemoryUsage& usage, Type owner) const
+	{
+		this->measureSpan(usage, owner, sizeof(LinkSpan));
+		usage.addString(owner, this->url);
+	}
+
+	void LinkStyle::LinkSpan::shrinkToFit()
+	{
+		Span::shrinkToFit();
+		this->url.shrink_to_fit();
+	}
+
 	std::string LinkStyle::LinkSpan::getMarkdown() const
 	{
 		std::string result = "[";
@@ -507,32 +743,20 @@ namespace Markdown
 		return false;
 	}
 
-	MarkdownStyle::Result ImageStyle::findIn(const std::string& str, size_t offset, const StyleContainer& /*stylemap*/) const
+	MarkdownStyle::Result ImageStyle::findIn(const std::string& str, size_t offset, const StyleContainer& /*stylemap*/, SearchState& state) const
 	{
-		MarkdownStyle::Result result;
-		size_t begin = std::string::npos;
-		do
-		{
-			begin = str.find_first_of('!', offset);
-			if (begin == std::string::npos)
-				return {};
-
-			result = findLink<ImageSpan, ImageStyle>(str, begin + 1, *this);
-			if (!result)
-				return result;
-
-			result.position -= 1;
-			result.length += 1;
-			offset++;
-		} while (!result);
+		return findLink<ImageSpan, ImageStyle>(str, offset, *this, "![", state);
+	}
 
-		return result;
+	size_t ImageStyle::getTextOffset() const
+	{
+		return 2;
 	}
 
 	// Image span
 
 	ImageStyle::ImageSpan::ImageSpan(const std::string& text, const std::string& url,
-		std::shared_ptr<MarkdownStyle> style, const std::vector<std::unique_ptr<Span>>& children, ReferenceManager* refman)
+		std::shared_ptr<MarkdownStyle> style, const std::vector<std::unique_ptr<Span>>& children, std::shared_ptr<const ReferenceManager> refman)
 		: Span(text, style, children)
 		, url(url)
 		, refman(refman)
@@ -547,28 +771,61 @@ namespace Markdown
 
 	std::unique_ptr<Span> ImageStyle::ImageSpan::clone() const
 	{
-		return std::make_unique<ImageStyle::ImageSpan>(this->text, this->url, this->style, this->children);
+		auto span = std::make_unique<ImageStyle::ImageSpan>(this->text, this->url, this->style, this->children, this->refman);
+		span->sourceRange = this->sourceRange;
+		return span;
 	}
 
 	std::string ImageStyle::ImageSpan::getHtml() const
 	{
 		std::string url;
 		std::string title = "";
-		if (this->refman)
-		{
-			if (auto ref = this->refman->getReference(this->url))
-			{
-				url = ref->value;
-				title = ref->title;
-			}
-		}
-		else
-			url = this->url;
+		resolveUrl(this->url, this->refman.get(), url, title);
+
+		if (!HtmlProvider::get().isUrlAllowed(url))
+			url = "#";
 
 		auto tag = HtmlProvider::get().getImage(this->text, url, title);
 		return tag.first + tag.second;
 	}
 
+	void ImageStyle::ImageSpan::walk(ElementHandler& handler) const
+	{
+		std::string url;
+		std::string title;
+		resolveUrl(this->url, this->refman.get(), url, title);
+
+		Attributes attributes{ { "src", url }, { "alt", this->getText() } };
+		if (!title.empty())
+			attributes.emplace_back("title", title);
+		if (this->refman)
+			attributes.emplace_back("reference", this->url);
+
+		handler.enterSpan(*this->style, attributes);
+		handler.exitSpan(*this->style);
+	}
+
+	void ImageStyle::ImageSpan::freeze(FrozenWriter& writer) const
+	{
+		writer.beginNode(FrozenNode::ImageSpan);
+		writer.writeString(this->url);
+		writer.writeInteger(this->refman ? 1 : 0);
+		this->freezeContent(writer);
+		writer.endNode();
+	}
+
+	void ImageStyle::ImageSpan::measure(MemoryUsage& usage, Type owner) const
+	{
+		this->measureSpan(usage, owner, sizeof(ImageSpan));
+		usage.addString(owner, this->url);
+	}
+
+	void ImageStyle::ImageSpan::shrinkToFit()
+	{
+		Span::shrinkToFit();
+		this->url.shrink_to_fit();
+	}
+
 	std::string ImageStyle::ImageSpan::getMarkdown() const
 	{
 		std::string result = "![";
@@ -590,12 +847,28 @@ namespace Markdown
 
 	// Text entry
 
-	TextEntry::TextEntry(const std::string& content, const std::shared_ptr<MarkdownStyle> defaultStyle)
+	TextEntry::TextEntry(const std::string& content, const std::shared_ptr<MarkdownStyle> defaultStyle, SpanSearchFlags searchFlags)
 	{
-		this->parse(content, defaultStyle);
+		this->parse(content, defaultStyle, searchFlags);
 		this->removeNestedDuplicates();
 	}
 
+	void TextEntry::parse(const std::string& markdown, const std::shared_ptr<MarkdownStyle> defaultStyle, SpanSearchFlags searchFlags)
+	{
+		Tracer::Scope trace("parseInline", Phase::InlineParse, Type::None, markdown.size());
+		if (ParseLimiter* limiter = ParseLimiter::get())
+		{
+			limiter->checkDeadline();
+			limiter->beginEntry();
+		}
+
+		size_t first = this->spans.size();
+		SpanContainer::parse(markdown, defaultStyle, searchFlags);
+
+		if (SourceMap* map = SourceMap::get())
+			map->locate(this->spans.begin() + first, this->spans.end(), markdown.size());
+	}
+
 	TextEntry::TextEntry(const TextEntry& b)
 	{
 		for (const auto& span : b.spans)
@@ -636,8 +909,6 @@ namespace Markdown
 
 	std::string TextEntry::getHtml() const
 	{
-		std::deque<std::pair<size_t, Style>> tags;
-
 		std::string html;
 		for (const auto& span : this->spans)
 		{
@@ -677,6 +948,42 @@ namespace Markdown
 		return markdown;
 	}
 
+	void TextEntry::walk(ElementHandler& handler) const
+	{
+		for (const auto& span : this->spans)
+		{
+			span->walk(handler);
+		}
+	}
+
+	void TextEntry::freeze(FrozenWriter& writer) const
+	{
+		for (const auto& span : this->spans)
+		{
+			span->freeze(writer);
+		}
+	}
+
+	void TextEntry::measure(MemoryUsage& usage, Type owner) const
+	{
+		usage.addVector(owner, this->spans);
+
+		for (const auto& span : this->spans)
+		{
+			span->measure(usage, owner);
+		}
+	}
+
+	void TextEntry::shrinkToFit()
+	{
+		this->spans.shrink_to_fit();
+
+		for (const auto& span : this->spans)
+		{
+			span->shrinkToFit();
+		}
+	}
+
 	bool TextEntry::empty() const
 	{
 		return this->spans.empty();
@@ -0,0 +1,107 @@
+#include "cppmarkdown/tracer.h"
+
+#include <sstream>
+
+namespace Markdown
+{
+    const char* getPhaseName(Phase phase)
+    {
+        switch (phase)
+        {
+        case Phase::LineSplit: return "lineSplit";
+        case Phase::BlockParse: return "blockParse";
+        case Phase::InlineParse: return "inlineParse";
+        case Phase::Finalize: return "finalize";
+        case Phase::Render: return "render";
+        }
+        return "";
+    }
+
+    // Context
+
+    Tracer::ContextGuard::ContextGuard(Tracer& tracer)
+        : ThreadContext<Tracer>::ContextGuard(tracer.isActive() ? Tracer::current : &tracer)
+    {
+        if (Tracer::current != this->previous)
+        {
+            this->added = &tracer;
+            tracer.next = this->previous;
+        }
+    }
+
+    Tracer::ContextGuard::~ContextGuard()
+    {
+        if (this->added)
+            this->added->next = nullptr;
+    }
+
+    bool Tracer::isActive() const
+    {
+        for (const Tracer* tracer = Tracer::current; tracer; tracer = tracer->next)
+        {
+            if (tracer == this)
+                return true;
+        }
+        return false;
+    }
+
+    // Chrome trace sink
+
+    ChromeTraceSink::ChromeTraceSink()
+        : start(std::chrono::steady_clock::now())
+    {
+    }
+
+    void ChromeTraceSink::begin(const TraceEvent& event)
+    {
+        this->record(event, true);
+    }
+
+    void ChromeTraceSink::end(const TraceEvent& event)
+    {
+        this->record(event, false);
+    }
+
+    void ChromeTraceSink::record(const TraceEvent& event, bool begin)
+    {
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start);
+        this->records.push_back({ event, begin, time.count() });
+    }
+
+    size_t ChromeTraceSink::getEventCount() const
+    {
+        return this->records.size();
+    }
+
+    void ChromeTraceSink::clear()
+    {
+        this->records.clear();
+    }
+
+    void ChromeTraceSink::write(std::ostream& out) const
+    {
+        // Duration events, timestamps in microseconds - the type and size reported at the end are merged with the begin
+        out << "{\"traceEvents\":[";
+        for (size_t i = 0; i < this->records.size(); i++)
+        {
+            const Record& record = this->records[i];
+            if (i > 0)
+                out << ",";
+
+            out << "\n{\"name\":\"" << record.event.name << "\",\"cat\":\"" << getPhaseName(record.event.phase)
+                << "\",\"ph\":\"" << (record.begin ? "B" : "E") << "\",\"ts\":" << record.time / 1000 << "."
+                << std::to_string(1000 + record.time % 1000).substr(1) << ",\"pid\":1,\"tid\":1,\"args\":{";
+            if (record.event.type != Type::None)
+                out << "\"type\":\"" << typeToString(record.event.type) << "\",";
+            out << "\"bytes\":" << record.event.bytes << "}}";
+        }
+        out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    std::string ChromeTraceSink::getJson() const
+    {
+        std::ostringstream stream;
+        this->write(stream);
+        return stream.str();
+    }
+}
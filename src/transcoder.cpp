@@ -0,0 +1,139 @@
+#include "cppmarkdown/transcoder.h"
+#include "cppmarkdown/elementhandler.h"
+
+#include <vector>
+
+namespace Markdown
+{
+    Transcoder::Transcoder(Sink sink, ReferencePolicy policy, Type mask, const ParseLimits& limits)
+        : sink(sink)
+        , policy(policy)
+        , stream([this](std::shared_ptr<Element> element) { this->complete(std::move(element)); }, mask, limits)
+    {
+    }
+
+    void Transcoder::feed(std::string_view chunk)
+    {
+        this->start();
+        this->stream.feed(chunk);
+
+        // References defined in this chunk may have resolved deferred blocks
+        this->flushDeferred(false);
+    }
+
+    void Transcoder::finish()
+    {
+        if (this->stream.finished())
+            return;
+
+        this->start();
+        this->stream.finish();
+        this->flushDeferred(true);
+
+        if (this->addDocumentTags)
+            this->sink("</body></html>");
+    }
+
+    Limit Transcoder::getExceededLimits() const
+    {
+        return this->stream.getExceededLimits();
+    }
+
+    void Transcoder::transcode(std::istream& input, Sink sink, ReferencePolicy policy, const ParseLimits& limits)
+    {
+        transcode([&input](char* buffer, size_t size) {
+            input.read(buffer, size);
+            return static_cast<size_t>(input.gcount());
+        }, sink, policy, limits);
+    }
+
+    void Transcoder::transcode(Reader reader, Sink sink, ReferencePolicy policy, const ParseLimits& limits)
+    {
+        Transcoder transcoder(sink, policy, Type::None, limits);
+
+        std::vector<char> buffer(64 * 1024);
+        while (size_t size = reader(buffer.data(), buffer.size()))
+        {
+            transcoder.feed(std::string_view(buffer.data(), size));
+        }
+
+        transcoder.finish();
+    }
+
+    void Transcoder::start()
+    {
+        if (this->started)
+            return;
+
+        this->started = true;
+
+        if (this->addDocumentTags)
+        {
+            std::string tags = "<!DOCTYPE html><html><head>";
+            if (this->addCharset)
+                tags += "<meta charset=\"utf-8\">";
+            tags += "</head><body>";
+            this->sink(tags);
+        }
+    }
+
+    void Transcoder::complete(std::shared_ptr<Element> element)
+    {
+        if (this->policy == ReferencePolicy::Defer && (!this->deferred.empty() || hasUnresolvedReferences(*element)))
+        {
+            // Keep the order of blocks - everything after deferred block waits as well
+            this->deferred.push_back(std::move(element));
+            return;
+        }
+
+        this->write(*element);
+    }
+
+    void Transcoder::write(const Element& element)
+    {
+        std::string html = element.getHtml();
+        if (!html.empty())
+            this->sink(html);
+    }
+
+    void Transcoder::flushDeferred(bool force)
+    {
+        while (!this->deferred.empty())
+        {
+            if (!force && hasUnresolvedReferences(*this->deferred.front()))
+                break;
+
+            this->write(*this->deferred.front());
+            this->deferred.pop_front();
+        }
+    }
+
+    bool Transcoder::hasUnresolvedReferences(const Element& element)
+    {
+        // Reference-style links and images report the reference id, with empty url if it's not defined
+        struct ReferenceFinder : public ElementHandler
+        {
+            bool unresolved = false;
+
+            virtual void enterSpan(const MarkdownStyle& /*style*/, const Attributes& attributes) override
+            {
+                bool reference = false;
+                bool resolved = false;
+                for (const auto& attribute : attributes)
+                {
+                    if (attribute.first == "reference")
+                        reference = true;
+                    else if ((attribute.first == "href" || attribute.first == "src") && !attribute.second.empty())
+                        resolved = true;
+                }
+
+                if (reference && !resolved)
+                    this->unresolved = true;
+            }
+        };
+
+        ReferenceFinder finder;
+        element.walk(finder);
+        return finder.unresolved;
+    }
+}
@@ -0,0 +1,61 @@
+#include "allocationcounter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	thread_local AllocationCounter* current = nullptr;
+}
+
+AllocationCounter::AllocationCounter()
+	: previous(current)
+{
+	current = this;
+}
+
+AllocationCounter::~AllocationCounter()
+{
+	current = this->previous;
+}
+
+size_t AllocationCounter::getCount() const
+{
+	return this->count;
+}
+
+size_t AllocationCounter::getBytes() const
+{
+	return this->bytes;
+}
+
+void AllocationCounter::record(size_t size)
+{
+	for (AllocationCounter* counter = current; counter; counter = counter->previous)
+	{
+		counter->count++;
+		counter->bytes += size;
+	}
+}
+
+// Replaced global allocation functions, the array and nothrow forms call these by default
+
+void* operator new(std::size_t size)
+{
+	AllocationCounter::record(size);
+
+	if (void* pointer = std::malloc(size ? size : 1))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t /*size*/) noexcept
+{
+	std::free(pointer);
+}
@@ -0,0 +1,30 @@
+#ifndef _h_cppmarkdowntestallocationcounter
+#define _h_cppmarkdowntestallocationcounter
+
+#include <cstddef>
+
+// Counts heap allocations of the current thread made through the global operator new while the counter exists
+// The test executable replaces operator new to report to the counters, see allocationcounter.cpp
+// Counters may nest, an allocation is counted by every active counter
+class AllocationCounter
+{
+public:
+	AllocationCounter();
+	~AllocationCounter();
+
+	AllocationCounter(const AllocationCounter&) = delete;
+	AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+	size_t getCount() const;
+	size_t getBytes() const;
+
+	// Called by the replaced operator new
+	static void record(size_t size);
+
+private:
+	size_t count = 0;
+	size_t bytes = 0;
+	AllocationCounter* previous; // Restored when the counter is destroyed
+};
+
+#endif
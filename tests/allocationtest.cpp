@@ -0,0 +1,120 @@
+#include "allocationcounter.h"
+#include "corpus/corpusgenerator.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/extensions.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Debug containers of MSVC allocate on their own, the budgets hold for release containers only
+#if !defined(_ITERATOR_DEBUG_LEVEL) || _ITERATOR_DEBUG_LEVEL == 0
+
+namespace
+{
+	struct Budget
+	{
+		double allocations; // Per byte of the source
+		double bytes; // Allocated bytes per byte of the source
+	};
+
+	struct Corpus
+	{
+		std::string name;
+		std::function<void(Tools::CorpusGenerator::Settings&)> configure;
+		Budget parse;
+		Budget render;
+	};
+
+	// Budgets are about a third above the allocations measured when they were set
+	// Lower them along with changes reducing the allocations, so that they don't come back unnoticed
+	const std::vector<Corpus> corpora = {
+		{ "mixed", [](Tools::CorpusGenerator::Settings&) {}, { 2.3, 450 }, { 0.17, 22 } },
+		{ "markers", [](Tools::CorpusGenerator::Settings& settings) { settings.markerDensity = 0.5; }, { 3.4, 680 }, { 0.26, 37 } },
+		{ "lists", [](Tools::CorpusGenerator::Settings& settings) { settings.listDepth = 6; }, { 2.0, 375 }, { 0.17, 37 } },
+		{ "blockquotes", [](Tools::CorpusGenerator::Settings& settings) { settings.blockquoteDepth = 4; }, { 2.2, 420 }, { 0.17, 23 } },
+		{ "tables", [](Tools::CorpusGenerator::Settings& settings) { settings.tableRows = 40; }, { 2.8, 540 }, { 0.18, 23 } }
+	};
+
+	std::string generate(const Corpus& corpus)
+	{
+		Tools::CorpusGenerator::Settings settings;
+		corpus.configure(settings);
+		return Tools::CorpusGenerator::generate(settings);
+	}
+
+	// Allocations of the call, assertions allocate too and are kept out of the counter
+	struct Allocations
+	{
+		size_t count;
+		size_t bytes;
+	};
+
+	Allocations countAllocations(const std::function<void()>& call)
+	{
+		AllocationCounter counter;
+		call();
+		return { counter.getCount(), counter.getBytes() };
+	}
+
+	void checkBudget(const Allocations& counted, const Budget& budget, size_t size)
+	{
+		double allocations = static_cast<double>(counted.count) / size;
+		double bytes = static_cast<double>(counted.bytes) / size;
+
+		INFO(allocations << " allocations and " << bytes << " bytes per byte");
+		CHECK(allocations <= budget.allocations);
+		CHECK(bytes <= budget.bytes);
+	}
+}
+
+TEST_CASE("Allocation counter", "[allocation]")
+{
+	Allocations inner;
+	Allocations outer = countAllocations([&inner]() {
+		inner = countAllocations([]() {
+			std::vector<int> vector(100);
+		});
+		std::vector<char> buffer(32);
+	});
+
+	REQUIRE(inner.count == 1);
+	REQUIRE(inner.bytes == 100 * sizeof(int));
+	REQUIRE(outer.count == 2);
+	REQUIRE(outer.bytes == 100 * sizeof(int) + 32);
+}
+
+TEST_CASE("Allocation budget of parsing", "[allocation]")
+{
+	Markdown::registerStandardExtensions();
+
+	for (const Corpus& corpus : corpora)
+	{
+		std::string source = generate(corpus);
+		Markdown::Document document;
+		Allocations counted = countAllocations([&]() { document.parse(source); });
+
+		INFO(corpus.name);
+		checkBudget(counted, corpus.parse, source.size());
+	}
+}
+
+TEST_CASE("Allocation budget of rendering", "[allocation]")
+{
+	Markdown::registerStandardExtensions();
+
+	for (const Corpus& corpus : corpora)
+	{
+		std::string source = generate(corpus);
+		Markdown::Document document;
+		document.parse(source);
+		Allocations counted = countAllocations([&document]() { document.getHtml(); });
+
+		INFO(corpus.name);
+		checkBudget(counted, corpus.render, source.size());
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+#include "cppmarkdown/blockcache.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/html.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <thread>
+#include <atomic>
+#include <vector>
+
+namespace
+{
+	// Provider configured without changing its type
+	class ClassedProvider : public Markdown::DefaultHtmlProvider
+	{
+	public:
+		static std::string paragraphClass;
+
+		virtual std::pair<std::string, std::string> getParagraph() const override
+		{
+			return { "<p class=\"" + paragraphClass + "\">", "</p>" };
+		}
+	};
+
+	std::string ClassedProvider::paragraphClass = "first";
+}
+
+TEST_CASE("Block cache lookup", "[blockcache]")
+{
+	Markdown::BlockCache cache(1024, 1);
+
+	REQUIRE_FALSE(cache.find("# Title", 1));
+	cache.insert("# Title", 1, "<h1>Title</h1>");
+
+	REQUIRE(cache.find("# Title", 1) == "<h1>Title</h1>");
+	REQUIRE_FALSE(cache.find("# Title", 2));
+
+	cache.invalidate("# Title", 1);
+	REQUIRE_FALSE(cache.find("# Title", 1));
+
+	Markdown::BlockCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.hits == 1);
+	REQUIRE(statistics.misses == 3);
+	REQUIRE(statistics.entries == 0);
+	REQUIRE(statistics.size == 0);
+}
+
+TEST_CASE("Block cache eviction", "[blockcache]")
+{
+	// Every entry takes 10 bytes
+	Markdown::BlockCache cache(30, 1);
+	cache.insert("aaaaa", 0, "AAAAA");
+	cache.insert("bbbbb", 0, "BBBBB");
+	cache.insert("ccccc", 0, "CCCCC");
+
+	// Use the oldest one, so the second one is evicted
+	REQUIRE(cache.find("aaaaa", 0));
+	cache.insert("ddddd", 0, "DDDDD");
+
+	REQUIRE(cache.find("aaaaa", 0));
+	REQUIRE_FALSE(cache.find("bbbbb", 0));
+	REQUIRE(cache.find("ccccc", 0));
+	REQUIRE(cache.find("ddddd", 0));
+
+	Markdown::BlockCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.evictions == 1);
+	REQUIRE(statistics.entries == 3);
+	REQUIRE(statistics.size == 30);
+
+	// Larger than the whole cache
+	cache.insert("eeeee", 0, std::string(100, 'E'));
+	REQUIRE_FALSE(cache.find("eeeee", 0));
+
+	cache.setCapacity(10);
+	REQUIRE(cache.getStatistics().entries == 1);
+
+	cache.clear();
+	REQUIRE(cache.getStatistics().entries == 0);
+}
+
+TEST_CASE("Documents sharing block cache", "[blockcache]")
+{
+	Markdown::BlockCache cache;
+	const std::string footer = "> **Warning:** generated page\n> do not edit";
+
+	auto render = [&](const std::string& markdown) {
+		Markdown::Document doc;
+		doc.keepSource = true;
+		doc.blockCache = &cache;
+		doc.parse(markdown);
+		return doc.getHtml();
+	};
+
+	auto renderUncached = [](const std::string& markdown) {
+		Markdown::Document doc;
+		doc.parse(markdown);
+		return doc.getHtml();
+	};
+
+	std::string first = "# First\n\nSome text\n\n" + footer;
+	std::string second = "# Second\n\n" + footer;
+
+	REQUIRE(render(first) == renderUncached(first));
+	REQUIRE(cache.getStatistics().hits == 0);
+
+	REQUIRE(render(second) == renderUncached(second));
+	REQUIRE(cache.getStatistics().hits == 1);
+
+	// References are part of the block's context
+	std::string withReference = "[link][ref]\n\n[ref]: http://a.com";
+	std::string withOtherReference = "[link][ref]\n\n[ref]: http://b.com";
+	REQUIRE(render(withReference) == renderUncached(withReference));
+	REQUIRE(render(withOtherReference) == renderUncached(withOtherReference));
+
+	// So is the HTML provider
+	std::string table = "A|B\n-|-\n1|2\n\n" + footer;
+	{
+		Markdown::SubstituteHtmlProvider<Markdown::PrettyTableProvider> provider;
+		size_t misses = cache.getStatistics().misses;
+		render(table);
+		REQUIRE(cache.getStatistics().misses == misses + 2);
+	}
+}
+
+TEST_CASE("Block cache context of configured providers", "[blockcache]")
+{
+	Markdown::BlockCache cache;
+	Markdown::SubstituteHtmlProvider<ClassedProvider> provider;
+
+	auto render = [&]() {
+		Markdown::Document doc;
+		doc.keepSource = true;
+		doc.blockCache = &cache;
+		doc.parse("Paragraph");
+		return doc.getHtml().find("<p class=\"" + ClassedProvider::paragraphClass + "\">") != std::string::npos;
+	};
+
+	REQUIRE(render());
+	ClassedProvider::paragraphClass = "second";
+	REQUIRE(render());
+	REQUIRE(cache.getStatistics().hits == 0);
+
+	REQUIRE(render());
+	REQUIRE(cache.getStatistics().hits == 1);
+}
+
+TEST_CASE("Block cache used from several threads", "[blockcache]")
+{
+	Markdown::BlockCache cache(4096, 4);
+
+	// Assertions are not thread safe, mismatches are counted instead
+	std::atomic<int> mismatches = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&cache, &mismatches, t]() {
+			for (int i = 0; i < 1000; i++)
+			{
+				std::string source = "block " + std::to_string((i * 7 + t) % 64);
+				if (std::optional<std::string> html = cache.find(source, 0))
+					mismatches += *html != "<p>" + source + "</p>";
+				else
+					cache.insert(source, 0, "<p>" + source + "</p>");
+			}
+		});
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	REQUIRE(mismatches == 0);
+
+	Markdown::BlockCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.hits + statistics.misses == 4000);
+	REQUIRE(statistics.size <= 4096);
+}
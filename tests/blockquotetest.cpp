@@ -108,4 +108,47 @@ And regular paragraph)md";
 	REQUIRE(doc.getHtml() ==
 		"<!DOCTYPE html><html><head></head><body><blockquote><p>Im a blockquote!</p></blockquote><p>And regular paragraph</p></body></html>"
 	);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Nested blockquote with spaced markers", "[blockquote]")
+{
+	std::string markdown = R"md(> Level 1
+> > Level 2
+> > > Level 3
+> Back to level 1)md";
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	REQUIRE(doc.elementsCount() == 1);
+	REQUIRE((*doc.begin())->getHtml() ==
+		"<blockquote>"
+		"<p>Level 1</p>"
+		"<blockquote><p>Level 2</p>"
+		"<blockquote><p>Level 3</p></blockquote>"
+		"</blockquote>"
+		"<p>Back to level 1</p>"
+		"</blockquote>"
+	);
+}
+
+TEST_CASE("Deeply nested blockquote", "[blockquote]")
+{
+	const int depth = 200;
+
+	std::string markdown;
+	for (int i = 1; i <= depth; i++)
+		markdown += std::string(i, '>') + " Level " + std::to_string(i) + "\n";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	REQUIRE(doc.elementsCount() == 1);
+
+	std::string expected;
+	for (int i = 1; i <= depth; i++)
+		expected += "<blockquote><p>Level " + std::to_string(i) + "</p>";
+	for (int i = 1; i <= depth; i++)
+		expected += "</blockquote>";
+
+	REQUIRE((*doc.begin())->getHtml() == expected);
+}
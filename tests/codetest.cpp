@@ -123,4 +123,96 @@ TEST_CASE("Code block with tabs", "[code]")
 	REQUIRE((*it)->getType() == Markdown::Type::Code);
 	REQUIRE((*it)->getText() == "A code");
 	REQUIRE((*it)->getHtml() == "<pre><code>A code</code></pre>");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Fenced code block", "[code]")
+{
+	std::string markdown = R"md(Some paragraph
+```cpp
+int main()
+{
+
+    return 0;
+}
+```
+And another paragraph)md";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	INFO(doc.dump());
+
+	REQUIRE(doc.elementsCount() == 3);
+
+	auto it = doc.begin();
+
+	REQUIRE((*it)->getType() == Markdown::Type::Paragraph);
+	it++;
+
+	REQUIRE((*it)->getType() == Markdown::Type::Code);
+	auto code = std::static_pointer_cast<Markdown::CodeElement>(*it);
+	REQUIRE(code->isFenced());
+	REQUIRE(code->language == "cpp");
+	REQUIRE(code->getText() == "int main()\n{\n\n    return 0;\n}");
+	REQUIRE(code->getHtml() == "<pre><code>int main()\n{\n\n    return 0;\n}</code></pre>");
+	REQUIRE(code->getMarkdown() == "```cpp\nint main()\n{\n\n    return 0;\n}\n```");
+	it++;
+
+	REQUIRE((*it)->getType() == Markdown::Type::Paragraph);
+}
+
+TEST_CASE("Fenced code block with tildes", "[code]")
+{
+	std::string markdown = R"md(~~~~
+```
+not closed by backticks
+~~~
+~~~~~
+After)md";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	INFO(doc.dump());
+
+	REQUIRE(doc.elementsCount() == 2);
+
+	auto it = doc.begin();
+	REQUIRE((*it)->getType() == Markdown::Type::Code);
+	REQUIRE((*it)->getText() == "```\nnot closed by backticks\n~~~");
+	it++;
+
+	REQUIRE((*it)->getType() == Markdown::Type::Paragraph);
+}
+
+TEST_CASE("Unclosed fenced code block", "[code]")
+{
+	std::string markdown = "```\n# Not a heading\n\n> Not a quote";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	INFO(doc.dump());
+
+	REQUIRE(doc.elementsCount() == 1);
+	REQUIRE(doc.front()->getType() == Markdown::Type::Code);
+	REQUIRE(doc.front()->getText() == "# Not a heading\n\n> Not a quote");
+}
+
+TEST_CASE("Code block markdown", "[code]")
+{
+	std::string markdown = "Text\n\n    first\n\tsecond";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	REQUIRE(doc.elementsCount() == 2);
+	REQUIRE(doc.back()->getMarkdown() == "    first\n    second");
+}
+
+TEST_CASE("Code block HTML escaping", "[code]")
+{
+	Markdown::CodeElement el("if (a < b && c > d)\n    std::cout << \"<tag>\";");
+
+	REQUIRE(el.getHtml() == "<pre><code>if (a &lt; b &amp;&amp; c &gt; d)\n    std::cout &lt;&lt; \"&lt;tag&gt;\";</code></pre>");
+}
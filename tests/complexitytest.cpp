@@ -0,0 +1,90 @@
+#include "parsecost.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/extensions.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Pattern
+	{
+		std::string name;
+		std::function<std::string(size_t)> make; // Source of at least given size
+	};
+
+	std::string repeat(const std::string& text, size_t size)
+	{
+		std::string result;
+		while (result.size() < size)
+			result += text;
+		return result;
+	}
+
+	// Input doubled twice keeps the cost per byte of linear parsing, a quadratic path would quadruple it
+	void requireLinear(const std::vector<Pattern>& patterns)
+	{
+		for (const Pattern& pattern : patterns)
+		{
+			ParseCost small = ParseCost::measure(pattern.make(16 * 1024));
+			ParseCost large = ParseCost::measure(pattern.make(64 * 1024));
+
+			INFO(pattern.name << ": " << small.allocations << " / " << large.allocations << " allocations, "
+				<< small.allocatedBytes << " / " << large.allocatedBytes << " allocated bytes, "
+				<< small.parses << " / " << large.parses << " parses per byte at 16 / 64 KiB");
+			CHECK(large.allocations < small.allocations * 1.5 + 0.01);
+			CHECK(large.allocatedBytes < small.allocatedBytes * 1.5 + 1);
+			CHECK(large.parses < small.parses * 1.5 + 0.01);
+		}
+	}
+}
+
+TEST_CASE("Linear emphasis", "[complexity]")
+{
+	requireLinear({
+		{ "strong openings", [](size_t size) { return repeat("**a", size); } },
+		{ "emphasis closings inside strong", [](size_t size) { return "*" + repeat("a**", size); } },
+		{ "emphasis and strong", [](size_t size) { return repeat("*a**", size); } },
+		{ "emphasis inside code", [](size_t size) { return repeat("`*` ", size); } },
+		{ "every marker", [](size_t size) { return repeat("*_`[!", size); } },
+		{ "unclosed markers", [](size_t size) { return repeat("*", size / 2) + repeat("_", size / 2); } }
+	});
+}
+
+TEST_CASE("Linear links and images", "[complexity]")
+{
+	requireLinear({
+		{ "openings", [](size_t size) { return repeat("[", size) + "]"; } },
+		{ "image openings", [](size_t size) { return repeat("![", size) + "]"; } },
+		{ "exclamation marks", [](size_t size) { return repeat("!", size) + "[a](b)"; } },
+		{ "unclosed urls", [](size_t size) { return repeat("[a](", size); } },
+		{ "unclosed urls between references", [](size_t size) { return repeat("[a]( [x][y] ", size); } },
+		{ "texts without urls", [](size_t size) { return repeat("[a] b ", size); } }
+	});
+}
+
+TEST_CASE("Linear escapes", "[complexity]")
+{
+	requireLinear({
+		{ "escaped marker at the end", [](size_t size) { return repeat("a ", size) + "\\*"; } },
+		{ "escaped markers", [](size_t size) { return repeat("\\*", size); } },
+		{ "backslashes", [](size_t size) { return repeat("\\", size) + "*a*"; } }
+	});
+}
+
+TEST_CASE("Linear blocks", "[complexity]")
+{
+	Markdown::registerStandardExtensions();
+
+	requireLinear({
+		{ "paragraph lines", [](size_t size) { return repeat("word word word\n", size); } },
+		{ "line breaks", [](size_t size) { return repeat("a  \n", size); } },
+		{ "blockquote lines", [](size_t size) { return repeat("> > > a\n", size); } },
+		{ "list items", [](size_t size) { return repeat("* a\n    * b\n", size); } },
+		{ "table rows", [](size_t size) { return "a|b\n-|-\n" + repeat("c|d\n", size); } },
+		{ "code lines", [](size_t size) { return "```\n" + repeat("*a*\n", size); } }
+	});
+}
@@ -0,0 +1,126 @@
+#include "corpus/corpusgenerator.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/extensions.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <set>
+
+namespace
+{
+	class TypeCollector : public Markdown::ElementHandler
+	{
+	public:
+		std::set<Markdown::Type> types;
+		size_t depth = 0;
+		size_t maxBlockquoteDepth = 0;
+
+		virtual void enterBlock(Markdown::Type type, const Markdown::Attributes&) override
+		{
+			this->types.insert(type);
+			if (type == Markdown::Type::Blockquote)
+				this->maxBlockquoteDepth = std::max(this->maxBlockquoteDepth, ++this->depth);
+		}
+
+		virtual void exitBlock(Markdown::Type type) override
+		{
+			if (type == Markdown::Type::Blockquote)
+				this->depth--;
+		}
+	};
+
+	TypeCollector collectTypes(const std::string& markdown)
+	{
+		Markdown::Document doc;
+		doc.parse(markdown);
+
+		TypeCollector collector;
+		for (const auto& element : doc)
+			element->walk(collector);
+		return collector;
+	}
+}
+
+TEST_CASE("Corpus generator is deterministic", "[corpusgenerator]")
+{
+	Tools::CorpusGenerator::Settings settings;
+	settings.size = 16 * 1024;
+
+	std::string markdown = Tools::CorpusGenerator::generate(settings);
+	REQUIRE(markdown.size() >= settings.size);
+	REQUIRE(Tools::CorpusGenerator::generate(settings) == markdown);
+
+	settings.seed = 2;
+	REQUIRE(Tools::CorpusGenerator::generate(settings) != markdown);
+}
+
+TEST_CASE("Corpus generator gives the same corpus with every standard library", "[corpusgenerator]")
+{
+	// The values are reduced from the raw output of std::mt19937, whose sequence is fixed by the standard
+	Tools::CorpusGenerator::Settings settings;
+	settings.size = 160;
+	settings.paragraphLength = 12;
+	settings.referenceCount = 2;
+
+	REQUIRE(Tools::CorpusGenerator::generate(settings) ==
+		"elit|tempor|nisi incididunt|adipiscing adipiscing\n"
+		"----|-----|---|---\n"
+		"incididunt consectetur|aliquip dolor ullamco|**dolor** ipsum dolor|nisi consectetur do\n"
+		"[exercitation][ref0] aliqua veniam|quis dolor|dolor sed et\\\\|adipiscing sed ipsum\n"
+		"amet elit|dolore|labore ipsum ipsum|![quis](https://example.com/dolore/904) amet\n"
+		"nostrud dolore laboris|veniam sit|enim eiusmod|ullamco ``ullamco ` ullamco``\n"
+		"dolor nisi|magna tempor|quis lorem amet|lorem eiusmod\n"
+		"![aliqua][ref0] nostrud aliquip|amet consectetur|adipiscing|``adipiscing ` adipiscing`` *sit* sit\n"
+		"\n"
+		"[ref0]: https://example.com/aliquip/418\n"
+		"[ref1]: https://example.com/lorem/933 \"do\"");
+}
+
+TEST_CASE("Corpus generator covers every element", "[corpusgenerator]")
+{
+	Markdown::registerStandardExtensions();
+
+	Tools::CorpusGenerator::Settings settings;
+	settings.size = 32 * 1024;
+	settings.blockquoteDepth = 3;
+
+	TypeCollector collector = collectTypes(Tools::CorpusGenerator::generate(settings));
+	for (Markdown::Type type : {
+		Markdown::Type::Paragraph, Markdown::Type::Heading, Markdown::Type::Blockquote, Markdown::Type::List,
+		Markdown::Type::ListItem, Markdown::Type::Code, Markdown::Type::Line, Markdown::Type::Reference,
+		Markdown::Type::LineBreak, Markdown::Type::Table, Markdown::Type::TableCell })
+	{
+		INFO(Markdown::typeToString(type));
+		REQUIRE(collector.types.count(type) == 1);
+	}
+	REQUIRE(collector.maxBlockquoteDepth == 3);
+}
+
+TEST_CASE("Corpus generator knobs", "[corpusgenerator]")
+{
+	Tools::CorpusGenerator::Settings settings;
+	settings.size = 16 * 1024;
+	REQUIRE(settings.set("listDepth", "0"));
+	REQUIRE(settings.set("blockquoteDepth", "0"));
+	REQUIRE(settings.set("tableRows", "0"));
+	REQUIRE(settings.set("referenceCount", "0"));
+	REQUIRE_FALSE(settings.set("unknown", "1"));
+
+	TypeCollector collector = collectTypes(Tools::CorpusGenerator::generate(settings));
+	REQUIRE(collector.types.count(Markdown::Type::List) == 0);
+	REQUIRE(collector.types.count(Markdown::Type::Blockquote) == 0);
+	REQUIRE(collector.types.count(Markdown::Type::Table) == 0);
+	REQUIRE(collector.types.count(Markdown::Type::Reference) == 0);
+
+	// Sweeping the size gives documents of growing size
+	size_t previous = 0;
+	for (size_t size = 1024; size <= 64 * 1024; size *= 2)
+	{
+		settings.size = size;
+		std::string markdown = Tools::CorpusGenerator::generate(settings);
+		REQUIRE(markdown.size() >= size);
+		REQUIRE(markdown.size() > previous);
+		previous = markdown.size();
+	}
+}
@@ -1,10 +1,34 @@
 #include "cppmarkdown/document.h"
 #include "cppmarkdown/headingelement.h"
 #include "cppmarkdown/paragraphelement.h"
+#include "cppmarkdown/blockquoteelement.h"
+#include "cppmarkdown/listelement.h"
+#include "cppmarkdown/html.h"
 
 #include <catch2/catch_all.hpp>
 
 #include <functional>
+#include <random>
+
+namespace
+{
+	// Element counting how many times it was rendered
+	class CountingElement : public Markdown::Element
+	{
+	public:
+		std::string html = "<x></x>";
+		mutable int renders = 0;
+
+		virtual Markdown::Type getType() const override { return Markdown::Type::Extension; }
+		virtual Markdown::ParseResult parse(const std::string&, std::shared_ptr<Markdown::Element>) override { return Markdown::ParseResult(); }
+
+		virtual std::string getHtml() const override
+		{
+			this->renders++;
+			return this->html;
+		}
+	};
+}
 
 TEST_CASE("Single paragraph", "[document]")
 {
@@ -129,4 +153,292 @@ TEST_CASE("Document construction", "[document]")
 		"<p>And this is paragraph</p>"
 		"</body></html>"
 	);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Document finalize merges paragraph runs", "[document]")
+{
+	std::string markdown = R"md(line 1
+line 2
+line 3
+
+line 4
+
+
+line 5)md";
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	REQUIRE(doc.getHtml() ==
+		"<!DOCTYPE html><html><head></head><body>"
+		"<p>line 1 line 2 line 3</p>"
+		"<p>line 4</p>"
+		"<br>"
+		"<p>line 5</p>"
+		"</body></html>"
+	);
+}
+
+TEST_CASE("Document built from chunks", "[document]")
+{
+	std::string markdown = R"md(First paragraph
+which is multiline
+
+> Quote
+> > Nested quote
+
+* Item 1
+* Item 2
+    * Subitem [link][ref]
+
+```cpp
+int main() {}
+```
+
+[ref]: http://example.com "Title"
+Last paragraph)md";
+
+	Markdown::Document expected;
+	expected.parse(markdown);
+
+	for (size_t chunkSize : { 1, 2, 3, 7, 16, 64 })
+	{
+		Markdown::Document doc;
+		Markdown::Document::Builder builder(doc);
+		for (size_t pos = 0; pos < markdown.size(); pos += chunkSize)
+		{
+			builder.feed(std::string_view(markdown).substr(pos, chunkSize));
+		}
+		builder.finish();
+
+		INFO("Chunk size " << chunkSize);
+		REQUIRE(doc.elementsCount() == expected.elementsCount());
+		REQUIRE(doc.getHtml() == expected.getHtml());
+	}
+}
+
+TEST_CASE("Document edits", "[document]")
+{
+	std::string markdown = R"md(# Title
+First paragraph
+with two lines
+
+Second paragraph
+
+* Item 1
+* Item 2
+    * Subitem
+
+> Quote
+> > Nested
+
+    code block
+    continued
+
+Last paragraph)md";
+
+	Markdown::Document doc;
+	doc.keepSource = true;
+	doc.parse(markdown);
+
+	Markdown::Document expected;
+	expected.parse(markdown);
+	REQUIRE(doc.getHtml() == expected.getHtml());
+
+	auto title = doc.front();
+	auto last = doc.back();
+
+	// Edit inside the second paragraph only
+	size_t pos = markdown.find("Second");
+	doc.applyEdit(pos, 6, "Edited");
+	markdown.replace(pos, 6, "Edited");
+
+	REQUIRE(doc.getSource() == markdown);
+	expected.clear();
+	expected.parse(markdown);
+	REQUIRE(doc.getHtml() == expected.getHtml());
+	REQUIRE(doc.front() == title);
+	REQUIRE(doc.back() == last);
+
+	// Open a fenced block swallowing the rest of the document
+	doc.applyEdit(0, 0, "```\n");
+	markdown.insert(0, "```\n");
+
+	expected.clear();
+	expected.parse(markdown);
+	REQUIRE(doc.elementsCount() == 1);
+	REQUIRE(doc.getHtml() == expected.getHtml());
+
+	// And close it again
+	doc.applyEdit(0, 4, "");
+	markdown.erase(0, 4);
+
+	expected.clear();
+	expected.parse(markdown);
+	REQUIRE(doc.getHtml() == expected.getHtml());
+
+	Markdown::Document notRetained;
+	notRetained.parse(markdown);
+	REQUIRE_THROWS_AS(notRetained.applyEdit(0, 0, "x"), std::logic_error);
+}
+
+TEST_CASE("Document random edits", "[document]")
+{
+	const std::vector<std::string> fragments = {
+		"\n", "\n\n", "text ", "# ", "* ", "1. ", "> ", "    ", "```", "~~~", "---\n", "===\n", "*em*", "[link](url)",
+		"[ref]: http://example.com\n", "[link][ref]", "a|b\n-|-\n1|2\n", "  \n"
+	};
+
+	std::mt19937 random(1337);
+	auto randomIndex = [&random](size_t size) { return static_cast<size_t>(random() % size); };
+
+	std::string markdown;
+	for (int i = 0; i < 60; i++)
+	{
+		markdown += fragments.at(randomIndex(fragments.size()));
+	}
+
+	Markdown::Document doc;
+	doc.keepSource = true;
+	doc.parse(markdown);
+
+	for (int i = 0; i < 300; i++)
+	{
+		size_t offset = randomIndex(markdown.size() + 1);
+		size_t removed = std::min<size_t>(randomIndex(8), markdown.size() - offset);
+		std::string inserted = random() % 3 ? fragments.at(randomIndex(fragments.size())) : "";
+
+		doc.applyEdit(offset, removed, inserted);
+		markdown.replace(offset, removed, inserted);
+
+		Markdown::Document expected;
+		expected.parse(markdown);
+
+		INFO("Edit " << i << ": " << markdown);
+		REQUIRE(doc.getSource() == markdown);
+		REQUIRE(doc.elementsCount() == expected.elementsCount());
+		REQUIRE(doc.getHtml() == expected.getHtml());
+	}
+}
+
+TEST_CASE("Document parsed again", "[document]")
+{
+	for (bool keepSource : { false, true })
+	{
+		Markdown::Document doc;
+		doc.keepSource = keepSource;
+		doc.parse("[ref]: http://example.com\n\nFirst");
+		doc.parse("Second [link][ref]");
+
+		// Content and references of the first parse are replaced
+		REQUIRE(doc.elementsCount() == 1);
+		REQUIRE(doc.getHtml().find("example.com") == std::string::npos);
+	}
+}
+
+TEST_CASE("Document with incomplete syntax", "[document]")
+{
+	for (const char* markdown : { "# ", "> ", "  \n\n ", "[] ", "[a]:", "[a]: u", "[a]: u \"" })
+	{
+		Markdown::Document doc;
+		REQUIRE_NOTHROW(doc.parse(markdown));
+	}
+
+	Markdown::Document doc;
+	doc.parse("\n\n     ");
+	REQUIRE(doc.getHtml().find("<hr>") == std::string::npos);
+}
+
+TEST_CASE("Document render cache", "[document]")
+{
+	Markdown::Document doc;
+	doc.parse("* Item\n\n> Quote");
+
+	auto item = std::static_pointer_cast<Markdown::ListItem>(std::static_pointer_cast<Markdown::ListElement>(doc.front())->at(0));
+	auto quote = std::static_pointer_cast<Markdown::BlockquoteElement>(doc.back());
+	REQUIRE(quote->getType() == Markdown::Type::Blockquote);
+
+	auto counting = std::make_shared<CountingElement>();
+	item->addElement(counting);
+
+	std::string html = doc.getHtml();
+	REQUIRE(counting->renders == 1);
+	REQUIRE(doc.getHtml() == html);
+	REQUIRE(counting->renders == 1);
+
+	// Changed top-level elements are rendered again, reusing the output of unchanged ones
+	item->addElement(std::make_shared<Markdown::ParagraphElement>("Added"));
+	html = doc.getHtml();
+	REQUIRE(html.find("<p>Added</p></li>") != std::string::npos);
+	REQUIRE(counting->renders == 2);
+
+	quote->elements.addElement(std::make_shared<Markdown::ParagraphElement>("Quoted"));
+	html = doc.getHtml();
+	REQUIRE(html.find("<p>Quoted</p></blockquote>") != std::string::npos);
+	REQUIRE(counting->renders == 2);
+
+	quote->elements.eraseElement(quote->elements.end() - 1);
+	html = doc.getHtml();
+	REQUIRE(html.find("Quoted") == std::string::npos);
+
+	// Direct changes require invalidation
+	counting->html = "<y></y>";
+	REQUIRE(doc.getHtml() == html);
+	counting->invalidate();
+	REQUIRE(doc.getHtml().find("<li>Item<y></y>") != std::string::npos);
+	REQUIRE(counting->renders == 3);
+
+	{
+		Markdown::SubstituteHtmlProvider<Markdown::PrettyTableProvider> provider;
+		doc.getHtml();
+		REQUIRE(counting->renders == 4);
+	}
+
+	doc.getHtml();
+	REQUIRE(counting->renders == 5);
+}
+
+TEST_CASE("Document render cache with references", "[document]")
+{
+	Markdown::Document doc;
+	Markdown::Document::Builder builder(doc);
+	builder.feed("See [the site][site]\n\n");
+
+	auto counting = std::make_shared<CountingElement>();
+	doc.addElement(counting);
+	REQUIRE(doc.getHtml().find("<a href=\"\">the site</a>") != std::string::npos);
+	REQUIRE(counting->renders == 1);
+
+	// References of another document don't discard the output
+	Markdown::Document other;
+	other.parse("[site]: http://example.org");
+	doc.getHtml();
+	REQUIRE(counting->renders == 1);
+
+	// The link resolves the reference defined after it was rendered
+	builder.feed("[site]: http://example.com\n");
+	builder.finish();
+	REQUIRE(doc.getHtml().find("<a href=\"http://example.com\">the site</a>") != std::string::npos);
+	REQUIRE(counting->renders == 1);
+}
+
+TEST_CASE("Document with 100k blocks", "[.][benchmark][document]")
+{
+	const int blocks = 100000;
+
+	std::string markdown;
+	for (int i = 0; i < blocks; i++)
+		markdown += (i > 0 ? "\n\nParagraph " : "Paragraph ") + std::to_string(i) + "\ncontinued";
+
+	{
+		Markdown::Document doc;
+		doc.parse(markdown);
+		REQUIRE(doc.elementsCount() == blocks);
+	}
+
+	BENCHMARK("Parse 100k blocks")
+	{
+		Markdown::Document doc;
+		doc.parse(markdown);
+		return doc.elementsCount();
+	};
+}
@@ -0,0 +1,207 @@
+#include "cppmarkdown/elementstream.h"
+#include "cppmarkdown/elementhandler.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/textentry.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	// Records events as a compact string
+	class RecordingHandler : public Markdown::ElementHandler
+	{
+	public:
+		std::string events;
+
+		virtual void enterBlock(Markdown::Type type, const Markdown::Attributes& attributes) override
+		{
+			this->events += "<" + Markdown::typeToString(type) + format(attributes) + ">";
+		}
+
+		virtual void exitBlock(Markdown::Type type) override
+		{
+			this->events += "</" + Markdown::typeToString(type) + ">";
+		}
+
+		virtual void text(std::string_view text) override
+		{
+			this->events += text;
+		}
+
+		virtual void enterSpan(const Markdown::MarkdownStyle& style, const Markdown::Attributes& attributes) override
+		{
+			this->events += "{" + style.markdownOpening + format(attributes);
+		}
+
+		virtual void exitSpan(const Markdown::MarkdownStyle& style) override
+		{
+			this->events += style.markdownClosing + "}";
+		}
+
+	private:
+		static std::string format(const Markdown::Attributes& attributes)
+		{
+			std::string result;
+			for (const auto& attribute : attributes)
+			{
+				result += " " + attribute.first + "=" + attribute.second;
+			}
+			return result;
+		}
+	};
+
+	const std::string sampleMarkdown = R"md(# Title
+First paragraph
+with *emphasis*
+
+> Quote
+
+1. Item
+2. Item [link](http://example.com)
+
+```cpp
+code
+```
+---
+Last paragraph)md";
+}
+
+TEST_CASE("Event parsing", "[elementstream]")
+{
+	RecordingHandler handler;
+	Markdown::EventParser::parse(sampleMarkdown, handler);
+
+	REQUIRE(handler.events ==
+		"<Heading level=1>Title</Heading>"
+		"<Paragraph>First paragraph with {*emphasis*}</Paragraph>"
+		"<LineBreak></LineBreak>"
+		"<Blockquote><Paragraph>Quote</Paragraph></Blockquote>"
+		"<LineBreak></LineBreak>"
+		"<List type=ordered>"
+		"<ListItem><Blank>Item</Blank></ListItem>"
+		"<ListItem><Blank>Item { href=http://example.comlink}</Blank></ListItem>"
+		"</List>"
+		"<LineBreak></LineBreak>"
+		"<Code language=cpp>code</Code>"
+		"<Line></Line>"
+		"<Paragraph>Last paragraph</Paragraph>"
+	);
+}
+
+TEST_CASE("Element stream matches document", "[elementstream]")
+{
+	Markdown::Document doc;
+	doc.parse(sampleMarkdown);
+
+	for (size_t chunkSize : { 1, 5, 1000 })
+	{
+		std::vector<std::shared_ptr<Markdown::Element>> elements;
+		Markdown::ElementStream stream([&elements](std::shared_ptr<Markdown::Element> element) {
+			elements.push_back(element);
+		});
+
+		for (size_t pos = 0; pos < sampleMarkdown.size(); pos += chunkSize)
+		{
+			stream.feed(std::string_view(sampleMarkdown).substr(pos, chunkSize));
+		}
+		stream.finish();
+
+		INFO("Chunk size " << chunkSize);
+		REQUIRE(elements.size() == doc.elementsCount());
+		for (size_t i = 0; i < elements.size(); i++)
+		{
+			REQUIRE(elements.at(i)->getType() == doc.at(i)->getType());
+			REQUIRE(elements.at(i)->getHtml() == doc.at(i)->getHtml());
+		}
+	}
+}
+
+TEST_CASE("Element stream releases completed elements", "[elementstream]")
+{
+	std::weak_ptr<Markdown::Element> first;
+	size_t count = 0;
+
+	Markdown::ElementStream stream([&](std::shared_ptr<Markdown::Element> element) {
+		if (count++ == 0)
+			first = element;
+	});
+
+	stream.feed("# Heading\n\nParagraph\n\n");
+	for (int i = 0; i < 100; i++)
+	{
+		stream.feed("Paragraph\n\n");
+	}
+
+	REQUIRE(count > 0);
+	REQUIRE(first.expired());
+
+	stream.finish();
+	REQUIRE(stream.finished());
+}
+
+TEST_CASE("Event parsing from stream", "[elementstream]")
+{
+	std::istringstream input("Text with [reference link][ref]\n\n[ref]: http://example.com \"Title\"");
+
+	RecordingHandler handler;
+	Markdown::EventParser::parse(input, handler);
+
+	REQUIRE(handler.events ==
+		"<Paragraph>Text with { href=http://example.com title=Title reference=refreference link}</Paragraph>"
+		"<LineBreak></LineBreak>"
+		"<Reference id=ref url=http://example.com title=Title></Reference>"
+	);
+}
+
+TEST_CASE("Lazy element range", "[elementstream]")
+{
+	Markdown::Document doc;
+	doc.parse(sampleMarkdown);
+
+	size_t i = 0;
+	for (const auto& element : Markdown::Document::lazyElements(sampleMarkdown))
+	{
+		REQUIRE(i < doc.elementsCount());
+		REQUIRE(element->getHtml() == doc.at(i)->getHtml());
+		i++;
+	}
+	REQUIRE(i == doc.elementsCount());
+}
+
+TEST_CASE("Lazy element range stops early", "[elementstream]")
+{
+	std::string markdown = "# Heading\n\nIntro paragraph\n\n";
+	for (int i = 0; i < 10000; i++)
+	{
+		markdown += "Paragraph " + std::to_string(i) + "\n\n";
+	}
+
+	auto range = Markdown::Document::lazyElements(markdown);
+	auto it = range.begin();
+
+	REQUIRE(it != range.end());
+	REQUIRE((*it)->getType() == Markdown::Type::Heading);
+	REQUIRE(range.position() < 64);
+
+	++it;
+	REQUIRE((*it)->getType() == Markdown::Type::Paragraph);
+	REQUIRE((*it)->getText() == "Intro paragraph");
+	REQUIRE(range.position() < 64);
+}
+
+TEST_CASE("Lazy elements outlive the range", "[elementstream]")
+{
+	std::vector<std::shared_ptr<Markdown::Element>> elements;
+	{
+		std::string markdown = "See [the site][site]\n\n[site]: http://example.com \"Site\"";
+		for (const auto& element : Markdown::Document::lazyElements(markdown))
+			elements.push_back(element);
+	}
+
+	// References are shared with the links, they are resolved after the range and the source are gone
+	REQUIRE(!elements.empty());
+	REQUIRE(elements.front()->getHtml() == "<p>See <a href=\"http://example.com\" title=\"Site\">the site</a></p>");
+}
@@ -86,6 +86,32 @@ TEST_CASE("Table parsing to text", "[table]")
     );
 }
 
+TEST_CASE("Table from text without table", "[table]")
+{
+    Markdown::TableElement table("Something\n\nA|B\n-|-\n1|2\n");
+
+    REQUIRE(table.columnCount() == 0);
+    REQUIRE(table.getText() == "");
+}
+
+TEST_CASE("Table rows after the end of table", "[table]")
+{
+    std::string tableMarkdown =
+        "A|B\n"
+        "-|-\n"
+        "1|2\n"
+        "Paragraph\n"
+        "3|4\n";
+    Markdown::TableElement table(tableMarkdown);
+
+    REQUIRE(table.rowCount() == 1);
+    REQUIRE(table.getText() ==
+        "A | B \n"
+        "--|---\n"
+        "1 | 2 "
+    );
+}
+
 TEST_CASE("Table with styled element", "[table]")
 {
     std::string tableMarkdown =
@@ -135,6 +161,15 @@ TEST_CASE("Table parsing in document", "[table]")
     );
 }
 
+TEST_CASE("Table rows added after rendering", "[table]")
+{
+    Markdown::TableElement table("A|B\n-|-\n1|2");
+    REQUIRE(table.getCachedHtml() == "<table><tr><th>A</th><th>B</th></tr><tr><td>1</td><td>2</td></tr></table>");
+
+    table.addRow({ Markdown::TextEntry("a"), Markdown::TextEntry("b") });
+    REQUIRE(table.getCachedHtml() == "<table><tr><th>A</th><th>B</th></tr><tr><td>1</td><td>2</td></tr><tr><td>a</td><td>b</td></tr></table>");
+}
+
 TEST_CASE("Table parsing in complex document", "[table]")
 {
     Markdown::registerStandardExtensions();
@@ -202,6 +237,33 @@ TEST_CASE("Incomplete table", "[table]")
     );
 }
 
+TEST_CASE("Table wider than the column limit", "[table]")
+{
+    Markdown::registerStandardExtensions();
+
+    Markdown::Document doc;
+    doc.limits.maxTableColumns = 2;
+    doc.parse("A|B|C\n-|-|-\n1|2|3");
+
+    REQUIRE(doc.getHtml().find("<table>") == std::string::npos);
+    REQUIRE(doc.getExceededLimits() == Markdown::Limit::TableColumns);
+
+    Markdown::Document narrow;
+    narrow.limits.maxTableColumns = 2;
+    narrow.parse("A|B\n-|-\n1|2");
+    REQUIRE(narrow.getHtml().find("<table>") != std::string::npos);
+    REQUIRE(narrow.getExceededLimits() == Markdown::Limit::None);
+}
+
+TEST_CASE("Standard extensions registered once", "[table]")
+{
+    Markdown::registerStandardExtensions();
+    size_t count = Markdown::ExtensionsManager::getInstance().getExtensionCount();
+    Markdown::registerStandardExtensions();
+
+    REQUIRE(Markdown::ExtensionsManager::getInstance().getExtensionCount() == count);
+}
+
 TEST_CASE("Document without table", "[table]")
 {
     Markdown::registerStandardExtensions();
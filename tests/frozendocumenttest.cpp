@@ -0,0 +1,175 @@
+#include "cppmarkdown/frozendocument.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/extensions.h"
+#include "cppmarkdown/html.h"
+
+#include <catch2/catch_all.hpp>
+
+namespace
+{
+	// Element unknown to the frozen format
+	class CustomElement : public Markdown::Element
+	{
+	public:
+		virtual Markdown::Type getType() const override { return Markdown::Type::Extension; }
+		virtual Markdown::ParseResult parse(const std::string&, std::shared_ptr<Markdown::Element>) override { return Markdown::ParseResult(); }
+
+		virtual std::string getText() const override { return "custom"; }
+		virtual std::string getHtml() const override { return "<custom></custom>"; }
+	};
+
+	const std::string markdown = R"md(# Title with *emphasis*
+
+Paragraph with **strong *nested* text**, `code` and <escaped> & characters
+continued with [a link](http://example.com) and [a reference][ref]
+
+![Image][ref]
+
+> Quote
+> > Nested quote
+
+* Item 1
+* Item 2
+    * Subitem
+        1. Deep
+* Item 3
+
+1. First
+2. Second
+
+---
+
+    code block
+    with <tags>
+
+A    |B
+-----|--
+1    |*2*
+long cell|b
+
+[ref]: http://example.com/ref "Reference title")md";
+}
+
+TEST_CASE("Frozen document rendering", "[frozendocument]")
+{
+	Markdown::registerStandardExtensions();
+
+	Markdown::Document doc;
+	doc.addCharset = true;
+	doc.parse(markdown);
+
+	std::string buffer = doc.freeze();
+	Markdown::FrozenDocument frozen(buffer);
+
+	REQUIRE(frozen.elementsCount() == doc.elementsCount());
+	REQUIRE(frozen.getHtml() == doc.getHtml());
+	REQUIRE(frozen.getText() == doc.getText());
+
+	// Offsets are relative, the buffer may be moved
+	std::string copy = buffer;
+	buffer.clear();
+	REQUIRE(Markdown::FrozenDocument(copy).getHtml() == doc.getHtml());
+}
+
+// Frozen documents are rendered by their own renderer, which has to match every element
+TEST_CASE("Frozen document rendering of each element", "[frozendocument]")
+{
+	Markdown::registerStandardExtensions();
+
+	const std::string sources[] = {
+		"Paragraph\ncontinued",
+		"Line  \nbreak",
+		"# Heading 1\n## Heading 2\n### Heading 3\n#### Heading 4\n##### Heading 5\n###### Heading 6",
+		"Setext heading\n===\n\nOther heading\n---",
+		"*emphasis* _emphasis_ **strong** __strong__ `code` ***both*** **strong *nested* text**",
+		"Escaped \\*text\\* with <tags> & \"quotes\"",
+		"[link](http://example.com) [titled](http://example.com \"Title\") [blocked](javascript:alert(1))",
+		"![image](image.png) ![titled](image.png \"Title\") ![*styled* alt](image.png)",
+		"[reference][ref] [missing][none] ![image][ref]\n\n[ref]: http://example.com \"Title\"",
+		"> Quote\n> > Nested quote\n>\n> # Heading",
+		"* Item\n* *Styled* item\n    * Subitem\n        1. Deep",
+		"1. First\n2. Second\n    - Nested\n3. Third",
+		"* Item\n\n* Loose item\n\n    Paragraph",
+		"- - Sublist first",
+		"---\n\n***",
+		"    code block\n    with <tags>\n\n```\nfenced\n```",
+		"A|B\n-|-\n1|*2*\nlong cell|",
+		"A|B|C\n:-|:-:|-:\n[x](http://a.com)|`y`|z"
+	};
+
+	auto compare = [&sources]() {
+		for (const std::string& source : sources)
+		{
+			Markdown::Document doc;
+			doc.parse(source);
+			const std::string buffer = doc.freeze();
+			Markdown::FrozenDocument frozen(buffer);
+
+			INFO(source);
+			REQUIRE(frozen.getHtml() == doc.getHtml());
+			REQUIRE(frozen.getText() == doc.getText());
+		}
+	};
+
+	compare();
+
+	Markdown::SubstituteHtmlProvider<Markdown::PrettyTableProvider> provider;
+	compare();
+}
+
+TEST_CASE("Frozen document depth limit", "[frozendocument]")
+{
+	std::string source;
+	for (size_t i = 0; i < 50; i++)
+		source += "> ";
+	source += "Deep quote";
+
+	Markdown::Document doc;
+	doc.parse(source);
+	const std::string buffer = doc.freeze();
+
+	Markdown::FrozenOptions options;
+	REQUIRE(Markdown::FrozenDocument(buffer, options).getHtml() == doc.getHtml());
+
+	options.maxDepth = 20;
+	Markdown::FrozenDocument limited(buffer, options);
+	REQUIRE_THROWS_AS(limited.getHtml(), Markdown::FrozenFormatException);
+	REQUIRE_THROWS_AS(limited.getText(), Markdown::FrozenFormatException);
+}
+
+TEST_CASE("Frozen document with unknown element", "[frozendocument]")
+{
+	Markdown::Document doc;
+	doc.parse("Paragraph");
+	doc.addElement(std::make_shared<CustomElement>());
+
+	const std::string buffer = doc.freeze();
+	Markdown::FrozenDocument frozen(buffer);
+	REQUIRE(frozen.getHtml() == doc.getHtml());
+	REQUIRE(frozen.getText() == "Paragraph\ncustom");
+}
+
+TEST_CASE("Frozen document validation", "[frozendocument]")
+{
+	Markdown::Document doc;
+	doc.parse("# Title\n\nParagraph");
+	const std::string buffer = doc.freeze();
+
+	REQUIRE_NOTHROW(Markdown::FrozenDocument(buffer));
+	REQUIRE_THROWS_AS(Markdown::FrozenDocument(std::string_view("")), Markdown::FrozenFormatException);
+	REQUIRE_THROWS_AS(Markdown::FrozenDocument(std::string_view("# Title\n\nParagraph")), Markdown::FrozenFormatException);
+	REQUIRE_THROWS_AS(Markdown::FrozenDocument(std::string_view(buffer).substr(0, buffer.size() - 1)), Markdown::FrozenFormatException);
+
+	// Checksum of the whole buffer is compared only on request
+	std::string corrupted = buffer;
+	corrupted.back() ^= 1;
+	REQUIRE_NOTHROW(Markdown::FrozenDocument(corrupted));
+	Markdown::FrozenOptions options;
+	options.verifyChecksum = true;
+	REQUIRE_NOTHROW(Markdown::FrozenDocument(buffer, options));
+	REQUIRE_THROWS_AS(Markdown::FrozenDocument(corrupted, options), Markdown::FrozenFormatException);
+
+	std::string version = buffer;
+	version[4] = static_cast<char>(Markdown::FrozenDocument::version + 1);
+	REQUIRE_THROWS_AS(Markdown::FrozenDocument(version), Markdown::FrozenFormatException);
+}
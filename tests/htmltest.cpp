@@ -48,4 +48,40 @@ TEST_CASE("Pretty table", "[table]")
             "</table>"
         );
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("HTML escaping", "[html]")
+{
+    REQUIRE(Markdown::escapeHtml("") == "");
+    REQUIRE(Markdown::escapeHtml("Nothing to escape") == "Nothing to escape");
+    REQUIRE(Markdown::escapeHtml("<b>\"Tom\" & 'Jerry'</b>") == "&lt;b&gt;\"Tom\" &amp; 'Jerry'&lt;/b&gt;");
+    REQUIRE(Markdown::escapeHtml("<b>\"Tom\" & 'Jerry'</b>", Markdown::EscapeMode::Attribute) == "&lt;b&gt;&quot;Tom&quot; &amp; &#39;Jerry&#39;&lt;/b&gt;");
+
+    // Special characters at every position of long clean runs
+    std::string clean(40, 'x');
+    for (size_t i = 0; i < clean.size(); i++)
+    {
+        std::string source = clean;
+        source[i] = '<';
+        std::string expected = clean.substr(0, i) + "&lt;" + clean.substr(i + 1);
+        REQUIRE(Markdown::escapeHtml(source) == expected);
+    }
+
+    REQUIRE(Markdown::Tag("a").addattribute("title", "\"><script>").get() == "<a title=\"&quot;&gt;&lt;script&gt;\">");
+}
+
+TEST_CASE("URL schemes", "[html]")
+{
+    REQUIRE(Markdown::HtmlProvider::getUrlScheme("https://example.com") == "https");
+    REQUIRE(Markdown::HtmlProvider::getUrlScheme("JavaScript:alert(1)") == "javascript");
+    REQUIRE(Markdown::HtmlProvider::getUrlScheme(" java\tscript:alert(1)") == "javascript");
+    REQUIRE(Markdown::HtmlProvider::getUrlScheme("relative/path:with/colon") == "");
+    REQUIRE(Markdown::HtmlProvider::getUrlScheme("#anchor") == "");
+
+    auto& provider = Markdown::HtmlProvider::get();
+    REQUIRE(provider.isUrlAllowed("http://example.com"));
+    REQUIRE(provider.isUrlAllowed("mailto:someone@example.com"));
+    REQUIRE(provider.isUrlAllowed("images/image.png"));
+    REQUIRE_FALSE(provider.isUrlAllowed("javascript:alert(1)"));
+    REQUIRE_FALSE(provider.isUrlAllowed("data:text/html;base64,PHNjcmlwdD4="));
+}
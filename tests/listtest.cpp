@@ -57,6 +57,8 @@ TEST_CASE("List level parsing", "[list]")
 	// Invalid
 	REQUIRE(!ListElement::getListLevel("This is some text - with hyphen"));
 	REQUIRE(!ListElement::getListLevel("And same text with * asterisk"));
+	REQUIRE(!ListElement::getListLevel(". Dot without number"));
+	REQUIRE(!ListElement::getListLevel("    ... dots"));
 }
 
 TEST_CASE("List find ordered marker", "[list]")
@@ -300,6 +302,20 @@ TEST_CASE("List with elements with dots", "[list]")
 	);
 }
 
+TEST_CASE("List item starting with dots", "[list]")
+{
+	Markdown::Document doc;
+	doc.parse("3. . . Third");
+
+	REQUIRE(doc.getHtml() ==
+		"<!DOCTYPE html><html><head></head><body>"
+		"<ol>"
+		"<li>. . Third</li>"
+		"</ol>"
+		"</body></html>"
+	);
+}
+
 TEST_CASE("List with styles", "[list]")
 {
 	std::string markdown = R"md(- First
@@ -317,4 +333,64 @@ TEST_CASE("List with styles", "[list]")
 		"</ul>"
 		"</body></html>"
 	);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Three level nested list", "[list]")
+{
+	Markdown::ListElement el(R"list(- First
+    - Nested 1
+        - Nested 2
+    - Back in nested 1
+- Second)list");
+	INFO(el.dump());
+
+	REQUIRE(el.size() == 2);
+	REQUIRE(el.getHtml() == "<ul>"
+		"<li>First<ul>"
+		"<li>Nested 1<ul>"
+		"<li>Nested 2</li>"
+		"</ul></li>"
+		"<li>Back in nested 1</li>"
+		"</ul></li>"
+		"<li>Second</li>"
+		"</ul>");
+}
+
+TEST_CASE("List paragraph with styles", "[list]")
+{
+	Markdown::ListElement el(R"list(- First
+    Paragraph with **bold**)list");
+
+	REQUIRE(el.getHtml() == "<ul><li>First<br>Paragraph with <strong>bold</strong></li></ul>");
+}
+
+TEST_CASE("Deeply nested list", "[list]")
+{
+	const int depth = 1000;
+
+	std::string markdown;
+	for (int i = 0; i < depth; i++)
+		markdown += std::string(i, '\t') + "- Item " + std::to_string(i) + "\n";
+
+	Markdown::ListElement el(markdown);
+
+	REQUIRE(el.size() == 1);
+
+	const Markdown::ListElement* list = &el;
+	int level = 1;
+	while (true)
+	{
+		auto item = list->getLastItem();
+		auto sublist = item->getLastItem();
+		if (!sublist || sublist->getType() != Markdown::Type::List)
+			break;
+
+		list = static_cast<const Markdown::ListElement*>(sublist.get());
+		level++;
+	}
+
+	const Markdown::Element& deepest = *list->getLastItem();
+
+	REQUIRE(level == depth);
+	REQUIRE(deepest.getText() == "Item " + std::to_string(depth - 1));
+}
@@ -0,0 +1,121 @@
+#include "cppmarkdown/memoryusage.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/textentry.h"
+#include "cppmarkdown/extensions.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <string>
+
+namespace
+{
+	const std::string source =
+		"# Heading with a title long enough to be allocated\n"
+		"\n"
+		"Paragraph with *emphasis*, **strong** text and a [link](http://example.com/some/long/path)\n"
+		"continued on the second line of the paragraph.\n"
+		"\n"
+		"> Quote with a text long enough to be allocated\n"
+		"\n"
+		"- Item with a text long enough to be allocated\n"
+		"    - Nested item with a text long enough to be allocated\n"
+		"\n"
+		"| Column | Other column |\n"
+		"| --- | --- |\n"
+		"| Cell with a text long enough | Cell |\n"
+		"\n"
+		"[ref]: http://example.com/reference/with/long/path \"Title of the reference\"\n";
+}
+
+TEST_CASE("Memory usage of a document", "[memoryusage]")
+{
+	Markdown::registerStandardExtensions();
+
+	Markdown::Document doc;
+	doc.parse(source);
+	Markdown::MemoryUsage usage = doc.memoryUsage();
+
+	REQUIRE(usage.get(Markdown::Type::None).elements >= sizeof(Markdown::Document));
+	REQUIRE(usage.get(Markdown::Type::None).vectors > 0);
+	REQUIRE(usage.get(Markdown::Type::None).references > 0);
+
+	for (auto type : { Markdown::Type::Heading, Markdown::Type::Paragraph, Markdown::Type::Blockquote, Markdown::Type::List, Markdown::Type::ListItem, Markdown::Type::Extension, Markdown::Type::Reference })
+	{
+		INFO(Markdown::typeToString(type));
+		REQUIRE(usage.get(type).elements > 0);
+		REQUIRE(usage.get(type).strings >= usage.get(type).stringsUsed);
+		REQUIRE(usage.get(type).vectors >= usage.get(type).vectorsUsed);
+	}
+
+	REQUIRE(usage.get(Markdown::Type::Paragraph).spans > 0);
+	REQUIRE(usage.get(Markdown::Type::Paragraph).strings > 0);
+	REQUIRE(usage.get(Markdown::Type::Paragraph).styles > 0);
+	REQUIRE(usage.get(Markdown::Type::Extension).spans > 0);
+	REQUIRE(usage.get(Markdown::Type::Image).total() == 0);
+
+	Markdown::MemoryUsage::Breakdown total = usage.getTotal();
+	REQUIRE(usage.total() == total.total());
+	REQUIRE(total.elements + total.spans + total.strings + total.vectors + total.styles + total.references == usage.total());
+
+	// Rendered output is held by the caches of the elements
+	doc.getHtml();
+	REQUIRE(doc.memoryUsage().getTotal().strings > total.strings);
+}
+
+TEST_CASE("Memory usage grows with the document", "[memoryusage]")
+{
+	Markdown::Document small;
+	small.parse("Paragraph with *emphasis*");
+
+	Markdown::Document large;
+	large.parse(source + source + source);
+
+	REQUIRE(large.memoryUsage().total() > small.memoryUsage().total());
+}
+
+TEST_CASE("Shrink document to fit", "[memoryusage]")
+{
+	Markdown::registerStandardExtensions();
+
+	Markdown::Document doc;
+	doc.keepSource = true;
+	doc.parse(source);
+	std::string html = doc.getHtml();
+
+	Markdown::MemoryUsage before = doc.memoryUsage();
+	doc.shrinkToFit();
+	Markdown::MemoryUsage after = doc.memoryUsage();
+
+	REQUIRE(after.total() <= before.total());
+	REQUIRE(after.getTotal().strings <= before.getTotal().strings);
+	REQUIRE(after.getTotal().vectors <= before.getTotal().vectors);
+	REQUIRE(after.getTotal().stringsUsed == before.getTotal().stringsUsed);
+	REQUIRE(after.getTotal().vectorsUsed == before.getTotal().vectorsUsed);
+
+	REQUIRE(doc.getHtml() == html);
+	REQUIRE(doc.getSource() == source);
+}
+
+TEST_CASE("Memory usage of strings and styles", "[memoryusage]")
+{
+	Markdown::MemoryUsage usage;
+
+	// Short strings are stored in the object
+	usage.addString(Markdown::Type::Paragraph, "short");
+	REQUIRE(usage.get(Markdown::Type::Paragraph).strings == 0);
+
+	std::string text(100, 'a');
+	usage.addString(Markdown::Type::Paragraph, text);
+	REQUIRE(usage.get(Markdown::Type::Paragraph).strings == text.capacity() + 1);
+	REQUIRE(usage.get(Markdown::Type::Paragraph).stringsUsed == text.size() + 1);
+
+	// Shared style is counted once
+	auto style = Markdown::MarkdownStyle::makeHtml("<strong>", "</strong>");
+	usage.addStyle(Markdown::Type::Paragraph, style);
+	size_t styles = usage.get(Markdown::Type::Paragraph).styles;
+	REQUIRE(styles >= sizeof(Markdown::MarkdownStyle));
+
+	usage.addStyle(Markdown::Type::Heading, style);
+	REQUIRE(usage.get(Markdown::Type::Paragraph).styles == styles);
+	REQUIRE(usage.get(Markdown::Type::Heading).styles == 0);
+}
@@ -86,6 +86,22 @@ Third line non-styled)md";
 	REQUIRE(std::static_pointer_cast<Markdown::ParagraphElement>(*it)->getHtml() == "<p>First non-styled line Second <strong>styled line</strong> Third line non-styled</p>");
 }
 
+TEST_CASE("Multiline paragraphs with escapes and references", "[paragraph]")
+{
+	std::string markdown = R"md(Not \*emphasized
+line\* with [a link][ref]
+
+[ref]: http://example.com)md";
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	INFO(doc.getHtml());
+
+	auto it = doc.begin();
+	REQUIRE((*it)->getHtml() == "<p>Not *emphasized line* with <a href=\"http://example.com\">a link</a></p>");
+}
+
 TEST_CASE("Blank lines", "[paragraph]")
 {
 	std::string markdown = R"md(Some paragraph
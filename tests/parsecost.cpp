@@ -0,0 +1,24 @@
+#include "parsecost.h"
+#include "allocationcounter.h"
+#include "cppmarkdown/document.h"
+
+#include <numeric>
+
+ParseCost ParseCost::measure(const std::string& source, const Markdown::ParseLimits& limits)
+{
+	Markdown::Document document;
+	document.limits = limits;
+	Markdown::ParseStats stats;
+	AllocationCounter counter;
+	document.parse(source, stats);
+	document.getHtml();
+
+	size_t attempts = std::accumulate(stats.attempts.begin(), stats.attempts.end(), size_t(0));
+	double size = static_cast<double>(source.size());
+
+	ParseCost cost;
+	cost.allocations = counter.getCount() / size;
+	cost.allocatedBytes = counter.getBytes() / size;
+	cost.parses = (attempts + stats.retries + stats.spans) / size;
+	return cost;
+}
@@ -0,0 +1,18 @@
+#ifndef _h_cppmarkdowntestparsecost
+#define _h_cppmarkdowntestparsecost
+
+#include "cppmarkdown/parselimits.h"
+
+#include <string>
+
+// Work of parsing and rendering a source per byte, counted instead of timed so that it doesn't depend on the machine
+struct ParseCost
+{
+	double allocations = 0.0; // Heap allocations, see AllocationCounter
+	double allocatedBytes = 0.0;
+	double parses = 0.0; // Block parser attempts, retried lines and spans, see ParseStats
+
+	static ParseCost measure(const std::string& source, const Markdown::ParseLimits& limits = Markdown::ParseLimits());
+};
+
+#endif
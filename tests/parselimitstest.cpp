@@ -0,0 +1,308 @@
+#include "parsecost.h"
+#include "cppmarkdown/parselimits.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/elementstream.h"
+#include "cppmarkdown/extensions.h"
+#include "cppmarkdown/transcoder.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+	std::string repeat(const std::string& str, size_t count)
+	{
+		std::string result;
+		for (size_t i = 0; i < count; i++)
+			result += str;
+		return result;
+	}
+
+	bool contains(const std::string& str, const std::string& part)
+	{
+		return str.find(part) != std::string::npos;
+	}
+}
+
+TEST_CASE("Parse limits are unlimited by default", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.parse("> > Quote\n\n- Item\n    - Nested *item*\n");
+
+	REQUIRE(doc.limits.unlimited());
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::None);
+	REQUIRE(Markdown::ParseLimiter::get() == nullptr);
+}
+
+TEST_CASE("Input bytes limit", "[parselimits]")
+{
+	const std::string source = "Line one\nLine two\nLine three";
+
+	Markdown::Document doc;
+	doc.limits.maxInputBytes = 12;
+	doc.parse(source);
+
+	// Line cut by the limit is dropped whole
+	REQUIRE(doc.getText() == "Line one");
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::InputBytes);
+
+	Markdown::Document retained;
+	retained.keepSource = true;
+	retained.limits.maxInputBytes = 12;
+	retained.parse(source);
+
+	REQUIRE(retained.getSource() == "Line one\n");
+	REQUIRE(retained.getExceededLimits() == Markdown::Limit::InputBytes);
+
+	// Limit applies to the whole content fed to the builder
+	Markdown::Document fed;
+	fed.limits.maxInputBytes = 12;
+	Markdown::Document::Builder builder(fed);
+	builder.feed("Line ");
+	builder.feed("one\nLine two\n");
+	builder.feed("Line three");
+	builder.finish();
+
+	REQUIRE(fed.getText() == "Line one");
+	REQUIRE(fed.getExceededLimits() == Markdown::Limit::InputBytes);
+}
+
+TEST_CASE("Block depth limit", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.maxBlockDepth = 3;
+	Markdown::ParseStats stats;
+
+	SECTION("Blockquotes")
+	{
+		doc.parse("> > > > Deep quote", stats);
+
+		REQUIRE(stats.peakDepth == 3);
+		REQUIRE(stats.getElements(Markdown::Type::Blockquote) == 2);
+		REQUIRE(contains(doc.getText(), "> > Deep quote"));
+	}
+
+	SECTION("Lists")
+	{
+		doc.parse("- - - Deep item", stats);
+
+		REQUIRE(stats.peakDepth == 3);
+		REQUIRE(stats.getElements(Markdown::Type::List) == 1);
+		REQUIRE(contains(doc.getText(), "- - Deep item"));
+	}
+
+	SECTION("Indented sublists")
+	{
+		doc.parse("- Item\n    - Nested item\n        - Deeper item", stats);
+
+		REQUIRE(stats.peakDepth == 3);
+		REQUIRE(stats.getElements(Markdown::Type::List) == 1);
+		REQUIRE(stats.getElements(Markdown::Type::ListItem) == 1);
+		REQUIRE(contains(doc.getText(), "Nested item"));
+	}
+
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::BlockDepth);
+}
+
+TEST_CASE("Lists past the block depth limit are kept as written", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.maxBlockDepth = 1;
+	doc.parse("* a\n* b\n\nText *emphasis*");
+
+	std::string html = doc.getHtml();
+	REQUIRE(contains(html, "<p>* a * b</p>"));
+	REQUIRE(contains(html, "<p>Text <em>emphasis</em></p>"));
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::BlockDepth);
+
+	// Nested in a list item the line stays plain text of the item
+	Markdown::Document nested;
+	nested.limits.maxBlockDepth = 3;
+	nested.parse("* * * *item*");
+	REQUIRE(contains(nested.getHtml(), "<li>* * *item*</li>"));
+}
+
+TEST_CASE("Block depth within the limit", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.maxBlockDepth = 3;
+	doc.parse("> > Quote\n\n- Item");
+
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::None);
+}
+
+TEST_CASE("Inline depth limit", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.maxInlineDepth = 1;
+	doc.parse("**Strong *emphasis* text**");
+
+	std::string html = doc.getHtml();
+	REQUIRE(contains(html, "<strong>"));
+	REQUIRE(contains(html, "*emphasis*"));
+	REQUIRE(!contains(html, "<em>"));
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::InlineDepth);
+
+	// Styles without anything nested in them don't reach the limit
+	Markdown::Document flat;
+	flat.limits.maxInlineDepth = 1;
+	flat.parse("**Strong** and *emphasis*");
+	REQUIRE(contains(flat.getHtml(), "<em>emphasis</em>"));
+	REQUIRE(flat.getExceededLimits() == Markdown::Limit::None);
+}
+
+TEST_CASE("Table columns limit", "[parselimits]")
+{
+	Markdown::registerStandardExtensions();
+
+	Markdown::Document doc;
+	doc.limits.maxTableColumns = 2;
+	doc.parse("a|b|c\n-|-|-\n*1*|2|3\n\nx|y\n-|-\n1|2");
+
+	// Whole table is a single paragraph, the narrower one is kept
+	std::string html = doc.getHtml();
+	REQUIRE(contains(html, "<p>a|b|c -|-|- *1*|2|3</p>"));
+	REQUIRE(contains(html, "<table>"));
+	REQUIRE(!contains(html, "<ul>"));
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::TableColumns);
+}
+
+TEST_CASE("Spans per entry limit", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.maxSpansPerEntry = 3;
+	doc.parse("Text *a* *b* *c* *d*\n\nText *e*");
+
+	std::string html = doc.getHtml();
+	REQUIRE(contains(html, "<em>a</em>"));
+	REQUIRE(contains(html, "*d*"));
+	REQUIRE(!contains(html, "<em>d</em>"));
+	// Every entry has its own spans
+	REQUIRE(contains(html, "<em>e</em>"));
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::SpansPerEntry);
+}
+
+TEST_CASE("Deadline", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.limits.timeout = std::chrono::steady_clock::duration::zero();
+	doc.parse("> Quote\n\n- Item\n\n**Strong**");
+
+	// Everything is kept as plain text
+	std::string html = doc.getHtml();
+	REQUIRE(!contains(html, "<blockquote>"));
+	REQUIRE(!contains(html, "<ul>"));
+	REQUIRE(!contains(html, "<strong>"));
+	REQUIRE(contains(html, "**Strong**"));
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::Deadline);
+
+	// Deadline is measured from the start of the parse
+	Markdown::Document other;
+	other.limits.timeout = std::chrono::hours(1);
+	other.parse("**Strong**");
+	REQUIRE(contains(other.getHtml(), "<strong>"));
+	REQUIRE(other.getExceededLimits() == Markdown::Limit::None);
+}
+
+TEST_CASE("Parse limits applied to edits", "[parselimits]")
+{
+	Markdown::Document doc;
+	doc.keepSource = true;
+	doc.limits.maxBlockDepth = 2;
+	doc.parse("Paragraph\n\nOther paragraph");
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::None);
+
+	doc.applyEdit(0, 0, "> > > ");
+	REQUIRE(doc.getExceededLimits() == Markdown::Limit::BlockDepth);
+	REQUIRE(contains(doc.getText(), "> > Paragraph"));
+}
+
+TEST_CASE("Parse limits of the streaming parsers", "[parselimits]")
+{
+	Markdown::ParseLimits limits;
+	limits.maxInputBytes = 12;
+	limits.maxBlockDepth = 1;
+
+	std::vector<std::string> blocks;
+	Markdown::ElementStream stream([&blocks](std::shared_ptr<Markdown::Element> element) {
+		blocks.push_back(element->getHtml());
+	}, Markdown::Type::None, limits);
+	stream.feed("* a\n* b\n");
+	stream.feed("Dropped line");
+	stream.finish();
+
+	REQUIRE(blocks == std::vector<std::string>{ "<p>* a * b</p>" });
+	REQUIRE(stream.getExceededLimits() == (Markdown::Limit::InputBytes | Markdown::Limit::BlockDepth));
+
+	std::string html;
+	Markdown::Transcoder transcoder([&html](std::string_view part) { html += part; }, Markdown::Transcoder::ReferencePolicy::Immediate, Markdown::Type::None, limits);
+	transcoder.addDocumentTags = false;
+	transcoder.feed("> > Quote");
+	transcoder.finish();
+
+	REQUIRE(!contains(html, "<blockquote>"));
+	REQUIRE(transcoder.getExceededLimits() == Markdown::Limit::BlockDepth);
+
+	const std::string source = "- Item";
+	Markdown::ElementRange range = Markdown::Document::lazyElements(source, Markdown::Type::None, limits);
+	for (const auto& element : range)
+		REQUIRE(element->getType() == Markdown::Type::Paragraph);
+	REQUIRE(range.getExceededLimits() == Markdown::Limit::BlockDepth);
+}
+
+// Slow inputs of the fuzzers are bounded by the limits instead of failing
+TEST_CASE("Parse limits bound fuzzed inputs", "[parselimits]")
+{
+	Markdown::ParseLimits limits;
+	limits.maxBlockDepth = 16;
+	limits.maxInlineDepth = 8;
+	limits.maxSpansPerEntry = 256;
+
+	for (const std::string& source : {
+		repeat(">", 100000) + " Quote",
+		repeat("- ", 50000) + "Item",
+		repeat("*_", 20000) + "text" + repeat("_*", 20000),
+		[] {
+			std::string list;
+			for (size_t i = 0; i < 1000; i++)
+				list += repeat("    ", i) + "- Item\n";
+			return list;
+		}()
+	})
+	{
+		Markdown::Document doc;
+		doc.limits = limits;
+		Markdown::ParseStats stats;
+
+		REQUIRE_NOTHROW(doc.parse(source, stats));
+		REQUIRE(stats.peakDepth <= limits.maxBlockDepth);
+		REQUIRE(doc.getExceededLimits() != Markdown::Limit::None);
+	}
+}
+
+// Minimized from the slow inputs of the fuzzers in fuzz/, their cost per byte stays the same as the input grows
+TEST_CASE("Fuzzed slow inputs are linear", "[parselimits]")
+{
+	const std::vector<std::function<std::string(size_t)>> inputs = {
+		[](size_t count) { return "3" + repeat(".", count) + " Third"; },
+		[](size_t count) { return "123." + repeat(" .", count); },
+		[](size_t count) { return "**__" + repeat("b=ol_", count) + "d__**"; }
+	};
+
+	for (const auto& input : inputs)
+	{
+		std::string small = input(4096);
+		std::string large = input(16384);
+		INFO(small.substr(0, 16));
+
+		ParseCost smallCost = ParseCost::measure(small);
+		ParseCost largeCost = ParseCost::measure(large);
+		CHECK(largeCost.allocations < smallCost.allocations * 1.5 + 0.01);
+		CHECK(largeCost.allocatedBytes < smallCost.allocatedBytes * 1.5 + 1);
+		CHECK(largeCost.parses < smallCost.parses * 1.5 + 0.01);
+	}
+}
@@ -0,0 +1,102 @@
+#include "cppmarkdown/parsestats.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/textentry.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <memory>
+#include <string>
+
+TEST_CASE("Parse statistics", "[parsestats]")
+{
+	const std::string source = "# Heading\n\nParagraph with *emphasis*\nand **strong** text\n\n> Quote\n> > Nested quote\n\n- Item\n    - Nested item";
+
+	Markdown::Document doc;
+	Markdown::ParseStats stats;
+	doc.parse(source, stats);
+
+	REQUIRE(Markdown::ParseStats::get() == nullptr);
+	REQUIRE(stats.bytes == source.size());
+	REQUIRE(stats.lines == 10);
+
+	REQUIRE(stats.getElements(Markdown::Type::Heading) == 1);
+	REQUIRE(stats.getElements(Markdown::Type::Paragraph) >= 1);
+	REQUIRE(stats.getElements(Markdown::Type::Blockquote) == 2);
+	REQUIRE(stats.getElements(Markdown::Type::List) == 2);
+	REQUIRE(stats.getElements(Markdown::Type::ListItem) == 2);
+	REQUIRE(stats.peakDepth >= 3);
+	REQUIRE(stats.spans > 0);
+
+	// Every line is offered to the parsers, headings are rejected by all but the heading lines
+	REQUIRE(stats.getAttempts(Markdown::Type::Heading) > 1);
+	REQUIRE(stats.getRejections(Markdown::Type::Heading) == stats.getAttempts(Markdown::Type::Heading) - 1);
+	REQUIRE(stats.getAttempts(Markdown::Type::Paragraph) > 0);
+	REQUIRE(stats.getRejections(Markdown::Type::Paragraph) <= stats.getAttempts(Markdown::Type::Paragraph));
+
+	// Blank line after the quote completes it and is parsed again
+	REQUIRE(stats.retries >= 1);
+
+	REQUIRE(stats.blockParseSeconds > 0.0);
+	REQUIRE(stats.inlineParseSeconds > 0.0);
+	REQUIRE(stats.finalizeSeconds > 0.0);
+}
+
+TEST_CASE("Parse statistics are reset", "[parsestats]")
+{
+	Markdown::ParseStats stats;
+	stats.lines = 100;
+	stats.retries = 100;
+
+	Markdown::Document doc;
+	doc.parse("Paragraph", stats);
+
+	REQUIRE(stats.lines == 1);
+	REQUIRE(stats.retries == 0);
+	REQUIRE(stats.getElements(Markdown::Type::Paragraph) == 1);
+	REQUIRE(stats.peakDepth == 1);
+
+	// Parsing without statistics doesn't count anything
+	Markdown::Document other;
+	other.parse("# Heading");
+	REQUIRE(stats.getElements(Markdown::Type::Heading) == 0);
+}
+
+TEST_CASE("Parse statistics forward trace events", "[parsestats]")
+{
+	struct Counter : public Markdown::Tracer
+	{
+		size_t events = 0;
+
+		virtual void begin(const Markdown::TraceEvent&) override { this->events++; }
+		virtual void end(const Markdown::TraceEvent&) override {}
+	};
+
+	Counter counter;
+	Markdown::ParseStats stats;
+	{
+		Markdown::Tracer::ContextGuard guard(counter);
+		Markdown::Document doc;
+		doc.parse("# Heading\n\nParagraph", stats);
+		REQUIRE(Markdown::Tracer::get() == &counter);
+	}
+
+	REQUIRE(counter.events > 0);
+	REQUIRE(stats.getElements(Markdown::Type::Heading) == 1);
+}
+
+TEST_CASE("Parse statistics count the parsed spans once", "[parsestats]")
+{
+	Markdown::Document doc;
+	Markdown::ParseStats stats;
+	doc.parse("Text *emphasis*", stats);
+
+	// Paragraph's default style, the text and the emphasis
+	REQUIRE(stats.spans == 3);
+
+	// Clones of the spans aren't parsed again
+	Markdown::ParseStats::ContextGuard guard(stats);
+	Markdown::Span span("Text", nullptr);
+	span.children.push_back(std::make_unique<Markdown::Span>("Child", nullptr));
+	REQUIRE(span.clone()->children.size() == 1);
+	REQUIRE(stats.spans == 3);
+}
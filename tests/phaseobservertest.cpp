@@ -0,0 +1,102 @@
+#include "cppmarkdown/phaseobserver.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/textentry.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Records entered phases, with the phase each of them is nested in
+	struct Recorder : public Markdown::PhaseObserver
+	{
+		struct Entry
+		{
+			Markdown::Phase phase;
+			bool nested;
+			Markdown::Phase parent;
+		};
+
+		std::vector<Entry> entries;
+		std::vector<Markdown::Phase> stack;
+		bool balanced = true;
+
+		virtual void enter(Markdown::Phase phase) override
+		{
+			this->entries.push_back({ phase, !this->stack.empty(), this->stack.empty() ? phase : this->stack.back() });
+			this->stack.push_back(phase);
+		}
+
+		virtual void exit(Markdown::Phase phase) override
+		{
+			if (this->stack.empty() || this->stack.back() != phase)
+				this->balanced = false;
+			else
+				this->stack.pop_back();
+		}
+
+		bool entered(Markdown::Phase phase) const
+		{
+			return std::any_of(this->entries.begin(), this->entries.end(), [phase](const Entry& entry) { return entry.phase == phase; });
+		}
+	};
+}
+
+TEST_CASE("Phases of parsing and rendering", "[phaseobserver]")
+{
+	Recorder recorder;
+	{
+		Markdown::Tracer::ContextGuard guard(recorder);
+		REQUIRE(Markdown::Tracer::get() == &recorder);
+
+		Markdown::Document doc;
+		doc.parse("# Heading\n\nParagraph with *emphasis*\nand second line\n\n> Quote");
+		doc.getHtml();
+	}
+
+	REQUIRE(Markdown::Tracer::get() == nullptr);
+	REQUIRE(recorder.balanced);
+	REQUIRE(recorder.stack.empty());
+
+	REQUIRE(recorder.entered(Markdown::Phase::LineSplit));
+	REQUIRE(recorder.entered(Markdown::Phase::BlockParse));
+	REQUIRE(recorder.entered(Markdown::Phase::InlineParse));
+	REQUIRE(recorder.entered(Markdown::Phase::Finalize));
+	REQUIRE(recorder.entered(Markdown::Phase::Render));
+
+	// Lines are parsed while the source is split, except the last one, nested blocks while their parents are parsed
+	// Text is parsed while the blocks are parsed or finalized
+	for (const auto& entry : recorder.entries)
+	{
+		if (entry.phase == Markdown::Phase::BlockParse && entry.nested)
+			REQUIRE((entry.parent == Markdown::Phase::LineSplit || entry.parent == Markdown::Phase::BlockParse));
+
+		if (entry.phase == Markdown::Phase::InlineParse)
+		{
+			REQUIRE(entry.nested);
+			REQUIRE((entry.parent == Markdown::Phase::BlockParse || entry.parent == Markdown::Phase::Finalize));
+		}
+	}
+}
+
+TEST_CASE("Inline parsing phase", "[phaseobserver]")
+{
+	Recorder recorder;
+	{
+		Markdown::Tracer::ContextGuard guard(recorder);
+		Markdown::TextEntry entry("Text with **strong** and *emphasis*");
+	}
+
+	REQUIRE(recorder.entries.size() == 1);
+	REQUIRE(recorder.entries.front().phase == Markdown::Phase::InlineParse);
+	REQUIRE(recorder.balanced);
+}
+
+TEST_CASE("Phase names", "[phaseobserver]")
+{
+	REQUIRE(std::string(Markdown::getPhaseName(Markdown::Phase::LineSplit)) == "lineSplit");
+	REQUIRE(std::string(Markdown::getPhaseName(Markdown::Phase::Render)) == "render");
+}
@@ -34,6 +34,15 @@ TEST_CASE("Reference parsing", "[line]")
 	REQUIRE(el6.getTitle() == "title with spaces \'and apostrophes\'");
 }
 
+TEST_CASE("Reference with escaped bracket", "[line]")
+{
+	Markdown::ReferenceElement el("[id\\]x]: value");
+	REQUIRE(el.getValue() == "value");
+
+	Markdown::ReferenceElement el2("[Text\\] without reference");
+	REQUIRE(el2.getValue().empty());
+}
+
 TEST_CASE("Reference manager registration", "[line]")
 {
 	Markdown::ReferenceManager man;
@@ -0,0 +1,172 @@
+#include "cppmarkdown/shareddocumentcache.h"
+
+#ifdef CPPMARKDOWN_SHARED_CACHE
+
+#include "cppmarkdown/document.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+
+#include <vector>
+#include <thread>
+#include <chrono>
+
+namespace
+{
+	std::string makeDocument(int n)
+	{
+		return "# Document " + std::to_string(n) + "\n\nParagraph with *emphasis* and [a link][ref]\n\n* Item\n* Item\n\n[ref]: http://example.com/" + std::to_string(n);
+	}
+
+	std::string parseHtml(const std::string& source)
+	{
+		Markdown::Document doc;
+		doc.parse(source);
+		return doc.getHtml();
+	}
+}
+
+TEST_CASE("Shared document cache lookup", "[shareddocumentcache]")
+{
+	Markdown::SharedDocumentCache cache(64 * 1024, 16);
+	std::string source = makeDocument(1);
+	std::string fallback;
+
+	REQUIRE_FALSE(cache.find(source));
+	REQUIRE(cache.get(source, fallback).getHtml() == parseHtml(source));
+	REQUIRE(fallback.empty());
+
+	auto found = cache.find(source);
+	REQUIRE(found);
+	REQUIRE(found->getHtml() == parseHtml(source));
+	REQUIRE_FALSE(cache.find(makeDocument(2)));
+
+	Markdown::SharedDocumentCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.parses == 1);
+	REQUIRE(statistics.entries == 1);
+	REQUIRE(statistics.hits == 1);
+	REQUIRE(statistics.misses == 3);
+}
+
+TEST_CASE("Shared document cache overflow", "[shareddocumentcache]")
+{
+	Markdown::SharedDocumentCache cache(64, 2);
+	std::string fallback;
+
+	// Neither the entry nor a third slot is available, documents are parsed into the fallback
+	for (int i = 0; i < 3; i++)
+	{
+		std::string source = makeDocument(i);
+		REQUIRE(cache.get(source, fallback).getHtml() == parseHtml(source));
+		REQUIRE_FALSE(fallback.empty());
+	}
+
+	REQUIRE(cache.getStatistics().entries == 0);
+}
+
+TEST_CASE("Shared document cache across processes", "[shareddocumentcache]")
+{
+	const int workers = 4;
+	const int documents = 16;
+
+	Markdown::SharedDocumentCache cache(1024 * 1024);
+
+	std::vector<std::string> expected;
+	for (int i = 0; i < documents; i++)
+		expected.push_back(parseHtml(makeDocument(i)));
+
+	std::vector<pid_t> children;
+	for (int worker = 0; worker < workers; worker++)
+	{
+		pid_t pid = fork();
+		REQUIRE(pid >= 0);
+		if (pid == 0)
+		{
+			// Workers render every document a few times, starting at different ones
+			int failures = 0;
+			std::string fallback;
+			for (int i = 0; i < documents * 3; i++)
+			{
+				int n = (i + worker * 5) % documents;
+				if (cache.get(makeDocument(n), fallback).getHtml() != expected[n])
+					failures++;
+			}
+			_exit(failures == 0 ? 0 : 1);
+		}
+		children.push_back(pid);
+	}
+
+	for (pid_t pid : children)
+	{
+		int status = 0;
+		REQUIRE(waitpid(pid, &status, 0) == pid);
+		REQUIRE(WIFEXITED(status));
+		REQUIRE(WEXITSTATUS(status) == 0);
+	}
+
+	Markdown::SharedDocumentCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.parses == documents);
+	REQUIRE(statistics.entries == documents);
+	REQUIRE(statistics.hits + statistics.misses == workers * documents * 3);
+}
+
+TEST_CASE("Shared document cache claim of a dead process", "[shareddocumentcache]")
+{
+	Markdown::SharedDocumentCache cache(64 * 1024 * 1024, 16);
+	cache.waitTimeout = std::chrono::milliseconds(10);
+
+	std::string source;
+	for (int i = 0; i < 10000; i++)
+		source += makeDocument(i) + "\n\n";
+
+	pid_t pid = fork();
+	REQUIRE(pid >= 0);
+	if (pid == 0)
+	{
+		std::string fallback;
+		cache.get(source, fallback);
+		_exit(0);
+	}
+
+	// Child is killed while parsing the claimed source
+	while (cache.getStatistics().parses == 0)
+		std::this_thread::yield();
+	kill(pid, SIGKILL);
+
+	int status = 0;
+	REQUIRE(waitpid(pid, &status, 0) == pid);
+	REQUIRE(WIFSIGNALED(status));
+
+	std::string fallback;
+	REQUIRE(cache.get(source, fallback).getHtml() == parseHtml(source));
+	REQUIRE(fallback.empty());
+	REQUIRE(cache.find(source));
+
+	Markdown::SharedDocumentCache::Statistics statistics = cache.getStatistics();
+	REQUIRE(statistics.parses == 2);
+	REQUIRE(statistics.entries == 1);
+}
+
+TEST_CASE("Named shared document cache", "[shareddocumentcache]")
+{
+	std::string name = "/cppmarkdown-test-" + std::to_string(getpid());
+	std::string source = makeDocument(1);
+	std::string fallback;
+
+	Markdown::SharedDocumentCache cache(name, 64 * 1024, 16);
+	cache.get(source, fallback);
+
+	Markdown::SharedDocumentCache attached = Markdown::SharedDocumentCache::open(name);
+	auto found = attached.find(source);
+	REQUIRE(found);
+	REQUIRE(found->getHtml() == parseHtml(source));
+
+	REQUIRE_THROWS_AS(Markdown::SharedDocumentCache(name, 64 * 1024, 16), std::system_error);
+	Markdown::SharedDocumentCache::remove(name);
+	REQUIRE_THROWS_AS(Markdown::SharedDocumentCache::open(name), std::system_error);
+}
+
+#endif
@@ -0,0 +1,218 @@
+#include "cppmarkdown/sourcemap.h"
+#include "cppmarkdown/document.h"
+#include "cppmarkdown/paragraphelement.h"
+#include "cppmarkdown/headingelement.h"
+#include "cppmarkdown/listelement.h"
+#include "cppmarkdown/ext/tableelement.h"
+#include "cppmarkdown/extensions.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	// Source text of every styled span below the block's default style, depth first
+	void collectSpans(const Markdown::SourceMap& map, const Markdown::Span& span, std::vector<std::string>& result)
+	{
+		for (const auto& child : span.children)
+		{
+			if (child->style)
+				result.push_back(std::string(map.getText(child->sourceRange)));
+
+			collectSpans(map, *child, result);
+		}
+	}
+
+	std::vector<std::string> styledSpans(const Markdown::SourceMap& map, const Markdown::TextEntry& text)
+	{
+		std::vector<std::string> result;
+		for (const auto& span : text.spans)
+			collectSpans(map, *span, result);
+		return result;
+	}
+}
+
+TEST_CASE("Source map line index", "[sourcemap]")
+{
+	Markdown::SourceMap map;
+	map.addLine("First");
+	map.addLine("");
+	map.addLine("Third line");
+
+	REQUIRE(map.getLineCount() == 3);
+	REQUIRE(map.getSource() == "First\n\nThird line");
+
+	REQUIRE(map.getLocation(0).line == 1);
+	REQUIRE(map.getLocation(0).column == 1);
+	REQUIRE(map.getLocation(4).column == 5);
+	REQUIRE(map.getLocation(6).line == 2);
+	REQUIRE(map.getLocation(7).line == 3);
+	REQUIRE(map.getLocation(9).column == 3);
+
+	REQUIRE(map.getText(map.getLineRange(1)) == "First");
+	REQUIRE(map.getText(map.getLineRange(2)) == "");
+	REQUIRE(map.getText(map.getLineRange(3)) == "Third line");
+	REQUIRE_FALSE(map.getLineRange(4).valid());
+}
+
+TEST_CASE("Source map element ranges", "[sourcemap]")
+{
+	std::string markdown = R"md(# Title
+First paragraph
+with two lines
+
+* Item 1
+* Item 2
+    * Subitem
+
+> Quote
+> continued
+
+Heading
+===)md";
+
+	Markdown::SourceMap map;
+	Markdown::Document doc;
+	{
+		Markdown::SourceMap::ContextGuard guard(map);
+		doc.parse(markdown);
+	}
+
+	REQUIRE(map.getSource() == markdown);
+
+	std::vector<std::string> texts;
+	for (const auto& element : doc)
+	{
+		if (element->getType() != Markdown::Type::LineBreak)
+			texts.push_back(std::string(map.getText(element->sourceRange)));
+	}
+
+	REQUIRE(texts == std::vector<std::string>{
+		"# Title",
+		"First paragraph\nwith two lines",
+		"* Item 1\n* Item 2\n    * Subitem",
+		"> Quote\n> continued",
+		"Heading\n==="
+	});
+
+	auto it = std::find_if(doc.begin(), doc.end(), [](const auto& element) { return element->getType() == Markdown::Type::List; });
+	REQUIRE(it != doc.end());
+
+	auto list = std::static_pointer_cast<Markdown::ListElement>(*it);
+	REQUIRE(map.getText(list->at(0)->sourceRange) == "* Item 1");
+	REQUIRE(map.getText(list->at(1)->sourceRange) == "* Item 2\n    * Subitem");
+
+	Markdown::SourceLocation location = map.getLocation(list->at(1)->sourceRange.begin);
+	REQUIRE(location.line == 6);
+	REQUIRE(location.column == 1);
+}
+
+TEST_CASE("Source map span ranges", "[sourcemap]")
+{
+	std::string markdown = "# A *title*\n\nSome *emphasis* and **strong *nested* text**\n  with [a link](url) on the next line";
+
+	Markdown::SourceMap map;
+	Markdown::Document doc;
+	{
+		Markdown::SourceMap::ContextGuard guard(map);
+		doc.parse(markdown);
+	}
+
+	auto heading = std::static_pointer_cast<Markdown::HeadingElement>(doc.front());
+	REQUIRE(styledSpans(map, heading->text) == std::vector<std::string>{ "*title*" });
+
+	auto paragraph = std::static_pointer_cast<Markdown::ParagraphElement>(doc.back());
+	REQUIRE(paragraph->getType() == Markdown::Type::Paragraph);
+	REQUIRE(styledSpans(map, paragraph->text) == std::vector<std::string>{
+		"*emphasis*", "**strong *nested* text**", "*nested*", "[a link](url)"
+	});
+}
+
+TEST_CASE("Source map span ranges of repeated words", "[sourcemap]")
+{
+	std::string markdown = "# # Title *x*\n\nx *x* x\n  x *x* **x *x* x**\n\n[*x*](x) ![*x*](x) *x*\n\na|*a*\n-|-\n*a*|a *a*";
+
+	Markdown::registerStandardExtensions();
+
+	Markdown::SourceMap map;
+	Markdown::Document doc;
+	{
+		Markdown::SourceMap::ContextGuard guard(map);
+		doc.parse(markdown);
+	}
+
+	// Ranges of every span, checked by their offsets so that repeated text can't match the wrong occurrence
+	std::vector<std::pair<size_t, std::string>> ranges;
+	std::function<void(const Markdown::Span&)> collect = [&](const Markdown::Span& span) {
+		if (span.style)
+		{
+			REQUIRE(span.sourceRange.valid());
+			ranges.emplace_back(span.sourceRange.begin, std::string(map.getText(span.sourceRange)));
+		}
+
+		for (const auto& child : span.children)
+			collect(*child);
+	};
+	// Spans of paragraphs and headings are wrapped in the default style, the cells have none
+	auto collectEntry = [&](const Markdown::TextEntry& text, bool defaultStyle) {
+		for (const auto& span : text.spans)
+		{
+			if (!defaultStyle)
+				collect(*span);
+			else
+				for (const auto& child : span->children)
+					collect(*child);
+		}
+	};
+	auto walk = [&](Markdown::Element& element) {
+		if (element.getType() == Markdown::Type::Heading)
+			collectEntry(static_cast<Markdown::HeadingElement&>(element).text, true);
+		else if (element.getType() == Markdown::Type::Paragraph)
+			collectEntry(static_cast<Markdown::ParagraphElement&>(element).text, true);
+		else if (element.getType() == Markdown::Type::Extension)
+		{
+			auto& table = static_cast<Markdown::TableElement&>(element);
+			for (size_t column = 0; column < table.columnCount(); column++)
+				collectEntry(*table.getHeaderCell(column), false);
+			for (size_t column = 0; column < table.columnCount(); column++)
+				collectEntry(*table.getCell(0, column), false);
+		}
+	};
+	for (const auto& element : doc)
+		walk(*element);
+
+	auto at = [&markdown](const std::string& text, size_t from) { return std::make_pair(markdown.find(text, from), text); };
+	size_t paragraph = markdown.find("x *x* x");
+	size_t links = markdown.find("[*x*]");
+	size_t table = markdown.find("a|*a*");
+
+	REQUIRE(ranges == std::vector<std::pair<size_t, std::string>>{
+		at("*x*", 0),
+		at("*x*", paragraph),
+		at("*x*", paragraph + 6),
+		at("**x *x* x**", paragraph),
+		at("*x*", paragraph + 20),
+		at("[*x*](x)", links),
+		at("*x*", links),
+		at("![*x*](x)", links),
+		at("*x*", links + 10),
+		at("*x*", links + 19),
+		at("*a*", table),
+		at("*a*", table + 10),
+		at("*a*", table + 16)
+	});
+}
+
+TEST_CASE("Parsing without source map", "[sourcemap]")
+{
+	Markdown::Document doc;
+	doc.parse("# Title\n\nSome *text*");
+
+	for (const auto& element : doc)
+		REQUIRE_FALSE(element->sourceRange.valid());
+
+	auto paragraph = std::static_pointer_cast<Markdown::ParagraphElement>(doc.back());
+	REQUIRE_FALSE(paragraph->text.spans.front()->sourceRange.valid());
+}
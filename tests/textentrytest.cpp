@@ -98,12 +98,31 @@ TEST_CASE("Links with escapes", "[textentry]")
 	REQUIRE(te.getHtml() == "<a href=\"link with (parentheses) and &quot;quotes&quot;\">Text</a>");
 }
 
+TEST_CASE("Links with escaped brackets", "[textentry]")
+{
+	Markdown::TextEntry te("[Text \\] more](link)");
+	REQUIRE(te.getHtml() == "<a href=\"link\">Text ] more</a>");
+
+	Markdown::TextEntry te2("Text\\] without link");
+	REQUIRE(te2.getText() == "Text] without link");
+
+	// Bracket after an escaped backslash is not escaped
+	Markdown::TextEntry te3("[Text \\\\](link)");
+	REQUIRE(te3.getHtml() == "<a href=\"link\">Text \\</a>");
+}
+
 TEST_CASE("Mixed links", "[textentry]")
 {
 	Markdown::TextEntry te("This is some [Text](link) blabla");
 	REQUIRE(te.getHtml() == "This is some <a href=\"link\">Text</a> blabla");
 }
 
+TEST_CASE("Link after rejected brackets", "[textentry]")
+{
+	REQUIRE(Markdown::TextEntry("Some [text] and [Some link](link)").getHtml() == "Some [text] and <a href=\"link\">Some link</a>");
+	REQUIRE(Markdown::TextEntry("[a [b] c [Link](link)").getHtml() == "[a [b] c <a href=\"link\">Link</a>");
+}
+
 TEST_CASE("Links with styles", "[textentry]")
 {
 	Markdown::TextEntry te("[**Bold** text](link)");
@@ -137,6 +156,7 @@ TEST_CASE("Imcomplete images", "[textentry]")
 	REQUIRE(Markdown::TextEntry("!Something").getHtml() == "!Something");
 	REQUIRE(Markdown::TextEntry("![alt").getHtml() == "![alt");
 	REQUIRE(Markdown::TextEntry("![alt](blabla").getHtml() == "![alt](blabla");
+	REQUIRE(Markdown::TextEntry("Wow! [Link](link)").getHtml() == "Wow! <a href=\"link\">Link</a>");
 }
 
 TEST_CASE("Text entry in document", "[textentry]")
@@ -167,4 +187,26 @@ TEST_CASE("Escaped backslash text entry", "[textentry]")
 	REQUIRE(Markdown::TextEntry("Last backslash \\").getHtml() == "Last backslash \\");
 	REQUIRE(Markdown::TextEntry("Last escaped backslash \\\\").getHtml() == "Last escaped backslash \\");
 	REQUIRE(Markdown::TextEntry("Multiple \\ backslashes \\\\ test \\\\\\ test").getHtml() == "Multiple  backslashes \\ test \\ test");
-}
\ No newline at end of file
+}
+TEST_CASE("HTML escaped text entry", "[textentry]")
+{
+	REQUIRE(Markdown::TextEntry("1 < 2 & 3 > 2").getHtml() == "1 &lt; 2 &amp; 3 &gt; 2");
+	REQUIRE(Markdown::TextEntry("*<script>*").getHtml() == "<em>&lt;script&gt;</em>");
+	REQUIRE(Markdown::TextEntry("`<br>`").getHtml() == "<code>&lt;br&gt;</code>");
+	REQUIRE(Markdown::TextEntry("![a \"quoted\" image](image.png)").getHtml() == "<img src=\"image.png\" alt=\"a &quot;quoted&quot; image\">");
+}
+
+TEST_CASE("Unsafe link urls", "[textentry]")
+{
+	REQUIRE(Markdown::TextEntry("[Click](javascript:alert(1\\))").getHtml() == "<a href=\"#\">Click</a>");
+	REQUIRE(Markdown::TextEntry("![Image](javascript:alert(1\\))").getHtml() == "<img src=\"#\" alt=\"Image\">");
+	REQUIRE(Markdown::TextEntry("[Safe](https://example.com?a=1&b=2)").getHtml() == "<a href=\"https://example.com?a=1&amp;b=2\">Safe</a>");
+}
+
+TEST_CASE("Nested duplicate style with several children", "[textentry]")
+{
+	Markdown::TextEntry entry("**__a _b_ c _d_ e__**");
+
+	REQUIRE(entry.getHtml() == "<strong>a <em>b</em> c <em>d</em> e</strong>");
+	REQUIRE(entry.getMarkdown() == "**a _b_ c _d_ e**");
+}
@@ -0,0 +1,202 @@
+#include "cppmarkdown/tracer.h"
+#include "cppmarkdown/document.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Records completed events, checking that every event ends in the order it began
+	struct Recorder : public Markdown::Tracer
+	{
+		std::vector<Markdown::TraceEvent> completed;
+		std::vector<std::string> stack;
+		bool balanced = true;
+
+		virtual void begin(const Markdown::TraceEvent& event) override
+		{
+			this->stack.push_back(event.name);
+		}
+
+		virtual void end(const Markdown::TraceEvent& event) override
+		{
+			if (this->stack.empty() || this->stack.back() != event.name)
+				this->balanced = false;
+			else
+				this->stack.pop_back();
+
+			this->completed.push_back(event);
+		}
+
+		std::vector<Markdown::TraceEvent> named(const std::string& name) const
+		{
+			std::vector<Markdown::TraceEvent> result;
+			std::copy_if(this->completed.begin(), this->completed.end(), std::back_inserter(result),
+				[&name](const Markdown::TraceEvent& event) { return event.name == name; });
+			return result;
+		}
+
+		bool hasType(const std::string& name, Markdown::Type type) const
+		{
+			auto events = this->named(name);
+			return std::any_of(events.begin(), events.end(), [type](const Markdown::TraceEvent& event) { return event.type == type; });
+		}
+	};
+
+	size_t count(const std::string& text, const std::string& pattern)
+	{
+		size_t result = 0;
+		for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+			result++;
+		return result;
+	}
+}
+
+TEST_CASE("Tracing is disabled by default", "[tracer]")
+{
+	REQUIRE(Markdown::Tracer::get() == nullptr);
+
+	Markdown::Tracer::Scope scope("unused", Markdown::Phase::Render);
+	scope.setType(Markdown::Type::Paragraph);
+	scope.setBytes(10);
+
+	Markdown::Document doc;
+	doc.parse("# Heading\n\nParagraph");
+	REQUIRE(Markdown::Tracer::get() == nullptr);
+}
+
+TEST_CASE("Trace events of parsing and rendering", "[tracer]")
+{
+	const std::string source = "# Heading\n\nParagraph with *emphasis*\nand second line\n\n> Quote\n\n- Item";
+
+	Recorder recorder;
+	std::string html;
+	Markdown::Document doc;
+	{
+		Markdown::Tracer::ContextGuard guard(recorder);
+		REQUIRE(Markdown::Tracer::get() == &recorder);
+
+		doc.parse(source);
+		html = doc.getHtml();
+	}
+
+	REQUIRE(Markdown::Tracer::get() == nullptr);
+	REQUIRE(recorder.balanced);
+	REQUIRE(recorder.stack.empty());
+
+	auto parse = recorder.named("parse");
+	REQUIRE_FALSE(parse.empty());
+	REQUIRE(parse.back().phase == Markdown::Phase::LineSplit);
+	REQUIRE(parse.back().bytes == source.size());
+
+	// Every line is dispatched, tagged with the element it was parsed into
+	auto lines = recorder.named("parseLine");
+	REQUIRE(lines.size() >= 8);
+	REQUIRE(recorder.hasType("parseLine", Markdown::Type::Heading));
+	REQUIRE(recorder.hasType("parseLine", Markdown::Type::Paragraph));
+	REQUIRE(recorder.hasType("parseLine", Markdown::Type::Blockquote));
+	REQUIRE(recorder.hasType("parseLine", Markdown::Type::List));
+	REQUIRE(recorder.hasType("finalize", Markdown::Type::Blockquote));
+	REQUIRE(recorder.named("finalizeElements").size() == 1);
+	REQUIRE(recorder.hasType("documentFinalize", Markdown::Type::Heading));
+	REQUIRE(recorder.hasType("finishDocumentFinalize", Markdown::Type::List));
+
+	auto inlines = recorder.named("parseInline");
+	REQUIRE_FALSE(inlines.empty());
+	REQUIRE(inlines.front().phase == Markdown::Phase::InlineParse);
+
+	// Elements report the size of their output, the document that of the whole page
+	for (const auto& element : doc)
+		REQUIRE(recorder.hasType("render", element->getType()));
+
+	auto render = recorder.named("render");
+	REQUIRE(render.back().type == Markdown::Type::None);
+	REQUIRE(render.back().bytes == html.size());
+	REQUIRE(render.front().bytes == doc.begin()->get()->getCachedHtml().size());
+}
+
+TEST_CASE("Several active tracers", "[tracer]")
+{
+	Recorder outer;
+	Recorder inner;
+	Markdown::ChromeTraceSink sink;
+	{
+		Markdown::Tracer::ContextGuard outerGuard(outer);
+		Markdown::Tracer::ContextGuard sinkGuard(sink);
+		{
+			Markdown::Tracer::ContextGuard innerGuard(inner);
+			// Already active, the events aren't received twice
+			Markdown::Tracer::ContextGuard againGuard(outer);
+			REQUIRE(Markdown::Tracer::get() == &inner);
+			REQUIRE(outer.isActive());
+
+			Markdown::Document doc;
+			doc.parse("# Heading\n\nParagraph");
+		}
+
+		REQUIRE(Markdown::Tracer::get() == &sink);
+		REQUIRE(!inner.isActive());
+		REQUIRE(outer.isActive());
+	}
+
+	REQUIRE(Markdown::Tracer::get() == nullptr);
+	REQUIRE(!outer.isActive());
+
+	REQUIRE(outer.balanced);
+	REQUIRE(inner.balanced);
+	REQUIRE(!inner.completed.empty());
+	REQUIRE(outer.completed.size() == inner.completed.size());
+	REQUIRE(sink.getEventCount() == inner.completed.size() * 2);
+}
+
+TEST_CASE("Tracers are active on their thread", "[tracer]")
+{
+	Recorder recorder;
+	Markdown::Tracer::ContextGuard guard(recorder);
+
+	Markdown::Tracer* active = &recorder;
+	std::thread thread([&active]() {
+		active = Markdown::Tracer::get();
+		Markdown::Document doc;
+		doc.parse("Paragraph");
+	});
+	thread.join();
+
+	REQUIRE(active == nullptr);
+	REQUIRE(recorder.completed.empty());
+}
+
+TEST_CASE("Chrome trace JSON", "[tracer]")
+{
+	Markdown::ChromeTraceSink sink;
+	{
+		Markdown::Tracer::ContextGuard guard(sink);
+		Markdown::Document doc;
+		doc.parse("# Heading\n\nParagraph with *emphasis*");
+		doc.getHtml();
+	}
+
+	REQUIRE(sink.getEventCount() > 0);
+	REQUIRE(sink.getEventCount() % 2 == 0);
+
+	std::ostringstream stream;
+	sink.write(stream);
+	std::string json = sink.getJson();
+	REQUIRE(json == stream.str());
+
+	REQUIRE(json.rfind("{\"traceEvents\":[", 0) == 0);
+	REQUIRE(json.find("],\"displayTimeUnit\":\"ns\"}") != std::string::npos);
+	REQUIRE(count(json, "\"ph\":\"B\"") == sink.getEventCount() / 2);
+	REQUIRE(count(json, "\"ph\":\"E\"") == sink.getEventCount() / 2);
+	REQUIRE(json.find("{\"name\":\"parseLine\",\"cat\":\"blockParse\",\"ph\":\"B\"") != std::string::npos);
+	REQUIRE(json.find("\"args\":{\"type\":\"Heading\",\"bytes\":") != std::string::npos);
+
+	sink.clear();
+	REQUIRE(sink.getEventCount() == 0);
+	REQUIRE(sink.getJson() == "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n");
+}
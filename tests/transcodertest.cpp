@@ -0,0 +1,88 @@
+#include "cppmarkdown/transcoder.h"
+#include "cppmarkdown/document.h"
+
+#include <catch2/catch_all.hpp>
+
+#include <sstream>
+
+namespace
+{
+	const std::string sampleMarkdown = R"md([ref]: http://example.com "Title"
+
+# Title
+First paragraph
+with *emphasis* and [a link][ref]
+
+> Quote
+
+* Item 1
+* Item 2
+
+    code block
+---
+Last paragraph)md";
+}
+
+TEST_CASE("Transcoded HTML matches document", "[transcoder]")
+{
+	Markdown::Document doc;
+	doc.parse(sampleMarkdown);
+
+	std::istringstream input(sampleMarkdown);
+	std::string html;
+	Markdown::Transcoder::transcode(input, [&html](std::string_view chunk) {
+		html += chunk;
+	});
+
+	REQUIRE(html == doc.getHtml());
+}
+
+TEST_CASE("Transcoder writes completed blocks", "[transcoder]")
+{
+	std::vector<std::string> writes;
+	Markdown::Transcoder transcoder([&writes](std::string_view chunk) {
+		writes.emplace_back(chunk);
+	});
+	transcoder.addDocumentTags = false;
+
+	transcoder.feed("# Heading\nParagraph");
+	REQUIRE(writes.empty());
+
+	transcoder.feed(" continues\n\n# Next heading\n");
+	REQUIRE(writes.size() == 2);
+	REQUIRE(writes.at(0) == "<h1>Heading</h1>");
+	REQUIRE(writes.at(1) == "<p>Paragraph continues</p>");
+
+	transcoder.finish();
+	REQUIRE(writes.back() == "<h1>Next heading</h1>");
+}
+
+TEST_CASE("Transcoder forward references", "[transcoder]")
+{
+	std::string markdown = "Uses [link][ref] before definition\n\nNext paragraph\n\n[ref]: http://example.com";
+
+	auto transcode = [&markdown](Markdown::Transcoder::ReferencePolicy policy) {
+		std::string html;
+		size_t pos = 0;
+		Markdown::Transcoder::transcode([&](char* buffer, size_t size) {
+			// Feed the input in small chunks
+			size_t count = std::min<size_t>({ size, 4, markdown.size() - pos });
+			markdown.copy(buffer, count, pos);
+			pos += count;
+			return count;
+		}, [&html](std::string_view chunk) {
+			html += chunk;
+		}, policy);
+		return html;
+	};
+
+	std::string immediate = transcode(Markdown::Transcoder::ReferencePolicy::Immediate);
+	REQUIRE(immediate.find("<a href=\"\">link</a>") != std::string::npos);
+
+	Markdown::Document doc;
+	doc.parse(markdown);
+
+	std::string deferred = transcode(Markdown::Transcoder::ReferencePolicy::Defer);
+	REQUIRE(deferred.find("<a href=\"http://example.com\">link</a>") != std::string::npos);
+	REQUIRE(deferred == doc.getHtml());
+}
@@ -0,0 +1,348 @@
+#include "corpusgenerator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace Tools
+{
+    namespace
+    {
+        const char* vocabulary[] = {
+            "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do",
+            "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua", "enim",
+            "ad", "minim", "veniam", "quis", "nostrud", "exercitation", "ullamco", "laboris", "nisi", "aliquip"
+        };
+
+        // Characters escaped with a backslash, pipes are left out so table cells stay intact
+        const char escapable[] = { '\\', '*', '_', '`', '[', ']', '(', ')', '!', '#' };
+
+        const size_t wordsPerLine = 10;
+
+        // Prefix every line of the block, blank lines get the prefix without trailing spaces
+        std::string prefixLines(const std::string& block, const std::string& prefix, const std::string& blankPrefix)
+        {
+            std::string result;
+            std::istringstream stream(block);
+            std::string line;
+            while (std::getline(stream, line))
+            {
+                if (!result.empty())
+                    result += '\n';
+                result += line.empty() ? blankPrefix : prefix + line;
+            }
+            return result;
+        }
+    }
+
+    // Settings
+
+    bool CorpusGenerator::Settings::set(const std::string& knob, const std::string& value)
+    {
+        if (knob == "seed")
+            this->seed = static_cast<unsigned int>(std::stoul(value));
+        else if (knob == "size")
+            this->size = std::stoul(value);
+        else if (knob == "paragraphLength")
+            this->paragraphLength = std::stoul(value);
+        else if (knob == "listDepth")
+            this->listDepth = std::stoul(value);
+        else if (knob == "blockquoteDepth")
+            this->blockquoteDepth = std::stoul(value);
+        else if (knob == "tableRows")
+            this->tableRows = std::stoul(value);
+        else if (knob == "tableColumns")
+            this->tableColumns = std::stoul(value);
+        else if (knob == "markerDensity")
+            this->markerDensity = std::stod(value);
+        else if (knob == "escapeDensity")
+            this->escapeDensity = std::stod(value);
+        else if (knob == "referenceCount")
+            this->referenceCount = std::stoul(value);
+        else
+            return false;
+        return true;
+    }
+
+    // Generator
+
+    CorpusGenerator::CorpusGenerator(const Settings& settings)
+        : settings(settings)
+        , random(settings.seed)
+    {
+        this->settings.markerDensity = std::clamp(this->settings.markerDensity, 0.0, 1.0);
+        this->settings.escapeDensity = std::clamp(this->settings.escapeDensity, 0.0, 1.0);
+        this->settings.paragraphLength = std::max<size_t>(this->settings.paragraphLength, 1);
+    }
+
+    std::string CorpusGenerator::generate()
+    {
+        return this->generate({ Block::Heading, Block::Paragraph, Block::Blockquote, Block::List, Block::Code, Block::Line, Block::Table });
+    }
+
+    std::string CorpusGenerator::generate(const std::vector<Block>& blocks)
+    {
+        // Relative frequency of the blocks, nesting knobs set to zero leave the block out
+        std::vector<std::pair<Block, size_t>> weights = {
+            { Block::Heading, 10 },
+            { Block::Paragraph, 35 },
+            { Block::Blockquote, this->settings.blockquoteDepth > 0 ? 10 : 0 },
+            { Block::List, this->settings.listDepth > 0 ? 15 : 0 },
+            { Block::Code, 10 },
+            { Block::Line, 5 },
+            { Block::Table, this->settings.tableRows > 0 && this->settings.tableColumns > 0 ? 10 : 0 },
+            { Block::Reference, 5 }
+        };
+
+        size_t total = 0;
+        for (auto& weight : weights)
+        {
+            if (std::find(blocks.begin(), blocks.end(), weight.first) == blocks.end())
+                weight.second = 0;
+            total += weight.second;
+        }
+
+        std::string result;
+        std::string definitions = this->references();
+        while (total > 0 && result.size() + definitions.size() < this->settings.size)
+        {
+            if (!result.empty())
+                result += "\n\n";
+
+            size_t pick = this->number(0, total - 1);
+            Block block = weights.front().first;
+            for (const auto& weight : weights)
+            {
+                if (pick < weight.second)
+                {
+                    block = weight.first;
+                    break;
+                }
+                pick -= weight.second;
+            }
+
+            switch (block)
+            {
+            case Block::Heading: result += this->heading(); break;
+            case Block::Paragraph: result += this->paragraph(this->number(1, this->settings.paragraphLength)); break;
+            case Block::Blockquote: result += this->blockquote(this->number(1, this->settings.blockquoteDepth)); break;
+            case Block::List: result += this->list(this->number(1, this->settings.listDepth), ""); break;
+            case Block::Code: result += this->code(); break;
+            case Block::Line: result += this->line(); break;
+            case Block::Table: result += this->table(); break;
+            case Block::Reference: result += this->definition(); break;
+            }
+        }
+
+        if (!definitions.empty())
+            result += (result.empty() ? "" : "\n\n") + definitions;
+        return result;
+    }
+
+    std::string CorpusGenerator::generate(const Settings& settings)
+    {
+        return CorpusGenerator(settings).generate();
+    }
+
+    std::string CorpusGenerator::generate(const Settings& settings, const std::vector<Block>& blocks)
+    {
+        return CorpusGenerator(settings).generate(blocks);
+    }
+
+    size_t CorpusGenerator::number(size_t min, size_t max)
+    {
+        // Reduce the raw 32-bit output ourselves: the standard distributions
+        // are implementation-defined, so a seed would give other corpora
+        // with another standard library
+        uint64_t range = static_cast<uint64_t>(max - min) + 1;
+        return min + static_cast<size_t>((static_cast<uint64_t>(this->random()) * range) >> 32);
+    }
+
+    bool CorpusGenerator::chance(double probability)
+    {
+        return this->random() < probability * 4294967296.0;
+    }
+
+    std::string CorpusGenerator::word()
+    {
+        return vocabulary[this->number(0, std::size(vocabulary) - 1)];
+    }
+
+    std::string CorpusGenerator::styledWord()
+    {
+        std::string word = this->word();
+
+        if (this->chance(this->settings.escapeDensity))
+        {
+            char c = escapable[this->number(0, std::size(escapable) - 1)];
+            return this->chance(0.5) ? std::string("\\") + c + word : word + '\\' + c;
+        }
+
+        if (!this->chance(this->settings.markerDensity))
+            return word;
+
+        std::string reference = this->settings.referenceCount > 0
+            ? "[ref" + std::to_string(this->number(0, this->settings.referenceCount - 1)) + "]"
+            : "(" + this->url() + ")";
+
+        switch (this->number(0, 8))
+        {
+        case 0: return '*' + word + '*';
+        case 1: return "**" + word + "**";
+        case 2: return "***" + word + "***";
+        case 3: return '`' + word + '`';
+        case 4: return "``" + word + " ` " + word + "``";
+        case 5: return '[' + word + "](" + this->url() + ')';
+        case 6: return '[' + word + ']' + reference;
+        case 7: return "![" + word + "](" + this->url() + ')';
+        default: return "![" + word + ']' + reference;
+        }
+    }
+
+    std::string CorpusGenerator::words(size_t count)
+    {
+        std::string result;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i > 0)
+                result += ' ';
+            result += this->styledWord();
+        }
+        return result;
+    }
+
+    std::string CorpusGenerator::textLine(size_t count)
+    {
+        // Emphasis at the start of a line would be taken for a list item
+        std::string result = this->word();
+        if (count > 1)
+            result += ' ' + this->words(count - 1);
+        return result;
+    }
+
+    std::string CorpusGenerator::url()
+    {
+        return "https://example.com/" + this->word() + "/" + std::to_string(this->number(1, 1000));
+    }
+
+    std::string CorpusGenerator::heading()
+    {
+        if (this->chance(0.25))
+            return this->textLine(this->number(1, 8)) + '\n' + (this->chance(0.5) ? "===" : "---");
+        return std::string(this->number(1, 6), '#') + ' ' + this->words(this->number(1, 8));
+    }
+
+    std::string CorpusGenerator::paragraph(size_t words)
+    {
+        std::string result;
+        while (words > 0)
+        {
+            size_t count = std::min(words, wordsPerLine);
+            if (!result.empty())
+                result += '\n';
+            result += this->textLine(count);
+            words -= count;
+        }
+        return result;
+    }
+
+    std::string CorpusGenerator::blockquote(size_t depth)
+    {
+        std::string content = this->paragraph(this->number(1, this->settings.paragraphLength));
+        if (depth > 1)
+            content += "\n\n" + this->blockquote(depth - 1);
+        else if (this->settings.listDepth > 0 && this->chance(0.3))
+            content += "\n\n" + this->list(1, "");
+
+        return prefixLines(content, "> ", ">");
+    }
+
+    std::string CorpusGenerator::list(size_t depth, const std::string& indent)
+    {
+        bool ordered = this->chance(0.3);
+        size_t items = this->number(2, 6);
+
+        std::string result;
+        for (size_t i = 0; i < items; i++)
+        {
+            if (i > 0)
+                result += '\n';
+
+            result += indent + (ordered ? std::to_string(i + 1) + ". " : "* ");
+            result += this->words(this->number(1, wordsPerLine));
+
+            if (depth > 1 && this->chance(0.4))
+                result += '\n' + this->list(depth - 1, indent + "    ");
+        }
+        return result;
+    }
+
+    std::string CorpusGenerator::code()
+    {
+        size_t lines = this->number(1, 12);
+        std::string body;
+        for (size_t i = 0; i < lines; i++)
+        {
+            if (i > 0)
+                body += '\n';
+            body += std::string(this->number(0, 2) * 4, ' ') + "if (" + this->word() + " < " + std::to_string(i) + " && *p) { " + this->word() + "(); }";
+        }
+
+        switch (this->number(0, 2))
+        {
+        case 0: return prefixLines(body, "    ", "");
+        case 1: return "```" + std::string(this->chance(0.5) ? "cpp" : "") + '\n' + body + "\n```";
+        default: return "~~~\n" + body + "\n~~~";
+        }
+    }
+
+    std::string CorpusGenerator::line()
+    {
+        const char characters[] = { '-', '*', '_' };
+        return std::string(this->number(3, 12), characters[this->number(0, std::size(characters) - 1)]);
+    }
+
+    std::string CorpusGenerator::table()
+    {
+        // Rows without pipes wouldn't be parsed as a table
+        size_t columns = std::max<size_t>(this->settings.tableColumns, 2);
+
+        std::string result;
+        for (size_t row = 0; row < this->settings.tableRows + 2; row++)
+        {
+            if (row > 0)
+                result += '\n';
+
+            for (size_t column = 0; column < columns; column++)
+            {
+                if (column > 0)
+                    result += '|';
+                result += row == 1 ? std::string(this->number(1, 5), '-') : this->words(this->number(1, 3));
+            }
+        }
+        return result;
+    }
+
+    std::string CorpusGenerator::definition()
+    {
+        // Ids never match the ref<n> ids used by the links
+        return "[" + this->word() + std::to_string(this->number(0, 100000)) + "]: " + this->url();
+    }
+
+    std::string CorpusGenerator::references()
+    {
+        std::string result;
+        for (size_t i = 0; i < this->settings.referenceCount; i++)
+        {
+            if (i > 0)
+                result += '\n';
+
+            result += "[ref" + std::to_string(i) + "]: " + this->url();
+            if (this->chance(0.5))
+                result += " \"" + this->word() + "\"";
+        }
+        return result;
+    }
+}
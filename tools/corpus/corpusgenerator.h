@@ -0,0 +1,71 @@
+#ifndef _h_cppmarkdowncorpusgenerator
+#define _h_cppmarkdowncorpusgenerator
+
+#include <string>
+#include <vector>
+#include <random>
+
+namespace Tools
+{
+    // Deterministic Markdown documents of a controlled size and shape, used to chart how parsing scales
+    // The same settings always give the same document, whatever the standard library
+    class CorpusGenerator
+    {
+    public:
+        enum class Block { Heading, Paragraph, Blockquote, List, Code, Line, Table, Reference };
+
+        struct Settings
+        {
+            unsigned int seed = 1;
+            size_t size = 64 * 1024; // Bytes of the document, the last block may exceed it
+            size_t paragraphLength = 40; // Words of a paragraph
+            size_t listDepth = 3; // Deepest nesting of lists
+            size_t blockquoteDepth = 2; // Deepest nesting of blockquotes
+            size_t tableRows = 6;
+            size_t tableColumns = 4;
+            double markerDensity = 0.1; // Share of words with inline markers - emphasis, code, links and images
+            double escapeDensity = 0.02; // Share of words with backslash escapes
+            size_t referenceCount = 8; // Reference definitions, used by reference-style links and images
+
+            // Set a knob by its name, e.g. from the command line - returns false for an unknown knob
+            bool set(const std::string& knob, const std::string& value);
+        };
+
+    public:
+        CorpusGenerator(const Settings& settings);
+
+        // Blocks of every element type, followed by the reference definitions
+        std::string generate();
+        // Blocks of the given types only, in their usual proportions
+        // Reference blocks are definitions not used by the links, the usual definitions still follow the blocks
+        std::string generate(const std::vector<Block>& blocks);
+
+        static std::string generate(const Settings& settings);
+        static std::string generate(const Settings& settings, const std::vector<Block>& blocks);
+
+    private:
+        Settings settings;
+        std::mt19937 random;
+
+        size_t number(size_t min, size_t max);
+        bool chance(double probability);
+
+        std::string word();
+        std::string styledWord();
+        std::string words(size_t count);
+        std::string textLine(size_t count);
+        std::string url();
+
+        std::string heading();
+        std::string paragraph(size_t words);
+        std::string blockquote(size_t depth);
+        std::string list(size_t depth, const std::string& indent);
+        std::string code();
+        std::string line();
+        std::string table();
+        std::string definition();
+        std::string references();
+    };
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include "corpusgenerator.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char** argv)
+{
+    Tools::CorpusGenerator::Settings settings;
+    std::string output;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        bool valid = argument.rfind("--", 0) == 0 && i + 1 < argc;
+        if (valid)
+        {
+            std::string knob = argument.substr(2);
+            std::string value = argv[++i];
+            try
+            {
+                if (knob == "output")
+                    output = value;
+                else
+                    valid = settings.set(knob, value);
+            }
+            catch (const std::logic_error&)
+            {
+                valid = false;
+            }
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Usage: " << argv[0] << " [--knob value]... [--output file.md]\n"
+                << "Knobs: seed, size, paragraphLength, listDepth, blockquoteDepth, tableRows, tableColumns,\n"
+                << "       markerDensity, escapeDensity, referenceCount\n";
+            return 1;
+        }
+    }
+
+    std::string markdown = Tools::CorpusGenerator::generate(settings);
+    if (output.empty())
+    {
+        std::cout << markdown << '\n';
+        return 0;
+    }
+
+    std::ofstream file(output, std::ios::binary);
+    if (!file)
+    {
+        std::cerr << "Cannot open " << output << "\n";
+        return 1;
+    }
+    file << markdown << '\n';
+    return 0;
+}